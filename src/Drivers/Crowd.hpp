@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+// -*- C++ -*-
+
+/**
+ * @file Crowd.hpp
+ * @brief Declaration of Crowd class
+ *
+ */
+
+#ifndef QMCPLUSPLUS_CROWD_HPP
+#define QMCPLUSPLUS_CROWD_HPP
+
+#include <Drivers/Mover.hpp>
+
+namespace qmcplusplus
+{
+/**
+ * @brief A group of movers advanced together by the multi_ functions
+ *
+ * Owns the walker lists, the masks and the scratch of the particle-by-particle
+ * moves, sized once for its movers, so the per-particle steps of a driver
+ * do not allocate. The lists of all the movers are fixed by setMovers,
+ * those of the movers with a valid move are refilled by filterValid.
+ */
+struct Crowd
+{
+  using RealType  = QMCTraits::RealType;
+  using PosType   = ParticleSet::PosType;
+  using GradType  = ParticleSet::GradType;
+  using ValueType = ParticleSet::ValueType;
+
+  /// movers and their particle sets, wavefunctions and orbitals
+  std::vector<Mover*> movers;
+  std::vector<ParticleSet*> P_list;
+  std::vector<WaveFunction*> WF_list;
+  std::vector<SPOSet*> spo_list;
+
+  /**@{ movers with a valid move of the active particle and their lists */
+  std::vector<Mover*> valid_movers;
+  std::vector<ParticleSet*> valid_P_list;
+  std::vector<WaveFunction*> valid_WF_list;
+  std::vector<SPOSet*> valid_spo_list;
+  /**@}*/
+
+  /// if true, the kernels of the crowd run on the calling thread, without a parallel region
+  bool serial;
+
+  /// isValid[iw] is 1, if the move of the iw-th mover is valid
+  std::vector<int> isValid;
+  /// isAccepted[iv] is true, if the move of the iv-th valid mover is accepted
+  std::vector<bool> isAccepted;
+
+  /**@{ per-mover temporaries of a move */
+  std::vector<PosType> delta;
+  std::vector<PosType> pos_list;
+  std::vector<GradType> grad_now;
+  std::vector<GradType> grad_new;
+  std::vector<ValueType> ratios;
+  /**@}*/
+
+  /**@{ draws of a substep, nels per mover, from the generators of the movers */
+  aligned_vector<RealType> substep_ur;
+  std::vector<PosType> substep_delta;
+  /**@}*/
+
+  /// scratch of the multi_ functions of the wavefunction
+  MultiWaveFunctionScratch wf_scratch;
+
+  /**@{ work list of the NLPP virtual moves
+   *
+   * The moves of all the movers are stored mover by mover, electron by
+   * electron in the order of a scalar NLPP evaluation. The moves of the
+   * electron jel of the mover iw are [nlpp_first[iw*(nels+1)+jel],
+   * nlpp_first[iw*(nels+1)+jel+1]). The orbitals are evaluated at
+   * nlpp_sorted_pos, the positions of the moves nlpp_order sorted by their
+   * keys nlpp_cell of SPOSet::cellIndex. The move m is of the electron
+   * nlpp_owner[m]%nels of the mover nlpp_owner[m]/nels, and nlpp_ratios[m]
+   * is its ratio.
+   */
+  std::vector<ParticleSet::ParticlePos_t> nlpp_knots;
+  std::vector<int> nlpp_first;
+  std::vector<PosType> nlpp_delta;
+  std::vector<PosType> nlpp_pos;
+  std::vector<int> nlpp_cell;
+  std::vector<int> nlpp_owner;
+  std::vector<int> nlpp_order;
+  std::vector<PosType> nlpp_sorted_pos;
+  std::vector<ValueType> nlpp_ratios;
+  /**@}*/
+
+  Crowd() : serial(false) {}
+
+  explicit Crowd(const std::vector<Mover*>& movers_in) : serial(false) { setMovers(movers_in); }
+
+  /// take the movers and size the lists and temporaries for them
+  void setMovers(const std::vector<Mover*>& movers_in)
+  {
+    movers = movers_in;
+    const int nw = movers.size();
+    P_list.resize(nw);
+    WF_list.resize(nw);
+    spo_list.resize(nw);
+    for (int iw = 0; iw < nw; iw++)
+    {
+      P_list[iw]   = &movers[iw]->els;
+      WF_list[iw]  = &movers[iw]->wavefunction;
+      spo_list[iw] = movers[iw]->spo;
+    }
+
+    valid_movers.reserve(nw);
+    valid_P_list.reserve(nw);
+    valid_WF_list.reserve(nw);
+    valid_spo_list.reserve(nw);
+    isValid.resize(nw);
+    isAccepted.reserve(nw);
+
+    delta.resize(nw);
+    pos_list.resize(nw);
+    grad_now.resize(nw);
+    grad_new.resize(nw);
+    ratios.resize(nw);
+
+    const int nels = nw > 0 ? movers[0]->els.getTotalNum() : 0;
+    substep_ur.resize(nw * nels);
+    substep_delta.resize(nw * nels);
+
+    nlpp_knots.resize(nw);
+  }
+
+  /// number of movers
+  inline int size() const { return movers.size(); }
+
+  /** draw the numbers of a substep, each mover on the stream of its walker
+   * @param mc index of the step
+   * @param l index of the substep
+   *
+   * A mover draws as a single walker does, the uniforms of the acceptance
+   * and the normals of the moves of all its electrons, from the counter
+   * (mc, l). The draws do not depend on the crowd of the mover nor on the
+   * threads serving it.
+   */
+  void drawSubstep(int mc, int l)
+  {
+    const int nw   = movers.size();
+    const int nels = nw > 0 ? substep_ur.size() / nw : 0;
+    crowd_for(serial, nw, [&](int iw) {
+      auto& rng = movers[iw]->rng;
+      rng.setCounter(mc, l);
+      rng.generate_uniform(substep_ur.data() + iw * nels, nels);
+      rng.generate_normal(&substep_delta[iw * nels][0], 3 * nels);
+    });
+  }
+
+  /// refill the lists of the valid movers from isValid
+  void filterValid()
+  {
+    valid_movers.clear();
+    valid_P_list.clear();
+    valid_WF_list.clear();
+    valid_spo_list.clear();
+    for (int iw = 0; iw < movers.size(); iw++)
+      if (isValid[iw])
+      {
+        valid_movers.push_back(movers[iw]);
+        valid_P_list.push_back(P_list[iw]);
+        valid_WF_list.push_back(WF_list[iw]);
+        valid_spo_list.push_back(spo_list[iw]);
+      }
+    isAccepted.resize(valid_movers.size());
+  }
+};
+
+} // namespace qmcplusplus
+
+#endif
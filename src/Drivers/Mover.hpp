@@ -28,6 +28,7 @@
 #include <Particle/ParticleSet.h>
 #include "QMCWaveFunctions/SPOSet.h"
 #include <QMCWaveFunctions/WaveFunction.h>
+#include <QMCWaveFunctions/StaticWaveFunction.h>
 #include <Particle/ParticleSet_builder.hpp>
 #include <Input/pseudo.hpp>
 
@@ -42,8 +43,11 @@ namespace qmcplusplus
    * handle a large amount of walkers.
    *
    * This class is used only by QMC drivers.
+   *
+   * @tparam WF wavefunction container, WaveFunction or a StaticWaveFunction
    */
-struct Mover
+template<class WF>
+struct MoverT
 {
   using RealType = QMCTraits::RealType;
 
@@ -54,24 +58,49 @@ struct Mover
   /// single particle orbitals
   SPOSet* spo;
   /// wavefunction container
-  WaveFunction wavefunction;
+  WF wavefunction;
   /// non-local pseudo-potentials
   NonLocalPP<RealType> nlpp;
 
-  /// constructor
-  Mover(const uint32_t myPrime, const ParticleSet& ions) : spo(nullptr), rng(myPrime), nlpp(rng)
+  /** constructor
+   * @param seed seed of the run
+   * @param walker_id ID of the walker, the stream of the generator
+   * @param ions ions of the electrons
+   */
+  MoverT(const uint32_t seed, int walker_id, const ParticleSet& ions)
+      : spo(nullptr), rng(seed, walker_id), nlpp(rng)
   {
+    rng.setCounter(RandomInitStep, RandomInitElectrons);
     build_els(els, ions, rng);
   }
 
+  /** start the walker walker_id in this mover
+   * @param seed seed of the run
+   * @param walker_id ID of the walker
+   *
+   * The electrons are placed as by the constructor of a mover of the walker,
+   * whatever the stream of this mover, and the wavefunction is recomputed.
+   */
+  void startWalker(const uint32_t seed, int walker_id)
+  {
+    RandomGenerator<RealType> walker_rng(seed, walker_id);
+    walker_rng.setCounter(RandomInitStep, RandomInitElectrons);
+    random_els(els, walker_rng);
+    els.update();
+    wavefunction.evaluateLog(els);
+  }
+
   /// destructor
-  ~Mover()
+  ~MoverT()
   {
     if (spo != nullptr)
       delete spo;
   }
 };
 
+/// Mover over the dynamic wavefunction container
+using Mover = MoverT<WaveFunction>;
+
 template<class T, typename TBOOL>
 const std::vector<T*>
     filtered_list(const std::vector<T*>& input_list, const std::vector<TBOOL>& chosen)
@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+// -*- C++ -*-
+/** @file check_random.cpp
+ * @brief Miniapp to check the random number generators.
+ *
+ * PhiloxRandom is checked against the known-answer vectors of Random123,
+ * and the bulk generate_uniform of the generators against as many calls of
+ * rand, from partially used blocks and across the chunks of the bulk path.
+ * The normals of generate_normal, transformed by BoxMuller2 in bulk, are
+ * checked against the transform of one pair of uniforms at a time.
+ */
+#include <Utilities/Configuration.h>
+#include <Utilities/Communicate.h>
+#include <Utilities/RandomGenerator.h>
+#include <Utilities/PhiloxRandom.h>
+#include <Utilities/StdRandom.h>
+#include <Utilities/qmcpack_version.h>
+#include <getopt.h>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace qmcplusplus;
+
+void print_help()
+{
+  // clang-format off
+  app_summary() << "usage:" << '\n';
+  app_summary() << "  check_random [-hvV] [-s seed]"                             << '\n';
+  app_summary() << "options:"                                                    << '\n';
+  app_summary() << "  -h  print help and exit"                                   << '\n';
+  app_summary() << "  -s  set the random seed.           default: 11"            << '\n';
+  app_summary() << "  -v  verbose output"                                        << '\n';
+  app_summary() << "  -V  print version information and exit"                    << '\n';
+  // clang-format on
+
+  exit(1); // print help and exit
+}
+
+/** return the number of the mismatches of the Philox4x32-10 known-answer vectors
+ *
+ * Each vector is the key, the counter and the block, from the kat_vectors of
+ * Random123.
+ */
+int check_philox_kat()
+{
+  // clang-format off
+  const uint32_t kat[3][10] = {
+    {0x00000000, 0x00000000,
+     0x00000000, 0x00000000, 0x00000000, 0x00000000,
+     0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+    {0xffffffff, 0xffffffff,
+     0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+     0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+    {0xa4093822, 0x299f31d0,
+     0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344,
+     0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+  // clang-format on
+
+  int nfail = 0;
+  for (int v = 0; v < 3; v++)
+  {
+    PhiloxRandom<double> rng;
+    rng.key[0] = kat[v][0];
+    rng.key[1] = kat[v][1];
+    rng.setCounter(kat[v][4], kat[v][5]);
+    uint32_t x[4];
+    rng.philox((static_cast<uint64_t>(kat[v][3]) << 32) | kat[v][2], x);
+    for (int q = 0; q < 4; q++)
+      if (x[q] != kat[v][6 + q])
+      {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "word %d = %08x, expected %08x", q, x[q], kat[v][6 + q]);
+        cout << "Fail in the known-answer vector " << v << ", " << msg << std::endl;
+        nfail++;
+      }
+  }
+  return nfail;
+}
+
+/** return the number of the mismatches of generate_uniform and rand
+ * @param name name of the generator in the messages
+ * @param iseed seed of the generators
+ *
+ * Two generators start from the same stream and counter. After nskip calls
+ * of rand on both, the one draws n numbers by generate_uniform and the other
+ * by n calls of rand. The sizes cover whole and partial blocks and chunks.
+ */
+template<typename RNG>
+int check_bulk_uniform(const char* name, uint32_t iseed)
+{
+  using T = typename RNG::result_type;
+  // 64 blocks of up to 4 numbers in a chunk of PhiloxRandom
+  const int sizes[] = {0, 1, 2, 3, 5, 255, 256, 257, 511, 513, 1000};
+
+  int nfail = 0;
+  for (int nskip = 0; nskip < 4; nskip++)
+    for (int n : sizes)
+    {
+      RNG bulk(iseed, 3), scalar(iseed, 3);
+      bulk.setCounter(2, 9);
+      scalar.setCounter(2, 9);
+      for (int i = 0; i < nskip; i++)
+      {
+        bulk.rand();
+        scalar.rand();
+      }
+
+      // the draws after the series check that the streams are left at the same place
+      std::vector<T> a(n + 1), b(n + 1);
+      bulk.generate_uniform(a.data(), n);
+      a[n] = bulk.rand();
+      for (int i = 0; i <= n; i++)
+        b[i] = scalar.rand();
+
+      int nbad = 0;
+      for (int i = 0; i <= n; i++)
+        nbad += (a[i] != b[i]);
+      if (nbad > 0)
+      {
+        cout << "Fail in " << name << "::generate_uniform after " << nskip << " calls of rand, "
+             << nbad << " of " << n + 1 << " numbers differ" << std::endl;
+        nfail++;
+      }
+    }
+  return nfail;
+}
+
+/** return the number of the mismatches of generate_normal and the pairwise transform
+ * @param name name of the generator in the messages
+ * @param iseed seed of the generators
+ * @param tol tolerance of the normals, relative to their magnitude above 1
+ *
+ * Two generators start from the same stream and counter. The one draws n
+ * normals by generate_normal and the other transforms the uniforms of two
+ * calls of rand at a time, as BoxMuller2 does for the odd normal. The sizes
+ * cover odd counts and several chunks of pairs.
+ */
+template<typename RNG>
+int check_bulk_normal(const char* name, uint32_t iseed, typename RNG::result_type tol)
+{
+  using T = typename RNG::result_type;
+  const int sizes[] = {0, 1, 2, 3, 127, 128, 129, 255, 1000, 1001};
+
+  int nfail = 0;
+  for (int n : sizes)
+  {
+    RNG bulk(iseed, 5), scalar(iseed, 5);
+    bulk.setCounter(4, 1);
+    scalar.setCounter(4, 1);
+
+    // the draws after the series check that the streams are left at the same place
+    std::vector<T> a(n + 1), b(n + 1);
+    bulk.generate_normal(a.data(), n);
+    a[n] = bulk.rand();
+    for (int i = 0; i < n; i += 2)
+    {
+      const T u1 = scalar.rand(), u2 = scalar.rand();
+      const T r  = std::sqrt(T(-2) * std::log(T(1) - T(0.9999999999) * u1));
+      b[i]       = r * std::cos(T(6.283185306) * u2);
+      if (i + 1 < n)
+        b[i + 1] = r * std::sin(T(6.283185306) * u2);
+    }
+    b[n] = scalar.rand();
+
+    int nbad    = 0;
+    T max_error = 0;
+    for (int i = 0; i < n; i++)
+    {
+      const T error = std::abs(a[i] - b[i]) / std::max(T(1), std::abs(b[i]));
+      max_error     = std::max(max_error, error);
+      nbad += (error > tol);
+    }
+    nbad += (a[n] != b[n]);
+    if (nbad > 0)
+    {
+      cout << "Fail in " << name << "::generate_normal of " << n << " normals, " << nbad << " of "
+           << n + 1 << " numbers differ, error = " << max_error << std::endl;
+      nfail++;
+    }
+  }
+  return nfail;
+}
+
+int main(int argc, char** argv)
+{
+  Communicate comm(argc, argv);
+
+  int iseed = 11;
+
+  bool verbose = false;
+
+  if (!comm.root())
+  {
+    outputManager.shutOff();
+  }
+
+  int opt;
+  while (optind < argc)
+  {
+    if ((opt = getopt(argc, argv, "hvVs:")) != -1)
+    {
+      switch (opt)
+      {
+      case 'h':
+        print_help();
+        break;
+      case 's':
+        iseed = atoi(optarg);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      case 'V':
+        print_version(true);
+        return 1;
+        break;
+      default:
+        print_help();
+      }
+    }
+    else // disallow non-option arguments
+    {
+      app_error() << "Non-option arguments not allowed" << endl;
+      print_help();
+    }
+  }
+
+  if (comm.root())
+  {
+    if (verbose)
+      outputManager.setVerbosity(Verbosity::HIGH);
+    else
+      outputManager.setVerbosity(Verbosity::LOW);
+  }
+
+  print_version(verbose);
+
+  int nfail = check_philox_kat();
+  nfail += check_bulk_uniform<PhiloxRandom<float>>("PhiloxRandom<float>", iseed);
+  nfail += check_bulk_uniform<PhiloxRandom<double>>("PhiloxRandom<double>", iseed);
+  nfail += check_bulk_uniform<StdRandom<float>>("StdRandom<float>", iseed);
+  nfail += check_bulk_uniform<StdRandom<double>>("StdRandom<double>", iseed);
+  nfail += check_bulk_normal<PhiloxRandom<float>>("PhiloxRandom<float>", iseed, 2e-6f);
+  nfail += check_bulk_normal<PhiloxRandom<double>>("PhiloxRandom<double>", iseed, 1e-14);
+  nfail += check_bulk_normal<StdRandom<float>>("StdRandom<float>", iseed, 2e-6f);
+  nfail += check_bulk_normal<StdRandom<double>>("StdRandom<double>", iseed, 1e-14);
+  comm.reduce(nfail);
+
+  if (nfail == 0)
+    cout << "All checks passed for random" << std::endl;
+
+  return nfail == 0 ? 0 : 1;
+}
@@ -192,14 +192,17 @@ int main(int argc, char** argv)
   double nspheremoves = 0;
   double dNumVGHCalls = 0;
 
-  double evalV_v_err   = 0.0;
-  double evalVGH_v_err = 0.0;
+  double evalV_v_err       = 0.0;
+  double evalVbatch_v_err  = 0.0;
+  double evalVbatch_rv_err = 0.0;
+  double evalVGH_v_err     = 0.0;
   double evalVGH_g_err = 0.0;
   double evalVGH_h_err = 0.0;
 
   // clang-format off
   #pragma omp parallel reduction(+:ratio,nspheremoves,dNumVGHCalls) \
-   reduction(+:evalV_v_err,evalVGH_v_err,evalVGH_g_err,evalVGH_h_err)
+   reduction(+:evalV_v_err,evalVbatch_v_err,evalVbatch_rv_err) \
+   reduction(+:evalVGH_v_err,evalVGH_g_err,evalVGH_h_err)
   // clang-format on
   {
     const int np        = omp_get_num_threads();
@@ -233,6 +236,11 @@ int main(int argc, char** argv)
     ParticlePos_t delta(nels);
     ParticlePos_t rOnSphere(nknots);
 
+    // the knots of a sphere and their values by evaluate_v_batch
+    std::vector<PosType> knots(nknots);
+    aligned_vector<QMCTraits::ValueType> batch_v(nknots * spo.size());
+    aligned_vector<QMCTraits::ValueType> batch_ref_v(nknots * spo_ref.size());
+
     RealType sqrttau = 2.0;
     RealType accept  = 0.5;
 
@@ -289,15 +297,25 @@ int main(int argc, char** argv)
 
         for (int nn = 0; nn < nnF; ++nn)
         {
+          for (int k = 0; k < nknots; k++)
+            knots[k] = centerP + r * rOnSphere[k];
+          spo.evaluate_v_batch(knots.data(), nknots, batch_v.data());
+          spo_ref.evaluate_v_batch(knots.data(), nknots, batch_ref_v.data());
+
           for (int k = 0; k < nknots; k++)
           {
-            PosType pos = centerP + r * rOnSphere[k];
+            const PosType& pos = knots[k];
             spo.evaluate_v(pos);
             spo_ref.evaluate_v(pos);
             // accumulate error
             for (int ib = 0; ib < spo.nBlocks; ib++)
               for (int n = 0; n < spo.nSplinesPerBlock; n++)
+              {
+                const int i = k * spo.size() + ib * spo.nSplinesPerBlock + n;
                 evalV_v_err += std::fabs(spo.psi[ib][n] - spo_ref.psi[ib][n]);
+                evalVbatch_v_err += std::fabs(batch_v[i] - spo.psi[ib][n]);
+                evalVbatch_rv_err += std::fabs(batch_ref_v[i] - spo_ref.psi[ib][n]);
+              }
           }
         } // els
       }   // ions
@@ -312,8 +330,10 @@ int main(int argc, char** argv)
 
   outputManager.resume();
 
-  evalV_v_err   /= nspheremoves;
-  evalVGH_v_err /= dNumVGHCalls;
+  evalV_v_err       /= nspheremoves;
+  evalVbatch_v_err  /= nspheremoves;
+  evalVbatch_rv_err /= nspheremoves;
+  evalVGH_v_err     /= dNumVGHCalls;
   evalVGH_g_err /= dNumVGHCalls;
   evalVGH_h_err /= dNumVGHCalls;
 
@@ -328,6 +348,17 @@ int main(int argc, char** argv)
     app_log() << "Fail in evaluate_v, V error =" << evalV_v_err / np << std::endl;
     nfail = 1;
   }
+  if (evalVbatch_v_err / np > small_v)
+  {
+    app_log() << "Fail in evaluate_v_batch, V error =" << evalVbatch_v_err / np << std::endl;
+    nfail += 1;
+  }
+  if (evalVbatch_rv_err / np > small_v)
+  {
+    app_log() << "Fail in evaluate_v_batch of the reference, V error =" << evalVbatch_rv_err / np
+              << std::endl;
+    nfail += 1;
+  }
   if (evalVGH_v_err / np > small_v)
   {
     app_log() << "Fail in evaluate_vgh, V error =" << evalVGH_v_err / np << std::endl;
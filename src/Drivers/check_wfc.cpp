@@ -18,6 +18,9 @@
 /** @file check_wfc.cpp
  * @brief Miniapp to check individual wave function component against its
  * reference.
+ *
+ * The crowd versions of the component are checked against its single-walker
+ * versions, as well as the round trip of its state through a walker buffer.
  */
 
 #include <Utilities/Configuration.h>
@@ -38,6 +41,8 @@
 #include <QMCWaveFunctions/Jastrow/TwoBodyJastrow.h>
 #include <Utilities/qmcpack_version.h>
 #include <getopt.h>
+#include <algorithm>
+#include <limits>
 
 using namespace std;
 using namespace qmcplusplus;
@@ -62,6 +67,233 @@ void print_help()
   exit(1); // print help and exit
 }
 
+/// return a new component wfc_name of els, which has its e-e table
+WaveFunctionComponentPtr build_wfc(const string& wfc_name, ParticleSet& ions, ParticleSet& els)
+{
+  typedef QMCTraits::RealType RealType;
+
+  WaveFunctionComponentPtr wfc = nullptr;
+  if (wfc_name == "J2")
+  {
+    TwoBodyJastrow<BsplineFunctor<RealType>>* J = new TwoBodyJastrow<BsplineFunctor<RealType>>(els);
+    buildJ2(*J, els.Lattice.WignerSeitzRadius);
+    wfc = dynamic_cast<WaveFunctionComponentPtr>(J);
+  }
+  else if (wfc_name == "J1")
+  {
+    OneBodyJastrow<BsplineFunctor<RealType>>* J =
+        new OneBodyJastrow<BsplineFunctor<RealType>>(ions, els);
+    buildJ1(*J, els.Lattice.WignerSeitzRadius);
+    wfc = dynamic_cast<WaveFunctionComponentPtr>(J);
+  }
+  else if (wfc_name == "JeeI" || wfc_name == "J3")
+  {
+    ThreeBodyJastrow<PolynomialFunctor3D>* J = new ThreeBodyJastrow<PolynomialFunctor3D>(ions, els);
+    buildJeeI(*J, els.Lattice.WignerSeitzRadius);
+    wfc = dynamic_cast<WaveFunctionComponentPtr>(J);
+  }
+  return wfc;
+}
+
+/** return the largest difference of the entries of two walker buffers
+ *
+ * The difference is relative to the entries of a larger than one. Buffers of
+ * different sizes differ by the largest double.
+ */
+double buffer_diff(const WaveFunctionComponent::BufferType& a,
+                   const WaveFunctionComponent::BufferType& b)
+{
+  if (a.size() != b.size())
+    return std::numeric_limits<double>::max();
+  double d = 0.0;
+  for (size_t i = 0; i < a.size(); i++)
+    d = std::max(d, std::abs(double(a[i]) - double(b[i])) / std::max(1.0, std::abs(double(a[i]))));
+  return d;
+}
+
+/** check the crowd versions of a component against its single-walker versions
+ * @param wfc_name name of the component
+ * @param ions ion particleset
+ * @param random_th generator of the walkers and of the moves
+ * @param serial if true, the calling thread evaluates the crowd
+ * @param ratio_err accumulated error of the ratios of multi_ratioGrad
+ * @param grad_err accumulated error of the gradients of multi_ratioGrad
+ * @param state_err largest error of the states left by multi_acceptrestoreMove
+ * @param buffer_err largest error of the round trip through the walker buffers
+ *
+ * Each walker of the crowd has two copies of the component: one moved by
+ * multi_ratioGrad and multi_acceptrestoreMove, the other by ratioGrad and
+ * acceptMove. After the sweep, their states, Uat, dUat and d2Uat included,
+ * are compared through their walker buffers. A third copy, registered before
+ * the sweep, is restored from the buffer of the crowd copy and must write the
+ * same buffer back and give the same evaluateGL.
+ */
+void check_crowd(const string& wfc_name,
+                 ParticleSet& ions,
+                 RandomGenerator<QMCTraits::RealType>& random_th,
+                 bool serial,
+                 double& ratio_err,
+                 double& grad_err,
+                 double& state_err,
+                 double& buffer_err)
+{
+  // clang-format off
+  typedef QMCTraits::RealType                 RealType;
+  typedef QMCTraits::ValueType                ValueType;
+  typedef ParticleSet::PosType                PosType;
+  typedef WaveFunctionComponent::BufferType   BufferType;
+  // clang-format on
+
+  constexpr int nw = 3;
+  constexpr RealType czero(0);
+  constexpr RealType sqrttau(2.0);
+
+  std::vector<ParticleSet*> P_crowd(nw), P_single(nw);
+  std::vector<WaveFunctionComponentPtr> crowd(nw), single(nw), restored(nw);
+  std::vector<BufferType> buffers(nw);
+  for (int iw = 0; iw < nw; iw++)
+  {
+    P_crowd[iw] = new ParticleSet;
+    build_els(*P_crowd[iw], ions, random_th);
+    P_single[iw]       = new ParticleSet(*P_crowd[iw]);
+    P_single[iw]->RSoA = P_single[iw]->R;
+    P_crowd[iw]->addTable(*P_crowd[iw], DT_SOA);
+    P_single[iw]->addTable(*P_single[iw], DT_SOA);
+    crowd[iw]    = build_wfc(wfc_name, ions, *P_crowd[iw]);
+    restored[iw] = build_wfc(wfc_name, ions, *P_crowd[iw]);
+    single[iw]   = build_wfc(wfc_name, ions, *P_single[iw]);
+    P_crowd[iw]->update();
+    P_single[iw]->update();
+
+    for (WaveFunctionComponentPtr wfc : {crowd[iw], restored[iw]})
+    {
+      P_crowd[iw]->G = czero;
+      P_crowd[iw]->L = czero;
+      wfc->evaluateLog(*P_crowd[iw], P_crowd[iw]->G, P_crowd[iw]->L);
+    }
+    P_single[iw]->G = czero;
+    P_single[iw]->L = czero;
+    single[iw]->evaluateLog(*P_single[iw], P_single[iw]->G, P_single[iw]->L);
+    // the layout is set by the state before the sweep
+    restored[iw]->registerData(*P_crowd[iw], buffers[iw]);
+  }
+
+  const int nels = P_crowd[0]->getTotalNum();
+  std::vector<PosType> delta(nw * nels);
+  std::vector<RealType> ur(nw * nels);
+  random_th.generate_normal(&delta[0][0], nw * nels * 3);
+  random_th.generate_uniform(ur.data(), nw * nels);
+
+  std::vector<ValueType> ratios;
+  std::vector<PosType> grad_new;
+  std::vector<bool> isAccepted;
+  std::vector<int> valid;
+  std::vector<WaveFunctionComponentPtr> valid_crowd;
+  std::vector<ParticleSet*> valid_P;
+  double r_ratio = 0.0;
+  double g_ratio = 0.0;
+  int nmoves     = 0;
+  for (int iel = 0; iel < nels; ++iel)
+  {
+    // the crowd versions see only the walkers with a valid move, as in the drivers
+    valid.clear();
+    valid_crowd.clear();
+    valid_P.clear();
+    for (int iw = 0; iw < nw; iw++)
+    {
+      const PosType dr = sqrttau * delta[iw * nels + iel];
+      P_crowd[iw]->setActive(iel);
+      P_single[iw]->setActive(iel);
+      P_single[iw]->makeMoveAndCheck(iel, dr);
+      if (P_crowd[iw]->makeMoveAndCheck(iel, dr))
+      {
+        valid.push_back(iw);
+        valid_crowd.push_back(crowd[iw]);
+        valid_P.push_back(P_crowd[iw]);
+      }
+    }
+    const int nvalid = valid.size();
+    if (nvalid == 0)
+      continue;
+    ratios.resize(nvalid);
+    grad_new.assign(nvalid, PosType(czero));
+    isAccepted.resize(nvalid);
+
+    crowd[0]->multi_ratioGrad(valid_crowd, valid_P, iel, ratios, grad_new, serial);
+    for (int iv = 0; iv < nvalid; iv++)
+    {
+      const int iw        = valid[iv];
+      PosType grad_single = czero;
+      ValueType r         = single[iw]->ratioGrad(*P_single[iw], iel, grad_single);
+      grad_single -= grad_new[iv];
+      g_ratio += sqrt(dot(grad_single, grad_single));
+      r_ratio += abs(ratios[iv] / r - 1);
+      nmoves++;
+
+      isAccepted[iv] = ur[iw * nels + iel] < r;
+      if (isAccepted[iv])
+      {
+        single[iw]->acceptMove(*P_single[iw], iel);
+        P_single[iw]->acceptMove(iel);
+      }
+      else
+        P_single[iw]->rejectMove(iel);
+    }
+
+    crowd[0]->multi_acceptrestoreMove(valid_crowd, valid_P, isAccepted, iel, serial);
+    for (int iv = 0; iv < nvalid; iv++)
+      if (isAccepted[iv])
+        valid_P[iv]->acceptMove(iel);
+      else
+        valid_P[iv]->rejectMove(iel);
+  }
+  ratio_err += r_ratio / std::max(nmoves, 1);
+  grad_err += g_ratio / std::max(nmoves, 1);
+
+  for (int iw = 0; iw < nw; iw++)
+  {
+    ParticleSet& P = *P_crowd[iw];
+    P.donePbyP();
+    P_single[iw]->donePbyP();
+
+    BufferType buf_crowd, buf_single;
+    crowd[iw]->registerData(P, buf_crowd);
+    single[iw]->registerData(*P_single[iw], buf_single);
+    state_err = std::max(state_err, buffer_diff(buf_crowd, buf_single));
+
+    // restore the crowd copy through the buffer registered before the sweep
+    buffers[iw].rewind();
+    crowd[iw]->copyToBuffer(P, buffers[iw]);
+    buffers[iw].rewind();
+    restored[iw]->copyFromBuffer(P, buffers[iw]);
+    BufferType buf_restored;
+    restored[iw]->registerData(P, buf_restored);
+    buffer_err = std::max(buffer_err, buffer_diff(buf_crowd, buf_restored));
+
+    P.G = czero;
+    P.L = czero;
+    crowd[iw]->evaluateGL(P, P.G, P.L);
+    ParticleSet::ParticleGradient_t G(P.G);
+    ParticleSet::ParticleLaplacian_t L(P.L);
+    P.G = czero;
+    P.L = czero;
+    restored[iw]->evaluateGL(P, P.G, P.L);
+    double gl_err = 0.0;
+    for (int iel = 0; iel < nels; ++iel)
+    {
+      PosType dr = G[iel] - P.G[iel];
+      gl_err += sqrt(dot(dr, dr)) + abs(L[iel] - P.L[iel]);
+    }
+    buffer_err = std::max(buffer_err, gl_err / nels);
+
+    delete crowd[iw];
+    delete single[iw];
+    delete restored[iw];
+    delete P_crowd[iw];
+    delete P_single[iw];
+  }
+}
+
 int main(int argc, char** argv)
 {
   // clang-format off
@@ -191,9 +423,7 @@ int main(int argc, char** argv)
     WaveFunctionComponentPtr wfc_ref = nullptr;
     if (wfc_name == "J2")
     {
-      TwoBodyJastrow<BsplineFunctor<RealType>>* J = new TwoBodyJastrow<BsplineFunctor<RealType>>(els);
-      buildJ2(*J, els.Lattice.WignerSeitzRadius);
-      wfc = dynamic_cast<WaveFunctionComponentPtr>(J);
+      wfc = build_wfc(wfc_name, ions, els);
       cout << "Built J2" << endl;
       miniqmcreference::TwoBodyJastrowRef<BsplineFunctor<RealType>>* J_ref =
           new miniqmcreference::TwoBodyJastrowRef<BsplineFunctor<RealType>>(els_ref);
@@ -203,10 +433,7 @@ int main(int argc, char** argv)
     }
     else if (wfc_name == "J1")
     {
-      OneBodyJastrow<BsplineFunctor<RealType>>* J =
-          new OneBodyJastrow<BsplineFunctor<RealType>>(ions, els);
-      buildJ1(*J, els.Lattice.WignerSeitzRadius);
-      wfc = dynamic_cast<WaveFunctionComponentPtr>(J);
+      wfc = build_wfc(wfc_name, ions, els);
       cout << "Built J1" << endl;
       miniqmcreference::OneBodyJastrowRef<BsplineFunctor<RealType>>* J_ref =
           new miniqmcreference::OneBodyJastrowRef<BsplineFunctor<RealType>>(ions, els_ref);
@@ -216,9 +443,7 @@ int main(int argc, char** argv)
     }
     else if (wfc_name == "JeeI" || wfc_name == "J3")
     {
-      ThreeBodyJastrow<PolynomialFunctor3D>* J = new ThreeBodyJastrow<PolynomialFunctor3D>(ions, els);
-      buildJeeI(*J, els.Lattice.WignerSeitzRadius);
-      wfc = dynamic_cast<WaveFunctionComponentPtr>(J);
+      wfc = build_wfc(wfc_name, ions, els);
       cout << "Built JeeI" << endl;
       miniqmcreference::ThreeBodyJastrowRef<PolynomialFunctor3D>* J_ref =
           new miniqmcreference::ThreeBodyJastrowRef<PolynomialFunctor3D>(ions, els_ref);
@@ -388,7 +613,30 @@ int main(int argc, char** argv)
     }
   } // end of omp parallel
 
-  int np                   = omp_get_max_threads();
+  int np = omp_get_max_threads();
+
+  // crowd versions, with the walkers split over the threads and on the calling thread
+  double multi_ratio_err = 0.0;
+  double multi_grad_err  = 0.0;
+  double multi_state_err = 0.0;
+  double buffer_err      = 0.0;
+  {
+    RandomGenerator<RealType> random_crowd(myPrimes[np]);
+    for (bool serial : {false, true})
+      check_crowd(wfc_name,
+                  ions,
+                  random_crowd,
+                  serial,
+                  multi_ratio_err,
+                  multi_grad_err,
+                  multi_state_err,
+                  buffer_err);
+    cout << "multi_ratioGrad::G     Error = " << multi_grad_err / 2 << endl;
+    cout << "multi_ratioGrad::Ratio Error = " << multi_ratio_err / 2 << endl;
+    cout << "multi_acceptrestoreMove::State Error = " << multi_state_err << endl;
+    cout << "Buffer round trip Error = " << buffer_err << endl;
+  }
+
   constexpr RealType small = std::numeric_limits<RealType>::epsilon() * 1e4;
   bool fail                = false;
   cout << std::endl;
@@ -444,6 +692,33 @@ int main(int argc, char** argv)
     cout << "Fail in ratio, ratio error =" << ratio_err / np << " for " << wfc_name << std::endl;
     fail = true;
   }
+  if (multi_ratio_err / 2 > small)
+  {
+    cout << "Fail in multi_ratioGrad, ratio error =" << multi_ratio_err / 2 << " for " << wfc_name
+         << std::endl;
+    fail = true;
+  }
+  if (multi_grad_err / 2 > small)
+  {
+    cout << "Fail in multi_ratioGrad, G error =" << multi_grad_err / 2 << " for " << wfc_name
+         << std::endl;
+    fail = true;
+  }
+  // the states accumulate the products with the distances over the sweep
+  const double state_small =
+      std::max<double>(small, std::numeric_limits<DistanceTableData::DistRealType>::epsilon() * 1e2);
+  if (multi_state_err > state_small)
+  {
+    cout << "Fail in multi_acceptrestoreMove, state error =" << multi_state_err << " for "
+         << wfc_name << std::endl;
+    fail = true;
+  }
+  if (buffer_err > small)
+  {
+    cout << "Fail in the buffer round trip, error =" << buffer_err << " for " << wfc_name
+         << std::endl;
+    fail = true;
+  }
   if (!fail)
     cout << "All checks passed for " << wfc_name << std::endl;
 
@@ -106,7 +106,6 @@
 #include <Utilities/Communicate.h>
 #include <Particle/ParticleSet.h>
 #include <Particle/DistanceTable.h>
-#include <Utilities/PrimeNumberSet.h>
 #include <Utilities/NewTimer.h>
 #include <Utilities/XMLWriter.h>
 #include <Utilities/RandomGenerator.h>
@@ -117,6 +116,7 @@
 #include <QMCWaveFunctions/WaveFunction.h>
 #include <Drivers/Mover.hpp>
 #include <getopt.h>
+#include <iomanip>
 
 using namespace std;
 using namespace qmcplusplus;
@@ -131,6 +131,8 @@ enum MiniQMCTimers
   Timer_evalGrad,
   Timer_ratioGrad,
   Timer_Update,
+  Timer_Reorder,
+  Timer_Swap,
 };
 
 TimerNameList_t<MiniQMCTimers> MiniQMCTimerNames = {
@@ -142,33 +144,506 @@ TimerNameList_t<MiniQMCTimers> MiniQMCTimerNames = {
     {Timer_evalGrad, "Current Gradient"},
     {Timer_ratioGrad, "New Gradient"},
     {Timer_Update, "Update"},
+    {Timer_Reorder, "Reorder"},
+    {Timer_Swap, "Walker Swap"},
 };
 
 void print_help()
 {
   // clang-format off
   app_summary() << "usage:" << '\n';
-  app_summary() << "  miniqmc   [-hjvV] [-g \"n0 n1 n2\"] [-m meshfactor]"       << '\n';
+  app_summary() << "  miniqmc   [-dfGhjTvV] [-g \"n0 n1 n2\"] [-m meshfactor]"      << '\n';
   app_summary() << "            [-n steps] [-N substeps] [-r rmax] [-s seed]"    << '\n';
   app_summary() << "            [-w walkers] [-a tile_size] [-t timer_level]"    << '\n';
+  app_summary() << "            [-o reorder_interval] [-c team_size]"            << '\n';
+  app_summary() << "            [-W pool_walkers]"                               << '\n';
   app_summary() << "options:"                                                    << '\n';
   app_summary() << "  -a  size of each spline tile       default: num of orbs"   << '\n';
   app_summary() << "  -b  use reference implementations  default: off"           << '\n';
+  app_summary() << "  -c  number of threads per walker   default: 1"             << '\n';
+  app_summary() << "  -d  static-dispatch wavefunction   default: off"           << '\n';
+  app_summary() << "  -f  fuse the Jastrow factors       default: off"           << '\n';
   app_summary() << "  -g  set the 3D tiling.             default: 1 1 1"         << '\n';
+  app_summary() << "  -G  task graph of the step phases  default: off"           << '\n';
   app_summary() << "  -h  print help and exit"                                   << '\n';
   app_summary() << "  -j  enable three body Jastrow      default: off"           << '\n';
   app_summary() << "  -m  meshfactor                     default: 1.0"           << '\n';
   app_summary() << "  -n  number of MC steps             default: 5"             << '\n';
   app_summary() << "  -N  number of MC substeps          default: 1"             << '\n';
+  app_summary() << "  -o  Morton reorder every o steps   default: 0 (off)"       << '\n';
   app_summary() << "  -r  set the Rmax.                  default: 1.7"           << '\n';
   app_summary() << "  -s  set the random seed.           default: 11"            << '\n';
   app_summary() << "  -t  timer level: coarse or fine    default: fine"          << '\n';
+  app_summary() << "  -T  walkers as tasks of each step  default: off"           << '\n';
   app_summary() << "  -w  number of walker(movers)       default: num of threads"<< '\n';
+  app_summary() << "  -W  walkers swapped through movers default: 0 (off)"       << '\n';
   app_summary() << "  -v  verbose output"                                        << '\n';
   app_summary() << "  -V  print version information and exit"                    << '\n';
   // clang-format on
 }
 
+/// settings of the mover loops, from the command line
+struct MoverSettings
+{
+  int nmovers;
+  int nwalkers;
+  int nsteps;
+  int nsubsteps;
+  int team_size;
+  int reorder_interval;
+  QMCTraits::RealType Rmax;
+  uint32_t iseed;
+  bool useRef;
+  bool enableJ3;
+  bool fuseJas;
+  bool useTasks;
+  bool useGraph;
+};
+
+/// times of a thread in the walkers, on a cache line of its own
+struct alignas(QMC_CLINE) ThreadTimes
+{
+  /// time in the walkers
+  double busy = 0.0;
+  /// time of the walker loads of the pool
+  double load = 0.0;
+  /// time of the walker saves of the pool
+  double save = 0.0;
+};
+
+/** drift-and-diffusion sweep of the walker of a mover, with evaluateGL
+ * @param mover mover holding the walker
+ * @param mc index of the step
+ * @return the number of the accepted moves
+ *
+ * The draws of each substep restart the generator of the walker at (mc, l).
+ */
+template<class WF>
+int diffuse_mover(MoverT<WF>& mover, int mc, const MoverSettings& settings, TimerList_t& Timers)
+{
+  // clang-format off
+  typedef QMCTraits::RealType           RealType;
+  typedef ParticleSet::ParticlePos_t    ParticlePos_t;
+  typedef ParticleSet::PosType          PosType;
+  // clang-format on
+
+  const int nsubsteps = settings.nsubsteps;
+
+  auto& els          = mover.els;
+  auto& spo          = *mover.spo;
+  auto& random_th    = mover.rng;
+  auto& wavefunction = mover.wavefunction;
+
+  const int nels  = els.getTotalNum();
+  const int nels3 = 3 * nels;
+
+  // For VMC, tau is large and should result in an acceptance ratio of roughly
+  // 50%
+  // For DMC, tau is small and should result in an acceptance ratio of 99%
+  const RealType tau = 2.0;
+
+  RealType sqrttau = std::sqrt(tau);
+  RealType accept  = 0.5;
+
+  ParticlePos_t delta(nels);
+
+  aligned_vector<RealType> ur(nels);
+
+  int my_accepted = 0;
+  Timers[Timer_Diffusion]->start();
+  for (int l = 0; l < nsubsteps; ++l) // drift-and-diffusion
+  {
+    random_th.setCounter(mc, l);
+    random_th.generate_uniform(ur.data(), nels);
+    random_th.generate_normal(&delta[0][0], nels3);
+    for (int iel = 0; iel < nels; ++iel)
+    {
+      // Operate on electron with index iel
+      els.setActive(iel);
+      // Compute gradient at the current position
+      Timers[Timer_evalGrad]->start();
+      PosType grad_now = wavefunction.evalGrad(els, iel);
+      Timers[Timer_evalGrad]->stop();
+
+      // Construct trial move
+      PosType dr   = sqrttau * delta[iel];
+      bool isValid = els.makeMoveAndCheck(iel, dr);
+
+      if (!isValid)
+        continue;
+
+      // Compute gradient at the trial position
+      Timers[Timer_ratioGrad]->start();
+
+      PosType grad_new;
+      wavefunction.ratioGrad(els, iel, grad_new);
+
+      spo.evaluate_vgh(els.R[iel]);
+
+      Timers[Timer_ratioGrad]->stop();
+
+      // Accept/reject the trial move
+      if (ur[iel] > accept) // MC
+      {
+        // Update position, and update temporary storage
+        Timers[Timer_Update]->start();
+        wavefunction.acceptMove(els, iel);
+        Timers[Timer_Update]->stop();
+        els.acceptMove(iel);
+        my_accepted++;
+      }
+      else
+      {
+        els.rejectMove(iel);
+        wavefunction.restore(iel);
+      }
+    } // iel
+  }   // substeps
+
+  els.donePbyP();
+
+  // evaluate Kinetic Energy
+  wavefunction.evaluateGL(els);
+
+  Timers[Timer_Diffusion]->stop();
+  return my_accepted;
+}
+
+/** NLPP evaluation of the walker of a mover, with the reordering of the step
+ * @param mover mover holding the walker, after diffuse_mover
+ * @param mc index of the step
+ */
+template<class WF>
+void evaluate_nlpp_mover(MoverT<WF>& mover,
+                         int mc,
+                         const MoverSettings& settings,
+                         TimerList_t& Timers)
+{
+  // clang-format off
+  typedef QMCTraits::RealType           RealType;
+  typedef ParticleSet::ParticlePos_t    ParticlePos_t;
+  typedef ParticleSet::PosType          PosType;
+  // clang-format on
+
+  const int reorder_interval = settings.reorder_interval;
+  const RealType Rmax        = settings.Rmax;
+
+  auto& els          = mover.els;
+  auto& spo          = *mover.spo;
+  auto& wavefunction = mover.wavefunction;
+  auto& ecp          = mover.nlpp;
+
+  // this is the number of quadrature points for the non-local PP
+  const int nknots(ecp.size());
+  ParticlePos_t rOnSphere(nknots);
+
+  // Compute NLPP energy using integral over spherical points
+
+  ecp.myRNG.setCounter(mc, RandomStepNLPP);
+  ecp.randomize(rOnSphere); // pick random sphere
+  const DistanceTableData* d_ie = els.DistTables[wavefunction.get_ei_TableID()];
+
+  Timers[Timer_ECP]->start();
+  for (int jel = 0; jel < els.getTotalNum(); ++jel)
+  {
+    const auto& dist  = d_ie->NeighborDistances[jel];
+    const auto& displ = d_ie->NeighborDisplacements[jel];
+    for (int inn = 0; inn < d_ie->NeighborCounts[jel]; ++inn)
+      if (dist[inn] < Rmax)
+        for (int k = 0; k < nknots; k++)
+        {
+          PosType deltar(dist[inn] * rOnSphere[k] - displ[inn]);
+
+          els.makeMoveOnSphere(jel, deltar);
+
+          Timers[Timer_Value]->start();
+          spo.evaluate_v(els.R[jel]);
+          wavefunction.ratio(els, jel);
+          Timers[Timer_Value]->stop();
+
+          els.rejectMove(jel);
+        }
+  }
+  Timers[Timer_ECP]->stop();
+
+  if (reorder_interval > 0 && (mc + 1) % reorder_interval == 0)
+  {
+    Timers[Timer_Reorder]->start();
+    std::vector<int> new2old;
+    els.sortByMorton(new2old);
+    els.update();
+    wavefunction.reorderParticles(els, new2old);
+    Timers[Timer_Reorder]->stop();
+  }
+}
+
+/** advance the walker of a mover by one MC step
+ * @param mover mover holding the walker
+ * @param mc index of the step
+ * @return the number of the accepted moves
+ */
+template<class WF>
+int advance_mover(MoverT<WF>& mover,
+                  int mc,
+                  const MoverSettings& settings,
+                  TimerList_t& Timers)
+{
+  const int my_accepted = diffuse_mover(mover, mc, settings, Timers);
+  evaluate_nlpp_mover(mover, mc, settings, Timers);
+  return my_accepted;
+}
+
+/** create the movers and run the walkers
+ * @tparam WF wavefunction container of the movers
+ *
+ * Without a walker pool, each mover carries its own walker through all the
+ * steps. With a pool of nwalkers, the walkers are swapped in and out of the
+ * movers of the threads at every step, through their buffers. With useTasks,
+ * the walkers of each step are OpenMP tasks taken by the idle threads instead
+ * of a static share per thread. With useGraph, the diffusion and the NLPP
+ * phases of all the steps are tasks ordered only within each mover, so that
+ * the NLPP of a walker overlaps the diffusion of another, without a barrier
+ * between the steps.
+ */
+template<class WF>
+void run_movers(const MoverSettings& settings,
+                TimerList_t& Timers,
+                ParticleSet& ions,
+                SPOSet* spo_main)
+{
+  using Walker_t = ParticleSet::Walker_t;
+
+  const int nwalkers         = settings.nwalkers;
+  const int nsteps           = settings.nsteps;
+  const int team_size        = settings.team_size;
+  const int reorder_interval = settings.reorder_interval;
+  const bool useRef          = settings.useRef;
+  const bool enableJ3        = settings.enableJ3;
+  const bool fuseJas         = settings.fuseJas;
+
+  // the walkers are distributed over the teams, each team splits the particle loops of its walker
+  if (team_size > 1)
+    omp_set_max_active_levels(2);
+  int nteams = std::max(1, omp_get_max_threads() / team_size);
+  // a mover per team in the pool mode
+  const int nmovers = nwalkers > 0 ? std::min(settings.nmovers, nteams) : settings.nmovers;
+  if (nwalkers > 0)
+    nteams = nmovers;
+
+  Timers[Timer_Init]->start();
+  std::vector<MoverT<WF>*> mover_list(nmovers, nullptr);
+// prepare movers
+  #pragma omp parallel for num_threads(nteams)
+  for (int iw = 0; iw < nmovers; iw++)
+  {
+    omp_set_num_threads(team_size);
+
+    // create and initialize movers
+    MoverT<WF>* thiswalker = new MoverT<WF>(settings.iseed, iw, ions);
+    mover_list[iw]         = thiswalker;
+
+    // the team splits the particle loops of the walker
+    thiswalker->els.WalkerTeamSize = team_size;
+
+    if (reorder_interval > 0)
+    {
+      std::vector<int> new2old;
+      thiswalker->els.sortByMorton(new2old);
+    }
+
+    // create a spo view in each Mover, of all the orbitals as the team serves a single walker
+    thiswalker->spo = build_SPOSet_view(useRef, spo_main, 1, 0);
+
+    // create wavefunction per mover
+    build_WaveFunction(useRef,
+                       thiswalker->wavefunction,
+                       ions,
+                       thiswalker->els,
+                       thiswalker->rng,
+                       enableJ3,
+                       fuseJas);
+
+    // NLPP only visits the ions within Rmax
+    thiswalker->els.DistTables[thiswalker->wavefunction.get_ei_TableID()]->requestNeighborList(
+        settings.Rmax);
+
+    // initial computing
+    thiswalker->els.update();
+    thiswalker->wavefunction.evaluateLog(thiswalker->els);
+  }
+
+  // the walkers of the pool start from their own streams, staged in the mover of the thread
+  std::vector<Walker_t*> walker_list(nwalkers, nullptr);
+  #pragma omp parallel for num_threads(nteams)
+  for (int iw = 0; iw < nwalkers; iw++)
+  {
+    MoverT<WF>& mover = *mover_list[omp_get_thread_num()];
+    mover.startWalker(settings.iseed, iw);
+    walker_list[iw]     = new Walker_t(mover.els.getTotalNum());
+    walker_list[iw]->ID = iw;
+    mover.els.saveWalker(*walker_list[iw]);
+    mover.els.registerData(walker_list[iw]->DataSet);
+    mover.wavefunction.registerData(mover.els, walker_list[iw]->DataSet);
+  }
+  Timers[Timer_Init]->stop();
+
+  // time in the walkers, of which the swaps, per thread
+  aligned_vector<ThreadTimes> thread_times(nteams);
+  // time in the parallel regions over the walkers
+  double region_time = 0.0;
+
+  /* one step of the iw-th walker, on the calling thread
+   * Without a pool, the walker is the iw-th mover. In the pool, it is swapped
+   * in and out of the mover of the thread.
+   */
+  auto advance_walker = [&](int iw, int mc) {
+    omp_set_num_threads(team_size);
+    const int ip         = omp_get_thread_num();
+    const double t_begin = omp_get_wtime();
+    if (nwalkers == 0)
+      advance_mover(*mover_list[iw], mc, settings, Timers);
+    else
+    {
+      MoverT<WF>& mover = *mover_list[ip];
+      Walker_t& walker  = *walker_list[iw];
+
+      Timers[Timer_Swap]->start();
+      double t0 = omp_get_wtime();
+      mover.els.loadWalker(walker, false);
+      walker.DataSet.rewind();
+      mover.els.copyFromBuffer(walker.DataSet);
+      mover.wavefunction.copyFromBuffer(mover.els, walker.DataSet);
+      mover.rng.setStream(walker.ID);
+      mover.nlpp.myRNG.setStream(walker.ID);
+      thread_times[ip].load += omp_get_wtime() - t0;
+      Timers[Timer_Swap]->stop();
+
+      advance_mover(mover, mc, settings, Timers);
+
+      Timers[Timer_Swap]->start();
+      t0 = omp_get_wtime();
+      mover.els.saveWalker(walker);
+      walker.DataSet.rewind();
+      mover.els.copyToBuffer(walker.DataSet);
+      mover.wavefunction.copyToBuffer(mover.els, walker.DataSet);
+      thread_times[ip].save += omp_get_wtime() - t0;
+      Timers[Timer_Swap]->stop();
+    }
+    thread_times[ip].busy += omp_get_wtime() - t_begin;
+  };
+
+  /* a phase of a step of the iw-th mover, on the calling thread
+   * Without the NLPP, the drift-and-diffusion sweep.
+   */
+  auto run_phase = [&](int iw, int mc, bool nlpp) {
+    omp_set_num_threads(team_size);
+    const int ip         = omp_get_thread_num();
+    const double t_begin = omp_get_wtime();
+    if (nlpp)
+      evaluate_nlpp_mover(*mover_list[iw], mc, settings, Timers);
+    else
+      diffuse_mover(*mover_list[iw], mc, settings, Timers);
+    thread_times[ip].busy += omp_get_wtime() - t_begin;
+  };
+
+  if (settings.useGraph)
+  {
+    // the phases of a mover are chained over the steps by its dependence
+    std::vector<char> mover_deps(nmovers);
+    char* deps      = mover_deps.data();
+    const double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(nteams)
+    #pragma omp single
+    for (int mc = 0; mc < nsteps; ++mc)
+      for (int iw = 0; iw < nmovers; iw++)
+      {
+        #pragma omp task firstprivate(iw, mc) depend(inout : deps[iw])
+        run_phase(iw, mc, false);
+        #pragma omp task firstprivate(iw, mc) depend(inout : deps[iw])
+        run_phase(iw, mc, true);
+      }
+    region_time += omp_get_wtime() - t0;
+  }
+  else if (nwalkers == 0 && !settings.useTasks)
+  {
+    const double t0 = omp_get_wtime();
+    #pragma omp parallel for num_threads(nteams)
+    for (int iw = 0; iw < nmovers; iw++)
+    {
+      for (int mc = 0; mc < nsteps; ++mc)
+        advance_walker(iw, mc);
+    } // end of mover loop
+    region_time += omp_get_wtime() - t0;
+  }
+  else
+  {
+    const int ntasks = nwalkers > 0 ? nwalkers : nmovers;
+    for (int mc = 0; mc < nsteps; ++mc)
+    {
+      const double t0 = omp_get_wtime();
+      if (settings.useTasks)
+      {
+        // the idle threads take the pending walkers of the step
+        #pragma omp parallel num_threads(nteams)
+        #pragma omp single
+        for (int iw = 0; iw < ntasks; iw++)
+        {
+          #pragma omp task firstprivate(iw)
+          advance_walker(iw, mc);
+        }
+      }
+      else
+      {
+        #pragma omp parallel for num_threads(nteams)
+        for (int iw = 0; iw < ntasks; iw++)
+          advance_walker(iw, mc);
+      }
+      region_time += omp_get_wtime() - t0;
+    } // end of step loop
+  }
+
+  if (nwalkers > 0)
+  {
+    const double nswaps = static_cast<double>(nwalkers) * nsteps;
+    double t_load = 0.0, t_save = 0.0;
+    for (const ThreadTimes& t : thread_times)
+    {
+      t_load += t.load;
+      t_save += t.save;
+    }
+    app_summary() << "\nWalker buffer size = " << walker_list[0]->DataSet.byteSize()
+                  << " bytes per walker" << endl
+                  << "Walker swap time per walker and step = " << (t_load + t_save) / nswaps * 1.e6
+                  << " us (load " << t_load / nswaps * 1.e6 << " us, save "
+                  << t_save / nswaps * 1.e6 << " us)" << endl;
+  }
+
+  // idle time of the threads within the walker regions
+  double sum_idle = 0.0, max_idle = 0.0;
+  app_log() << "\nThread  Busy time (s)  Idle time (s)" << endl;
+  for (int ip = 0; ip < nteams; ip++)
+  {
+    const double idle = std::max(0.0, region_time - thread_times[ip].busy);
+    sum_idle += idle;
+    max_idle = std::max(max_idle, idle);
+    app_log() << std::setw(6) << ip << std::setw(15) << thread_times[ip].busy << std::setw(15) << idle
+              << endl;
+  }
+  app_summary() << "\nIdle time per thread = " << sum_idle / nteams << " s on average, "
+                << max_idle << " s at most, of " << region_time << " s in the walker steps"
+                << endl;
+
+  // free all movers and walkers
+  #pragma omp parallel for
+  for (int iw = 0; iw < nmovers; iw++)
+    delete mover_list[iw];
+  mover_list.clear();
+  #pragma omp parallel for
+  for (int iw = 0; iw < nwalkers; iw++)
+    delete walker_list[iw];
+  walker_list.clear();
+}
+
 int main(int argc, char** argv)
 {
   // clang-format off
@@ -188,16 +663,26 @@ int main(int argc, char** argv)
   int iseed  = 11;
   int nx = 37, ny = 37, nz = 37;
   int nmovers = omp_get_max_threads();
+  // lightweight walkers multiplexed onto the movers, 0 for a walker per mover
+  int nwalkers = 0;
   // thread blocking
   int tileSize  = -1;
+  // threads of the team serving each walker
   int team_size = 1;
   int nsubsteps = 1;
+  // sort particles by Morton key every reorder_interval steps, 0 for off
+  int reorder_interval = 0;
   // Set cutoff for NLPP use.
   RealType Rmax(1.7);
   bool useRef   = false;
   bool enableJ3 = false;
+  bool fuseJas  = false;
+  bool staticWF = false;
+  // walkers as OpenMP tasks, taken by the idle threads
+  bool useTasks = false;
+  // diffusion and NLPP phases as a task graph over the steps
+  bool useGraph = false;
 
-  PrimeNumberSet<uint32_t> myPrimes;
 
   bool verbose                 = false;
   std::string timer_level_name = "fine";
@@ -210,7 +695,7 @@ int main(int argc, char** argv)
   int opt;
   while (optind < argc)
   {
-    if ((opt = getopt(argc, argv, "bhjvVa:c:g:m:n:N:r:s:w:t:")) != -1)
+    if ((opt = getopt(argc, argv, "bdfGhjvTVa:c:g:m:n:N:o:r:s:w:W:t:")) != -1)
     {
       switch (opt)
       {
@@ -220,8 +705,17 @@ int main(int argc, char** argv)
       case 'b':
         useRef = true;
         break;
-      case 'c': // number of members per team
-        team_size = atoi(optarg);
+      case 'c': // number of threads per walker
+        team_size = std::max(1, atoi(optarg));
+        break;
+      case 'd':
+        staticWF = true;
+        break;
+      case 'f':
+        fuseJas = true;
+        break;
+      case 'G':
+        useGraph = true;
         break;
       case 'g': // tiling1 tiling2 tiling3
         sscanf(optarg, "%d %d %d", &na, &nb, &nc);
@@ -247,6 +741,9 @@ int main(int argc, char** argv)
       case 'N':
         nsubsteps = atoi(optarg);
         break;
+      case 'o':
+        reorder_interval = atoi(optarg);
+        break;
       case 'r': // rmax
         Rmax = atof(optarg);
         break;
@@ -259,6 +756,9 @@ int main(int argc, char** argv)
       case 'v':
         verbose = true;
         break;
+      case 'T':
+        useTasks = true;
+        break;
       case 'V':
         print_version(true);
         return 1;
@@ -266,6 +766,9 @@ int main(int argc, char** argv)
       case 'w': // number of nmovers
         nmovers = atoi(optarg);
         break;
+      case 'W': // number of walkers in the pool
+        nwalkers = atoi(optarg);
+        break;
       default:
         print_help();
         return 1;
@@ -278,6 +781,19 @@ int main(int argc, char** argv)
     }
   }
 
+  if (staticWF && (useRef || fuseJas))
+  {
+    app_error() << "The static-dispatch wavefunction (-d) cannot be combined with -b or -f" << endl;
+    return 1;
+  }
+
+  if (useGraph && nwalkers > 0)
+  {
+    app_error() << "The task graph (-G) needs a mover per walker and cannot be combined with -W"
+                << endl;
+    return 1;
+  }
+
   int number_of_electrons = 0;
 
   Tensor<int, 3> tmat(na, 0, 0, 0, nb, 0, 0, 0, nc);
@@ -316,6 +832,11 @@ int main(int argc, char** argv)
   {
     Tensor<OHMMS_PRECISION, 3> lattice_b;
     build_ions(ions, tmat, lattice_b);
+    if (reorder_interval > 0)
+    {
+      std::vector<int> new2old;
+      ions.sortByMorton(new2old);
+    }
     const int nels = count_electrons(ions, 1);
     const int norb = nels / 2;
     tileSize       = (tileSize > 0) ? tileSize : norb;
@@ -333,6 +854,8 @@ int main(int argc, char** argv)
                   << "Number of electrons = " << nels << endl
                   << "Rmax = " << Rmax << endl;
     app_summary() << "Iterations = " << nsteps << endl;
+    if (nwalkers > 0)
+      app_summary() << "Walkers in the pool = " << nwalkers << endl;
     app_summary() << "OpenMP threads = " << omp_get_max_threads() << endl;
 #ifdef HAVE_MPI
     app_summary() << "MPI processes = " << comm.size() << endl;
@@ -351,160 +874,34 @@ int main(int argc, char** argv)
     app_summary() << "Using the reference implementation for Jastrow, " << endl
                   << "determinant update, and distance table + einspline of the " << endl
                   << "reference implementation " << endl;
+  if (staticWF)
+    app_summary() << "Using the static-dispatch wavefunction." << endl;
+  if (useGraph)
+    app_summary() << "Pipelining the diffusion and NLPP phases as a task graph." << endl;
+  else if (useTasks)
+    app_summary() << "Scheduling the walkers of each step as tasks." << endl;
+
+  MoverSettings settings;
+  settings.nmovers          = nmovers;
+  settings.nwalkers         = nwalkers;
+  settings.nsteps           = nsteps;
+  settings.nsubsteps        = nsubsteps;
+  settings.team_size        = team_size;
+  settings.reorder_interval = reorder_interval;
+  settings.Rmax             = Rmax;
+  settings.iseed            = iseed;
+  settings.useRef           = useRef;
+  settings.enableJ3         = enableJ3;
+  settings.fuseJas          = fuseJas;
+  settings.useTasks         = useTasks;
+  settings.useGraph         = useGraph;
 
   Timers[Timer_Total]->start();
-
-  Timers[Timer_Init]->start();
-  std::vector<Mover*> mover_list(nmovers, nullptr);
-// prepare movers
-  #pragma omp parallel for
-  for (int iw = 0; iw < nmovers; iw++)
-  {
-    const int ip        = omp_get_thread_num();
-    const int member_id = ip % team_size;
-
-    // create and initialize movers
-    Mover* thiswalker = new Mover(myPrimes[ip], ions);
-    mover_list[iw]    = thiswalker;
-
-    // create a spo view in each Mover
-    thiswalker->spo = build_SPOSet_view(useRef, spo_main, team_size, member_id);
-
-    // create wavefunction per mover
-    build_WaveFunction(useRef, thiswalker->wavefunction, ions, thiswalker->els, thiswalker->rng, enableJ3);
-
-    // initial computing
-    thiswalker->els.update();
-    thiswalker->wavefunction.evaluateLog(thiswalker->els);
-  }
-  Timers[Timer_Init]->stop();
-
-  const int nions = ions.getTotalNum();
-  const int nels  = mover_list[0]->els.getTotalNum();
-  const int nels3 = 3 * nels;
-
-  // this is the number of quadrature points for the non-local PP
-  const int nknots(mover_list[0]->nlpp.size());
-
-  // For VMC, tau is large and should result in an acceptance ratio of roughly
-  // 50%
-  // For DMC, tau is small and should result in an acceptance ratio of 99%
-  const RealType tau = 2.0;
-
-  RealType sqrttau = std::sqrt(tau);
-  RealType accept  = 0.5;
-
-  #pragma omp parallel for
-  for (int iw = 0; iw < nmovers; iw++)
-  {
-    auto& els          = mover_list[iw]->els;
-    auto& spo          = *mover_list[iw]->spo;
-    auto& random_th    = mover_list[iw]->rng;
-    auto& wavefunction = mover_list[iw]->wavefunction;
-    auto& ecp          = mover_list[iw]->nlpp;
-
-    ParticlePos_t delta(nels);
-    ParticlePos_t rOnSphere(nknots);
-
-    aligned_vector<RealType> ur(nels);
-
-    int my_accepted = 0;
-    for (int mc = 0; mc < nsteps; ++mc)
-    {
-      Timers[Timer_Diffusion]->start();
-      for (int l = 0; l < nsubsteps; ++l) // drift-and-diffusion
-      {
-        random_th.generate_uniform(ur.data(), nels);
-        random_th.generate_normal(&delta[0][0], nels3);
-        for (int iel = 0; iel < nels; ++iel)
-        {
-          // Operate on electron with index iel
-          els.setActive(iel);
-          // Compute gradient at the current position
-          Timers[Timer_evalGrad]->start();
-          PosType grad_now = wavefunction.evalGrad(els, iel);
-          Timers[Timer_evalGrad]->stop();
-
-          // Construct trial move
-          PosType dr   = sqrttau * delta[iel];
-          bool isValid = els.makeMoveAndCheck(iel, dr);
-
-          if (!isValid)
-            continue;
-
-          // Compute gradient at the trial position
-          Timers[Timer_ratioGrad]->start();
-
-          PosType grad_new;
-          wavefunction.ratioGrad(els, iel, grad_new);
-
-          spo.evaluate_vgh(els.R[iel]);
-
-          Timers[Timer_ratioGrad]->stop();
-
-          // Accept/reject the trial move
-          if (ur[iel] > accept) // MC
-          {
-            // Update position, and update temporary storage
-            Timers[Timer_Update]->start();
-            wavefunction.acceptMove(els, iel);
-            Timers[Timer_Update]->stop();
-            els.acceptMove(iel);
-            my_accepted++;
-          }
-          else
-          {
-            els.rejectMove(iel);
-            wavefunction.restore(iel);
-          }
-        } // iel
-      }   // substeps
-
-      els.donePbyP();
-
-      // evaluate Kinetic Energy
-      wavefunction.evaluateGL(els);
-
-      Timers[Timer_Diffusion]->stop();
-
-      // Compute NLPP energy using integral over spherical points
-
-      ecp.randomize(rOnSphere); // pick random sphere
-      const DistanceTableData* d_ie = els.DistTables[wavefunction.get_ei_TableID()];
-
-      Timers[Timer_ECP]->start();
-      for (int jel = 0; jel < els.getTotalNum(); ++jel)
-      {
-        const auto& dist  = d_ie->Distances[jel];
-        const auto& displ = d_ie->Displacements[jel];
-        for (int iat = 0; iat < nions; ++iat)
-          if (dist[iat] < Rmax)
-            for (int k = 0; k < nknots; k++)
-            {
-              PosType deltar(dist[iat] * rOnSphere[k] - displ[iat]);
-
-              els.makeMoveOnSphere(jel, deltar);
-
-              Timers[Timer_Value]->start();
-              spo.evaluate_v(els.R[jel]);
-              wavefunction.ratio(els, jel);
-              Timers[Timer_Value]->stop();
-
-              els.rejectMove(jel);
-            }
-      }
-      Timers[Timer_ECP]->stop();
-
-    } // nsteps
-
-  } // end of mover loop
+  if (staticWF)
+    run_movers<StaticSlaterJastrow>(settings, Timers, ions, spo_main);
+  else
+    run_movers<WaveFunction>(settings, Timers, ions, spo_main);
   Timers[Timer_Total]->stop();
-
-  // free all movers
-  #pragma omp parallel for
-  for (int iw = 0; iw < nmovers; iw++)
-    delete mover_list[iw];
-  mover_list.clear();
   delete spo_main;
 
   if (comm.root())
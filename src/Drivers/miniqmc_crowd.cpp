@@ -0,0 +1,591 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+// -*- C++ -*-
+/** @file miniqmc_crowd.cpp
+    @brief Miniapp of the crowds of walkers owned by the threads.
+
+  The walkers are split into crowds of a tunable size, each owned by a thread
+  for the whole run. A thread moves the walkers of its crowds in lock step
+  through the multi_ functions, as miniqmc_sync_move does for all the
+  walkers, but the kernels run on the owning thread alone and the crowds
+  never wait for each other, as the walkers of miniqmc. The crowd size trades
+  the batching of the kernels against the number of crowds to balance over
+  the threads.
+ */
+
+#include <Utilities/Configuration.h>
+#include <Utilities/Communicate.h>
+#include <Particle/ParticleSet.h>
+#include <Particle/DistanceTable.h>
+#include <Utilities/NewTimer.h>
+#include <Utilities/XMLWriter.h>
+#include <Utilities/RandomGenerator.h>
+#include <Utilities/qmcpack_version.h>
+#include <Input/Input.hpp>
+#include <QMCWaveFunctions/SPOSet.h>
+#include <QMCWaveFunctions/SPOSet_builder.h>
+#include <QMCWaveFunctions/WaveFunction.h>
+#include <Drivers/Mover.hpp>
+#include <Drivers/Crowd.hpp>
+#include <getopt.h>
+
+using namespace std;
+using namespace qmcplusplus;
+
+enum MiniQMCTimers
+{
+  Timer_Total,
+  Timer_Init,
+  Timer_Diffusion,
+  Timer_ECP,
+  Timer_Value,
+  Timer_evalGrad,
+  Timer_ratioGrad,
+  Timer_Update,
+  Timer_Reorder,
+};
+
+TimerNameList_t<MiniQMCTimers> MiniQMCTimerNames = {
+    {Timer_Total, "Total"},
+    {Timer_Init, "Initialization"},
+    {Timer_Diffusion, "Diffusion"},
+    {Timer_ECP, "Pseudopotential"},
+    {Timer_Value, "Value"},
+    {Timer_evalGrad, "Current Gradient"},
+    {Timer_ratioGrad, "New Gradient"},
+    {Timer_Update, "Update"},
+    {Timer_Reorder, "Reorder"},
+};
+
+void print_help()
+{
+  // clang-format off
+  app_summary() << "usage:" << '\n';
+  app_summary() << "  miniqmc_crowd   [-bfhjvV] [-g \"n0 n1 n2\"] [-m meshfactor]" << '\n';
+  app_summary() << "                  [-n steps] [-N substeps] [-r rmax] [-s seed]" << '\n';
+  app_summary() << "                  [-w walkers] [-c crowd_size] [-a tile_size]" << '\n';
+  app_summary() << "                  [-t timer_level] [-o reorder_interval]"      << '\n';
+  app_summary() << "options:"                                                    << '\n';
+  app_summary() << "  -a  size of each spline tile       default: num of orbs"   << '\n';
+  app_summary() << "  -b  use reference implementations  default: off"           << '\n';
+  app_summary() << "  -c  number of walkers per crowd    default: one crowd per thread" << '\n';
+  app_summary() << "  -f  fuse the Jastrow factors       default: off"           << '\n';
+  app_summary() << "  -g  set the 3D tiling.             default: 1 1 1"         << '\n';
+  app_summary() << "  -h  print help and exit"                                   << '\n';
+  app_summary() << "  -j  enable three body Jastrow      default: off"           << '\n';
+  app_summary() << "  -m  meshfactor                     default: 1.0"           << '\n';
+  app_summary() << "  -n  number of MC steps             default: 5"             << '\n';
+  app_summary() << "  -N  number of MC substeps          default: 1"             << '\n';
+  app_summary() << "  -o  Morton reorder every o steps   default: 0 (off)"       << '\n';
+  app_summary() << "  -r  set the Rmax.                  default: 1.7"           << '\n';
+  app_summary() << "  -s  set the random seed.           default: 11"            << '\n';
+  app_summary() << "  -t  timer level: coarse or fine    default: fine"          << '\n';
+  app_summary() << "  -w  number of walker(movers)       default: num of threads"<< '\n';
+  app_summary() << "  -v  verbose output"                                        << '\n';
+  app_summary() << "  -V  print version information and exit"                    << '\n';
+  // clang-format on
+}
+
+/// settings of the crowd steps, from the command line
+struct CrowdSettings
+{
+  int nsubsteps;
+  int reorder_interval;
+  QMCTraits::RealType Rmax;
+};
+
+/** advance the walkers of a crowd by one step, in lock step
+ * @param crowd crowd of the walkers, owned by the calling thread
+ * @param mc index of the step
+ *
+ * The multi_ functions are called on the first mover of the crowd, whose
+ * components keep the scratch of the crowd. The crowd is serial, so they open
+ * no parallel region.
+ */
+void advance_crowd(Crowd& crowd, int mc, const CrowdSettings& settings, TimerList_t& Timers)
+{
+  // clang-format off
+  typedef QMCTraits::RealType           RealType;
+  typedef ParticleSet::ParticlePos_t    ParticlePos_t;
+  typedef ParticleSet::PosType          PosType;
+  // clang-format on
+
+  const int nw               = crowd.size();
+  const int reorder_interval = settings.reorder_interval;
+  const RealType Rmax        = settings.Rmax;
+
+  Mover& anon_mover = *crowd.movers[0];
+  const int nels    = anon_mover.els.getTotalNum();
+
+  // For VMC, tau is large and should result in an acceptance ratio of roughly
+  // 50%
+  // For DMC, tau is small and should result in an acceptance ratio of 99%
+  const RealType tau = 2.0;
+
+  RealType sqrttau = std::sqrt(tau);
+  RealType accept  = 0.5;
+
+  Timers[Timer_Diffusion]->start();
+  for (int l = 0; l < settings.nsubsteps; ++l) // drift-and-diffusion
+  {
+    crowd.drawSubstep(mc, l);
+    for (int iel = 0; iel < nels; ++iel)
+    {
+      // Operate on electron with index iel
+      for (int iw = 0; iw < nw; iw++)
+        crowd.P_list[iw]->setActive(iel);
+
+      // Compute gradient at the current position
+      Timers[Timer_evalGrad]->start();
+      anon_mover.wavefunction.multi_evalGrad(crowd.WF_list,
+                                             crowd.P_list,
+                                             iel,
+                                             crowd.grad_now,
+                                             crowd.wf_scratch,
+                                             crowd.serial);
+      Timers[Timer_evalGrad]->stop();
+
+      // Construct trial move
+      for (int iw = 0; iw < nw; iw++)
+        crowd.delta[iw] = sqrttau * crowd.substep_delta[iw * nels + iel];
+      anon_mover.els.multi_makeMoveAndCheck(crowd.P_list,
+                                            iel,
+                                            crowd.delta,
+                                            crowd.isValid,
+                                            crowd.serial);
+
+      crowd.filterValid();
+      const int nvalid = crowd.valid_movers.size();
+
+      // Compute gradient at the trial position
+      Timers[Timer_ratioGrad]->start();
+      anon_mover.wavefunction.multi_ratioGrad(crowd.valid_WF_list,
+                                              crowd.valid_P_list,
+                                              iel,
+                                              crowd.ratios,
+                                              crowd.grad_new,
+                                              crowd.wf_scratch,
+                                              crowd.serial);
+
+      for (int iv = 0; iv < nvalid; iv++)
+        crowd.pos_list[iv] = crowd.valid_P_list[iv]->R[iel];
+      anon_mover.spo->multi_evaluate_vgh(crowd.valid_spo_list, crowd.pos_list, crowd.serial);
+      Timers[Timer_ratioGrad]->stop();
+
+      // Accept/reject the trial move
+      for (int iw = 0, iv = 0; iw < nw; iw++)
+        if (crowd.isValid[iw])
+          crowd.isAccepted[iv++] = crowd.substep_ur[iw * nels + iel] > accept;
+
+      Timers[Timer_Update]->start();
+      // update WF storage
+      anon_mover.wavefunction.multi_acceptrestoreMove(crowd.valid_WF_list,
+                                                      crowd.valid_P_list,
+                                                      crowd.isAccepted,
+                                                      iel,
+                                                      crowd.wf_scratch,
+                                                      crowd.serial);
+      Timers[Timer_Update]->stop();
+
+      // Update position
+      for (int iv = 0; iv < nvalid; iv++)
+      {
+        if (crowd.isAccepted[iv]) // MC
+          crowd.valid_P_list[iv]->acceptMove(iel);
+        else
+          crowd.valid_P_list[iv]->rejectMove(iel);
+      }
+    } // iel
+  }   // substeps
+
+  for (int iw = 0; iw < nw; iw++)
+    crowd.P_list[iw]->donePbyP();
+  anon_mover.wavefunction.multi_evaluateGL(crowd.WF_list,
+                                           crowd.P_list,
+                                           crowd.wf_scratch,
+                                           crowd.serial);
+  Timers[Timer_Diffusion]->stop();
+
+  // Compute NLPP energy using integral over spherical points
+  Timers[Timer_ECP]->start();
+  for (int iw = 0; iw < nw; iw++)
+  {
+    auto& els          = crowd.movers[iw]->els;
+    auto& spo          = *crowd.movers[iw]->spo;
+    auto& wavefunction = crowd.movers[iw]->wavefunction;
+    auto& ecp          = crowd.movers[iw]->nlpp;
+
+    // this is the number of quadrature points for the non-local PP
+    const int nknots(ecp.size());
+    ParticlePos_t rOnSphere(nknots);
+    ecp.myRNG.setCounter(mc, RandomStepNLPP);
+    ecp.randomize(rOnSphere); // pick random sphere
+    const DistanceTableData* d_ie = els.DistTables[wavefunction.get_ei_TableID()];
+
+    for (int jel = 0; jel < els.getTotalNum(); ++jel)
+    {
+      const auto& dist  = d_ie->NeighborDistances[jel];
+      const auto& displ = d_ie->NeighborDisplacements[jel];
+      for (int inn = 0; inn < d_ie->NeighborCounts[jel]; ++inn)
+        if (dist[inn] < Rmax)
+          for (int k = 0; k < nknots; k++)
+          {
+            PosType deltar(dist[inn] * rOnSphere[k] - displ[inn]);
+
+            els.makeMoveOnSphere(jel, deltar);
+
+            Timers[Timer_Value]->start();
+            spo.evaluate_v(els.R[jel]);
+            wavefunction.ratio(els, jel);
+            Timers[Timer_Value]->stop();
+
+            els.rejectMove(jel);
+          }
+    }
+  }
+  Timers[Timer_ECP]->stop();
+
+  if (reorder_interval > 0 && (mc + 1) % reorder_interval == 0)
+  {
+    Timers[Timer_Reorder]->start();
+    std::vector<int> new2old;
+    for (int iw = 0; iw < nw; iw++)
+    {
+      auto& els = crowd.movers[iw]->els;
+      els.sortByMorton(new2old);
+      els.update();
+      crowd.movers[iw]->wavefunction.reorderParticles(els, new2old);
+    }
+    Timers[Timer_Reorder]->stop();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  // clang-format off
+  typedef QMCTraits::RealType           RealType;
+  typedef ParticleSet::ParticlePos_t    ParticlePos_t;
+  typedef ParticleSet::PosType          PosType;
+  // clang-format on
+
+  Communicate comm(argc, argv);
+
+  int na     = 1;
+  int nb     = 1;
+  int nc     = 1;
+  int nsteps = 5;
+  int iseed  = 11;
+  int nx = 37, ny = 37, nz = 37;
+  int nmovers = omp_get_max_threads();
+  // thread blocking
+  int tileSize  = -1;
+  int nsubsteps = 1;
+  // walkers per crowd, 0 for one crowd per thread
+  int crowd_size = 0;
+  // sort particles by Morton key every reorder_interval steps, 0 for off
+  int reorder_interval = 0;
+  // Set cutoff for NLPP use.
+  RealType Rmax(1.7);
+  bool useRef   = false;
+  bool enableJ3 = false;
+  bool fuseJas  = false;
+
+
+  bool verbose                 = false;
+  std::string timer_level_name = "fine";
+
+  if (!comm.root())
+  {
+    outputManager.shutOff();
+  }
+
+  int opt;
+  while (optind < argc)
+  {
+    if ((opt = getopt(argc, argv, "bfhjvVa:c:g:m:n:N:o:r:s:w:t:")) != -1)
+    {
+      switch (opt)
+      {
+      case 'a':
+        tileSize = atoi(optarg);
+        break;
+      case 'b':
+        useRef = true;
+        break;
+      case 'c': // number of walkers per crowd
+        crowd_size = atoi(optarg);
+        break;
+      case 'f':
+        fuseJas = true;
+        break;
+      case 'g': // tiling1 tiling2 tiling3
+        sscanf(optarg, "%d %d %d", &na, &nb, &nc);
+        break;
+      case 'h':
+        print_help();
+        return 1;
+        break;
+      case 'j':
+        enableJ3 = true;
+        break;
+      case 'm':
+      {
+        const RealType meshfactor = atof(optarg);
+        nx *= meshfactor;
+        ny *= meshfactor;
+        nz *= meshfactor;
+      }
+      break;
+      case 'n':
+        nsteps = atoi(optarg);
+        break;
+      case 'N':
+        nsubsteps = atoi(optarg);
+        break;
+      case 'o':
+        reorder_interval = atoi(optarg);
+        break;
+      case 'r': // rmax
+        Rmax = atof(optarg);
+        break;
+      case 's':
+        iseed = atoi(optarg);
+        break;
+      case 't':
+        timer_level_name = std::string(optarg);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      case 'V':
+        print_version(true);
+        return 1;
+        break;
+      case 'w': // number of nmovers
+        nmovers = atoi(optarg);
+        break;
+      default:
+        print_help();
+        return 1;
+      }
+    }
+    else // disallow non-option arguments
+    {
+      app_error() << "Non-option arguments not allowed" << endl;
+      print_help();
+    }
+  }
+
+  const int nthreads = omp_get_max_threads();
+  if (crowd_size <= 0)
+    crowd_size = (nmovers + nthreads - 1) / nthreads;
+  const int ncrowds = (nmovers + crowd_size - 1) / crowd_size;
+
+  int number_of_electrons = 0;
+
+  Tensor<int, 3> tmat(na, 0, 0, 0, nb, 0, 0, 0, nc);
+
+  timer_levels timer_level = timer_level_fine;
+  if (timer_level_name == "coarse")
+  {
+    timer_level = timer_level_coarse;
+  }
+  else if (timer_level_name != "fine")
+  {
+    app_error() << "Timer level should be 'coarse' or 'fine', name given: " << timer_level_name
+                << endl;
+    return 1;
+  }
+
+  TimerManager.set_timer_threshold(timer_level);
+  TimerList_t Timers;
+  setup_timers(Timers, MiniQMCTimerNames, timer_level_coarse);
+
+  if (comm.root())
+  {
+    if (verbose)
+      outputManager.setVerbosity(Verbosity::HIGH);
+    else
+      outputManager.setVerbosity(Verbosity::LOW);
+  }
+
+  print_version(verbose);
+
+  SPOSet* spo_main;
+  int nTiles = 1;
+
+  ParticleSet ions;
+  // initialize ions and splines which are shared by all threads later
+  {
+    Tensor<OHMMS_PRECISION, 3> lattice_b;
+    build_ions(ions, tmat, lattice_b);
+    if (reorder_interval > 0)
+    {
+      std::vector<int> new2old;
+      ions.sortByMorton(new2old);
+    }
+    const int nels = count_electrons(ions, 1);
+    const int norb = nels / 2;
+    tileSize       = (tileSize > 0) ? tileSize : norb;
+    nTiles         = norb / tileSize;
+
+    number_of_electrons = nels;
+
+    const size_t SPO_coeff_size =
+        static_cast<size_t>(norb) * (nx + 3) * (ny + 3) * (nz + 3) * sizeof(RealType);
+    const double SPO_coeff_size_MB = SPO_coeff_size * 1.0 / 1024 / 1024;
+
+    app_summary() << "Number of orbitals/splines = " << norb << endl
+                  << "Tile size = " << tileSize << endl
+                  << "Number of tiles = " << nTiles << endl
+                  << "Number of electrons = " << nels << endl
+                  << "Rmax = " << Rmax << endl;
+    app_summary() << "Iterations = " << nsteps << endl;
+    app_summary() << "OpenMP threads = " << nthreads << endl;
+    app_summary() << "Crowds = " << ncrowds << " of up to " << crowd_size << " walkers" << endl;
+#ifdef HAVE_MPI
+    app_summary() << "MPI processes = " << comm.size() << endl;
+#endif
+
+    app_summary() << "\nSPO coefficients size = " << SPO_coeff_size << " bytes ("
+                  << SPO_coeff_size_MB << " MB)" << endl;
+
+    spo_main = build_SPOSet(useRef, nx, ny, nz, norb, nTiles, lattice_b);
+  }
+
+  if (!useRef)
+    app_summary() << "Using SoA distance table, Jastrow + einspline, " << endl
+                  << "and determinant update." << endl;
+  else
+    app_summary() << "Using the reference implementation for Jastrow, " << endl
+                  << "determinant update, and distance table + einspline of the " << endl
+                  << "reference implementation " << endl;
+
+  const CrowdSettings settings = {nsubsteps, reorder_interval, Rmax};
+
+  Timers[Timer_Total]->start();
+
+  Timers[Timer_Init]->start();
+  std::vector<Mover*> mover_list(nmovers, nullptr);
+  std::vector<Crowd> crowds(ncrowds);
+  // prepare the movers of each crowd on the thread owning it
+  #pragma omp parallel for schedule(static, 1)
+  for (int ic = 0; ic < ncrowds; ic++)
+  {
+    // the walker teams of the crowd stay on this thread
+    omp_set_num_threads(1);
+
+    const int first = ic * crowd_size;
+    const int last  = std::min(first + crowd_size, nmovers);
+    for (int iw = first; iw < last; iw++)
+    {
+      // create and initialize movers
+      Mover* thiswalker = new Mover(iseed, iw, ions);
+      mover_list[iw]    = thiswalker;
+
+      if (reorder_interval > 0)
+      {
+        std::vector<int> new2old;
+        thiswalker->els.sortByMorton(new2old);
+      }
+
+      // create a spo view in each Mover
+      thiswalker->spo = build_SPOSet_view(useRef, spo_main, 1, 0);
+
+      // create wavefunction per mover
+      build_WaveFunction(useRef,
+                         thiswalker->wavefunction,
+                         ions,
+                         thiswalker->els,
+                         thiswalker->rng,
+                         enableJ3,
+                         fuseJas);
+
+      // NLPP only visits the ions within Rmax
+      thiswalker->els.DistTables[thiswalker->wavefunction.get_ei_TableID()]->requestNeighborList(
+          Rmax);
+
+      // initial computing
+      thiswalker->els.update();
+    }
+
+    Crowd& crowd = crowds[ic];
+    crowd.setMovers(std::vector<Mover*>(mover_list.begin() + first, mover_list.begin() + last));
+    crowd.serial = true;
+    crowd.movers[0]->wavefunction.multi_evaluateLog(crowd.WF_list,
+                                                    crowd.P_list,
+                                                    crowd.wf_scratch,
+                                                    crowd.serial);
+  }
+  Timers[Timer_Init]->stop();
+
+  // each crowd takes all the steps on its thread, without waiting for the others
+  const double t0 = omp_get_wtime();
+  #pragma omp parallel for schedule(static, 1)
+  for (int ic = 0; ic < ncrowds; ic++)
+  {
+    omp_set_num_threads(1);
+    for (int mc = 0; mc < nsteps; ++mc)
+      advance_crowd(crowds[ic], mc, settings, Timers);
+  }
+  const double advance_time = omp_get_wtime() - t0;
+  Timers[Timer_Total]->stop();
+
+  const long walker_steps = static_cast<long>(nmovers) * nsteps;
+  app_summary() << "\nWalker-steps = " << walker_steps << endl
+                << "Advance time = " << advance_time << " s, throughput = "
+                << walker_steps / advance_time << " walker-steps/s" << endl;
+
+  // free all movers
+  crowds.clear();
+  #pragma omp parallel for
+  for (int iw = 0; iw < nmovers; iw++)
+    delete mover_list[iw];
+  mover_list.clear();
+  delete spo_main;
+
+  if (comm.root())
+  {
+    cout << "================================== " << endl;
+
+    TimerManager.print();
+
+    XMLDocument doc;
+    XMLNode* resources = doc.NewElement("resources");
+    XMLNode* hardware  = doc.NewElement("hardware");
+    resources->InsertEndChild(hardware);
+    doc.InsertEndChild(resources);
+    XMLNode* timing = TimerManager.output_timing(doc);
+    resources->InsertEndChild(timing);
+
+    XMLNode* particle_info = doc.NewElement("particles");
+    resources->InsertEndChild(particle_info);
+    XMLNode* electron_info = doc.NewElement("particle");
+    electron_info->InsertEndChild(MakeTextElement(doc, "name", "e"));
+    electron_info->InsertEndChild(MakeTextElement(doc, "size", std::to_string(number_of_electrons)));
+    particle_info->InsertEndChild(electron_info);
+
+
+    XMLNode* run_info    = doc.NewElement("run");
+    XMLNode* driver_info = doc.NewElement("driver");
+    driver_info->InsertEndChild(MakeTextElement(doc, "name", "miniqmc_crowd"));
+    driver_info->InsertEndChild(MakeTextElement(doc, "steps", std::to_string(nsteps)));
+    driver_info->InsertEndChild(MakeTextElement(doc, "substeps", std::to_string(nsubsteps)));
+    run_info->InsertEndChild(driver_info);
+    resources->InsertEndChild(run_info);
+
+    std::string info_name =
+        "info_" + std::to_string(na) + "_" + std::to_string(nb) + "_" + std::to_string(nc) + ".xml";
+    doc.SaveFile(info_name.c_str());
+  }
+
+  return 0;
+}
@@ -0,0 +1,669 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+// -*- C++ -*-
+
+/** @file miniqmc_dmc.cpp
+    @brief Miniapp to capture the computation and the population control of DMC.
+
+  A population of lightweight walkers is advanced on a mover per thread, as
+  in the walker pool of miniqmc. Each step moves the electrons with drift and
+  diffusion, evaluates the kinetic energy and the non-local pseudopotential,
+  and updates the weight of the walker. Between the steps, the walkers are
+  branched by their weights: the walkers with no copies are kept in a reserve
+  and reused for the copies of the others, which are made by copying their
+  buffers. The weights are scaled to the target population at the branching,
+  which controls the population.
+
+  The kinetic energy of the Jastrow factors stands for the local energy, the
+  determinants of the miniapp having no physical orbitals.
+ */
+
+#include <Utilities/Configuration.h>
+#include <Utilities/Communicate.h>
+#include <Particle/ParticleSet.h>
+#include <Particle/DistanceTable.h>
+#include <Utilities/NewTimer.h>
+#include <Utilities/RandomGenerator.h>
+#include <Utilities/qmcpack_version.h>
+#include <Input/Input.hpp>
+#include <QMCWaveFunctions/SPOSet.h>
+#include <QMCWaveFunctions/SPOSet_builder.h>
+#include <QMCWaveFunctions/WaveFunction.h>
+#include <Drivers/Mover.hpp>
+#include <getopt.h>
+#include <limits>
+
+using namespace std;
+using namespace qmcplusplus;
+
+enum DMCTimers
+{
+  Timer_Total,
+  Timer_Init,
+  Timer_Diffusion,
+  Timer_ECP,
+  Timer_Value,
+  Timer_evalGrad,
+  Timer_ratioGrad,
+  Timer_Update,
+  Timer_Swap,
+  Timer_Branch,
+};
+
+TimerNameList_t<DMCTimers> DMCTimerNames = {
+    {Timer_Total, "Total"},
+    {Timer_Init, "Initialization"},
+    {Timer_Diffusion, "Diffusion"},
+    {Timer_ECP, "Pseudopotential"},
+    {Timer_Value, "Value"},
+    {Timer_evalGrad, "Current Gradient"},
+    {Timer_ratioGrad, "New Gradient"},
+    {Timer_Update, "Update"},
+    {Timer_Swap, "Walker Swap"},
+    {Timer_Branch, "Branching"},
+};
+
+void print_help()
+{
+  // clang-format off
+  app_summary() << "usage:" << '\n';
+  app_summary() << "  miniqmc_dmc   [-bfhjvV] [-g \"n0 n1 n2\"] [-m meshfactor]"  << '\n';
+  app_summary() << "                [-n steps] [-N substeps] [-r rmax] [-s seed]" << '\n';
+  app_summary() << "                [-w movers] [-W walkers] [-a tile_size]"    << '\n';
+  app_summary() << "                [-t timer_level]"                           << '\n';
+  app_summary() << "options:"                                                    << '\n';
+  app_summary() << "  -a  size of each spline tile       default: num of orbs"   << '\n';
+  app_summary() << "  -b  use reference implementations  default: off"           << '\n';
+  app_summary() << "  -f  fuse the Jastrow factors       default: off"           << '\n';
+  app_summary() << "  -g  set the 3D tiling.             default: 1 1 1"         << '\n';
+  app_summary() << "  -h  print help and exit"                                   << '\n';
+  app_summary() << "  -j  enable three body Jastrow      default: off"           << '\n';
+  app_summary() << "  -m  meshfactor                     default: 1.0"           << '\n';
+  app_summary() << "  -n  number of DMC steps            default: 5"             << '\n';
+  app_summary() << "  -N  number of MC substeps          default: 1"             << '\n';
+  app_summary() << "  -r  set the Rmax.                  default: 1.7"           << '\n';
+  app_summary() << "  -s  set the random seed.           default: 11"            << '\n';
+  app_summary() << "  -t  timer level: coarse or fine    default: fine"          << '\n';
+  app_summary() << "  -w  number of movers               default: num of threads"<< '\n';
+  app_summary() << "  -W  target number of walkers       default: 4 per mover"   << '\n';
+  app_summary() << "  -v  verbose output, per step"                              << '\n';
+  app_summary() << "  -V  print version information and exit"                    << '\n';
+  // clang-format on
+}
+
+using Walker_t = ParticleSet::Walker_t;
+
+/// settings of the DMC steps, from the command line
+struct DMCSettings
+{
+  int nsubsteps;
+  QMCTraits::RealType Rmax;
+  /// time step
+  QMCTraits::RealType tau;
+};
+
+/// kinetic energy from the gradients and laplacians of the wavefunction
+inline QMCTraits::RealType kinetic_energy(const ParticleSet& els)
+{
+  QMCTraits::RealType ke(0);
+  for (int iel = 0; iel < els.getTotalNum(); ++iel)
+    ke += dot(els.G[iel], els.G[iel]) + els.L[iel];
+  return -0.5 * ke;
+}
+
+/** advance the walker loaded in a mover by one DMC step
+ * @param mover mover holding the walker, its generator on the stream of the walker
+ * @param mc index of the step
+ * @return the local energy at the end of the step
+ */
+QMCTraits::RealType advance_dmc(Mover& mover,
+                                int mc,
+                                const DMCSettings& settings,
+                                TimerList_t& Timers)
+{
+  // clang-format off
+  typedef QMCTraits::RealType           RealType;
+  typedef ParticleSet::ParticlePos_t    ParticlePos_t;
+  typedef ParticleSet::PosType          PosType;
+  // clang-format on
+
+  auto& els          = mover.els;
+  auto& spo          = *mover.spo;
+  auto& random_th    = mover.rng;
+  auto& wavefunction = mover.wavefunction;
+  auto& ecp          = mover.nlpp;
+
+  const int nels  = els.getTotalNum();
+  const int nels3 = 3 * nels;
+
+  // this is the number of quadrature points for the non-local PP
+  const int nknots(ecp.size());
+
+  // For DMC, tau is small and should result in an acceptance ratio of 99%
+  const RealType tau     = settings.tau;
+  const RealType sqrttau = std::sqrt(tau);
+  const RealType accept  = 0.01;
+  const RealType Rmax    = settings.Rmax;
+
+  ParticlePos_t delta(nels);
+  ParticlePos_t rOnSphere(nknots);
+
+  aligned_vector<RealType> ur(nels);
+
+  Timers[Timer_Diffusion]->start();
+  for (int l = 0; l < settings.nsubsteps; ++l) // drift-and-diffusion
+  {
+    random_th.setCounter(mc, l);
+    random_th.generate_uniform(ur.data(), nels);
+    random_th.generate_normal(&delta[0][0], nels3);
+    for (int iel = 0; iel < nels; ++iel)
+    {
+      els.setActive(iel);
+      Timers[Timer_evalGrad]->start();
+      PosType grad_now = wavefunction.evalGrad(els, iel);
+      Timers[Timer_evalGrad]->stop();
+
+      // drift along the gradient and diffuse
+      PosType dr   = sqrttau * delta[iel] + tau * grad_now;
+      bool isValid = els.makeMoveAndCheck(iel, dr);
+
+      if (!isValid)
+        continue;
+
+      Timers[Timer_ratioGrad]->start();
+      PosType grad_new;
+      wavefunction.ratioGrad(els, iel, grad_new);
+      spo.evaluate_vgh(els.R[iel]);
+      Timers[Timer_ratioGrad]->stop();
+
+      if (ur[iel] > accept)
+      {
+        Timers[Timer_Update]->start();
+        wavefunction.acceptMove(els, iel);
+        Timers[Timer_Update]->stop();
+        els.acceptMove(iel);
+      }
+      else
+      {
+        els.rejectMove(iel);
+        wavefunction.restore(iel);
+      }
+    } // iel
+  }   // substeps
+
+  els.donePbyP();
+  wavefunction.evaluateGL(els);
+  Timers[Timer_Diffusion]->stop();
+
+  // Compute NLPP energy using integral over spherical points
+  ecp.myRNG.setCounter(mc, RandomStepNLPP);
+  ecp.randomize(rOnSphere); // pick random sphere
+  const DistanceTableData* d_ie = els.DistTables[wavefunction.get_ei_TableID()];
+
+  Timers[Timer_ECP]->start();
+  for (int jel = 0; jel < nels; ++jel)
+  {
+    const auto& dist  = d_ie->NeighborDistances[jel];
+    const auto& displ = d_ie->NeighborDisplacements[jel];
+    for (int inn = 0; inn < d_ie->NeighborCounts[jel]; ++inn)
+      if (dist[inn] < Rmax)
+        for (int k = 0; k < nknots; k++)
+        {
+          PosType deltar(dist[inn] * rOnSphere[k] - displ[inn]);
+
+          els.makeMoveOnSphere(jel, deltar);
+
+          Timers[Timer_Value]->start();
+          spo.evaluate_v(els.R[jel]);
+          wavefunction.ratio(els, jel);
+          Timers[Timer_Value]->stop();
+
+          els.rejectMove(jel);
+        }
+  }
+  Timers[Timer_ECP]->stop();
+
+  return kinetic_energy(els);
+}
+
+/// counts of the branching steps
+struct BranchStats
+{
+  long copies;
+  long kills;
+};
+
+/** branch the population by the walker weights
+ * @param walkers population, replaced by the branched one
+ * @param reserve walkers of no copies, reused for the copies
+ * @param ntarget target population
+ * @param rng generator of the branching
+ * @param next_id ID of the next copy
+ * @param stats counts of the copies and the kills
+ *
+ * With the weights w scaled to a total of ntarget, each walker gets
+ * int(w + u) copies, at most max_copies, and a weight of one. The copies
+ * are made by copying the buffers, in parallel.
+ */
+void branch_walkers(std::vector<Walker_t*>& walkers,
+                    std::vector<Walker_t*>& reserve,
+                    int ntarget,
+                    RandomGenerator<QMCTraits::RealType>& rng,
+                    long& next_id,
+                    BranchStats& stats)
+{
+  constexpr int max_copies = 4;
+
+  double sum_w = 0.0;
+  for (int iw = 0; iw < walkers.size(); ++iw)
+    sum_w += walkers[iw]->Weight;
+  const double scale = ntarget / sum_w;
+
+  int ntotal = 0;
+  int ibest  = 0;
+  for (int iw = 0; iw < walkers.size(); ++iw)
+  {
+    Walker_t& walker = *walkers[iw];
+    const int m = std::min(static_cast<int>(walker.Weight * scale + rng()), max_copies);
+    walker.Multiplicity = m;
+    ntotal += m;
+    if (walker.Weight > walkers[ibest]->Weight)
+      ibest = iw;
+  }
+  // never let the population die out
+  if (ntotal == 0)
+    walkers[ibest]->Multiplicity = 1;
+
+  // keep the survivors, collect the sources of the copies
+  std::vector<Walker_t*> sources;
+  int nkept = 0;
+  for (int iw = 0; iw < walkers.size(); ++iw)
+  {
+    Walker_t* walker = walkers[iw];
+    const int m      = static_cast<int>(walker->Multiplicity);
+    if (m == 0)
+    {
+      reserve.push_back(walker);
+      stats.kills++;
+      continue;
+    }
+    walker->Weight       = 1.0;
+    walker->Multiplicity = 1.0;
+    walkers[nkept++]     = walker;
+    for (int c = 1; c < m; ++c)
+      sources.push_back(walker);
+  }
+  walkers.resize(nkept);
+
+  // the copies take the walkers of the reserve first
+  const int ncopies = sources.size();
+  for (int ic = 0; ic < ncopies; ++ic)
+  {
+    if (reserve.empty())
+      walkers.push_back(new Walker_t(sources[ic]->size()));
+    else
+    {
+      walkers.push_back(reserve.back());
+      reserve.pop_back();
+    }
+  }
+
+  #pragma omp parallel for
+  for (int ic = 0; ic < ncopies; ++ic)
+  {
+    Walker_t& copy = *walkers[nkept + ic];
+    copy.makeCopy(*sources[ic]);
+    copy.ParentID = sources[ic]->ID;
+    copy.ID       = next_id + ic;
+  }
+  next_id += ncopies;
+  stats.copies += ncopies;
+}
+
+int main(int argc, char** argv)
+{
+  // clang-format off
+  typedef QMCTraits::RealType           RealType;
+  typedef ParticleSet::ParticlePos_t    ParticlePos_t;
+  typedef ParticleSet::PosType          PosType;
+  // clang-format on
+
+  Communicate comm(argc, argv);
+
+  int na     = 1;
+  int nb     = 1;
+  int nc     = 1;
+  int nsteps = 5;
+  int iseed  = 11;
+  int nx = 37, ny = 37, nz = 37;
+  int nmovers = omp_get_max_threads();
+  // target population, 0 for 4 walkers per mover
+  int ntarget = 0;
+  // thread blocking
+  int tileSize  = -1;
+  int nsubsteps = 1;
+  // Set cutoff for NLPP use.
+  RealType Rmax(1.7);
+  bool useRef   = false;
+  bool enableJ3 = false;
+  bool fuseJas  = false;
+
+
+  bool verbose                 = false;
+  std::string timer_level_name = "fine";
+
+  if (!comm.root())
+  {
+    outputManager.shutOff();
+  }
+
+  int opt;
+  while (optind < argc)
+  {
+    if ((opt = getopt(argc, argv, "bfhjvVa:g:m:n:N:r:s:t:w:W:")) != -1)
+    {
+      switch (opt)
+      {
+      case 'a':
+        tileSize = atoi(optarg);
+        break;
+      case 'b':
+        useRef = true;
+        break;
+      case 'f':
+        fuseJas = true;
+        break;
+      case 'g': // tiling1 tiling2 tiling3
+        sscanf(optarg, "%d %d %d", &na, &nb, &nc);
+        break;
+      case 'h':
+        print_help();
+        return 1;
+        break;
+      case 'j':
+        enableJ3 = true;
+        break;
+      case 'm':
+      {
+        const RealType meshfactor = atof(optarg);
+        nx *= meshfactor;
+        ny *= meshfactor;
+        nz *= meshfactor;
+      }
+      break;
+      case 'n':
+        nsteps = atoi(optarg);
+        break;
+      case 'N':
+        nsubsteps = atoi(optarg);
+        break;
+      case 'r': // rmax
+        Rmax = atof(optarg);
+        break;
+      case 's':
+        iseed = atoi(optarg);
+        break;
+      case 't':
+        timer_level_name = std::string(optarg);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      case 'V':
+        print_version(true);
+        return 1;
+        break;
+      case 'w': // number of movers
+        nmovers = atoi(optarg);
+        break;
+      case 'W': // target number of walkers
+        ntarget = atoi(optarg);
+        break;
+      default:
+        print_help();
+        return 1;
+      }
+    }
+    else // disallow non-option arguments
+    {
+      app_error() << "Non-option arguments not allowed" << endl;
+      print_help();
+    }
+  }
+
+  // a mover per thread
+  nmovers = std::max(1, std::min(nmovers, omp_get_max_threads()));
+  if (ntarget <= 0)
+    ntarget = 4 * nmovers;
+
+  Tensor<int, 3> tmat(na, 0, 0, 0, nb, 0, 0, 0, nc);
+
+  timer_levels timer_level = timer_level_fine;
+  if (timer_level_name == "coarse")
+  {
+    timer_level = timer_level_coarse;
+  }
+  else if (timer_level_name != "fine")
+  {
+    app_error() << "Timer level should be 'coarse' or 'fine', name given: " << timer_level_name
+                << endl;
+    return 1;
+  }
+
+  TimerManager.set_timer_threshold(timer_level);
+  TimerList_t Timers;
+  setup_timers(Timers, DMCTimerNames, timer_level_coarse);
+
+  if (comm.root())
+  {
+    if (verbose)
+      outputManager.setVerbosity(Verbosity::HIGH);
+    else
+      outputManager.setVerbosity(Verbosity::LOW);
+  }
+
+  print_version(verbose);
+
+  SPOSet* spo_main;
+  int nTiles = 1;
+
+  ParticleSet ions;
+  // initialize ions and splines which are shared by all threads later
+  {
+    Tensor<OHMMS_PRECISION, 3> lattice_b;
+    build_ions(ions, tmat, lattice_b);
+    const int nels = count_electrons(ions, 1);
+    const int norb = nels / 2;
+    tileSize       = (tileSize > 0) ? tileSize : norb;
+    nTiles         = norb / tileSize;
+
+    const size_t SPO_coeff_size =
+        static_cast<size_t>(norb) * (nx + 3) * (ny + 3) * (nz + 3) * sizeof(RealType);
+    const double SPO_coeff_size_MB = SPO_coeff_size * 1.0 / 1024 / 1024;
+
+    app_summary() << "Number of orbitals/splines = " << norb << endl
+                  << "Tile size = " << tileSize << endl
+                  << "Number of tiles = " << nTiles << endl
+                  << "Number of electrons = " << nels << endl
+                  << "Rmax = " << Rmax << endl;
+    app_summary() << "Iterations = " << nsteps << endl;
+    app_summary() << "Movers = " << nmovers << endl;
+    app_summary() << "Target walkers = " << ntarget << endl;
+    app_summary() << "OpenMP threads = " << omp_get_max_threads() << endl;
+#ifdef HAVE_MPI
+    app_summary() << "MPI processes = " << comm.size() << endl;
+#endif
+
+    app_summary() << "\nSPO coefficients size = " << SPO_coeff_size << " bytes ("
+                  << SPO_coeff_size_MB << " MB)" << endl;
+
+    spo_main = build_SPOSet(useRef, nx, ny, nz, norb, nTiles, lattice_b);
+  }
+
+  if (!useRef)
+    app_summary() << "Using SoA distance table, Jastrow + einspline, " << endl
+                  << "and determinant update." << endl;
+  else
+    app_summary() << "Using the reference implementation for Jastrow, " << endl
+                  << "determinant update, and distance table + einspline of the " << endl
+                  << "reference implementation " << endl;
+
+  DMCSettings settings;
+  settings.nsubsteps = nsubsteps;
+  settings.Rmax      = Rmax;
+  settings.tau       = 0.01;
+
+  Timers[Timer_Total]->start();
+
+  Timers[Timer_Init]->start();
+  std::vector<Mover*> mover_list(nmovers, nullptr);
+  // prepare movers
+  #pragma omp parallel for num_threads(nmovers)
+  for (int iw = 0; iw < nmovers; iw++)
+  {
+    // create and initialize movers
+    Mover* thiswalker = new Mover(iseed, iw, ions);
+    mover_list[iw]    = thiswalker;
+
+    // create a spo view in each Mover
+    thiswalker->spo = build_SPOSet_view(useRef, spo_main, 1, 0);
+
+    // create wavefunction per mover
+    build_WaveFunction(useRef,
+                       thiswalker->wavefunction,
+                       ions,
+                       thiswalker->els,
+                       thiswalker->rng,
+                       enableJ3,
+                       fuseJas);
+
+    // NLPP only visits the ions within Rmax
+    thiswalker->els.DistTables[thiswalker->wavefunction.get_ei_TableID()]->requestNeighborList(
+        Rmax);
+
+    // initial computing
+    thiswalker->els.update();
+    thiswalker->wavefunction.evaluateLog(thiswalker->els);
+  }
+
+  // the initial walkers start from their own streams, staged in the mover of the thread
+  std::vector<Walker_t*> walkers(ntarget, nullptr);
+  #pragma omp parallel for num_threads(nmovers)
+  for (int iw = 0; iw < ntarget; iw++)
+  {
+    Mover& mover = *mover_list[omp_get_thread_num()];
+    mover.startWalker(iseed, iw);
+    walkers[iw]                             = new Walker_t(mover.els.getTotalNum());
+    walkers[iw]->ID                         = iw;
+    walkers[iw]->Properties(0, LOCALENERGY) = kinetic_energy(mover.els);
+    mover.els.saveWalker(*walkers[iw]);
+    mover.els.registerData(walkers[iw]->DataSet);
+    mover.wavefunction.registerData(mover.els, walkers[iw]->DataSet);
+  }
+  Timers[Timer_Init]->stop();
+
+  std::vector<Walker_t*> reserve;
+  // the branching has a stream of its own, past those of the walker IDs
+  RandomGenerator<RealType> branch_rng(iseed, std::numeric_limits<uint32_t>::max());
+  long next_id = ntarget;
+
+  // reference energy of the weights, the average of the last step
+  RealType e_ref = walkers[0]->Properties(0, LOCALENERGY);
+
+  double advance_time = 0.0, branch_time = 0.0;
+  long walker_steps   = 0;
+  int min_pop = ntarget, max_pop = ntarget;
+  BranchStats stats = {0, 0};
+
+  for (int mc = 0; mc < nsteps; ++mc)
+  {
+    // advance the population
+    const int nw  = walkers.size();
+    double t0     = omp_get_wtime();
+    double sum_w  = 0.0;
+    double sum_we = 0.0;
+    #pragma omp parallel for num_threads(nmovers) reduction(+ : sum_w, sum_we)
+    for (int iw = 0; iw < nw; iw++)
+    {
+      Mover& mover     = *mover_list[omp_get_thread_num()];
+      Walker_t& walker = *walkers[iw];
+
+      Timers[Timer_Swap]->start();
+      mover.els.loadWalker(walker, false);
+      walker.DataSet.rewind();
+      mover.els.copyFromBuffer(walker.DataSet);
+      mover.wavefunction.copyFromBuffer(mover.els, walker.DataSet);
+      mover.rng.setStream(walker.ID);
+      mover.nlpp.myRNG.setStream(walker.ID);
+      Timers[Timer_Swap]->stop();
+
+      const RealType e_old = walker.Properties(0, LOCALENERGY);
+      const RealType e_new = advance_dmc(mover, mc, settings, Timers);
+      walker.Weight *= std::exp(-settings.tau * (0.5 * (e_old + e_new) - e_ref));
+      walker.Properties(0, LOCALENERGY) = e_new;
+      walker.Properties(0, LOGPSI)      = mover.wavefunction.getLogValue();
+      walker.Age++;
+      sum_w += walker.Weight;
+      sum_we += walker.Weight * e_new;
+
+      Timers[Timer_Swap]->start();
+      mover.els.saveWalker(walker);
+      walker.DataSet.rewind();
+      mover.els.copyToBuffer(walker.DataSet);
+      mover.wavefunction.copyToBuffer(mover.els, walker.DataSet);
+      Timers[Timer_Swap]->stop();
+    } // end of walker loop
+    advance_time += omp_get_wtime() - t0;
+    walker_steps += nw;
+
+    // branch and restore the target population
+    Timers[Timer_Branch]->start();
+    t0 = omp_get_wtime();
+    branch_walkers(walkers, reserve, ntarget, branch_rng, next_id, stats);
+    branch_time += omp_get_wtime() - t0;
+    Timers[Timer_Branch]->stop();
+
+    const int npop = walkers.size();
+    e_ref          = sum_we / sum_w;
+    min_pop        = std::min(min_pop, npop);
+    max_pop        = std::max(max_pop, npop);
+    if (verbose)
+      app_summary() << "step " << mc << " walkers = " << npop << " E_ref = " << e_ref << endl;
+  } // end of step loop
+  Timers[Timer_Total]->stop();
+
+  app_summary() << "\nWalker-steps = " << walker_steps << endl
+                << "Advance time = " << advance_time << " s, throughput = "
+                << walker_steps / advance_time << " walker-steps/s" << endl
+                << "Branching time = " << branch_time << " s ("
+                << 100.0 * branch_time / (advance_time + branch_time) << "% of the steps), "
+                << "copies = " << stats.copies << ", kills = " << stats.kills << endl
+                << "Population: final = " << walkers.size() << ", min = " << min_pop
+                << ", max = " << max_pop << ", reserve = " << reserve.size() << endl
+                << "E_ref = " << e_ref << endl;
+
+  if (comm.root())
+  {
+    cout << "================================== " << endl;
+    TimerManager.print();
+  }
+
+  // free all movers and walkers
+  for (int iw = 0; iw < mover_list.size(); iw++)
+    delete mover_list[iw];
+  for (int iw = 0; iw < walkers.size(); iw++)
+    delete walkers[iw];
+  for (int iw = 0; iw < reserve.size(); iw++)
+    delete reserve[iw];
+  delete spo_main;
+
+  return 0;
+}
@@ -106,7 +106,6 @@
 #include <Utilities/Communicate.h>
 #include <Particle/ParticleSet.h>
 #include <Particle/DistanceTable.h>
-#include <Utilities/PrimeNumberSet.h>
 #include <Utilities/NewTimer.h>
 #include <Utilities/XMLWriter.h>
 #include <Utilities/RandomGenerator.h>
@@ -116,6 +115,7 @@
 #include <QMCWaveFunctions/SPOSet_builder.h>
 #include <QMCWaveFunctions/WaveFunction.h>
 #include <Drivers/Mover.hpp>
+#include <Drivers/Crowd.hpp>
 #include <getopt.h>
 
 using namespace std;
@@ -131,6 +131,7 @@ enum MiniQMCTimers
   Timer_evalGrad,
   Timer_ratioGrad,
   Timer_Update,
+  Timer_Reorder,
 };
 
 TimerNameList_t<MiniQMCTimers> MiniQMCTimerNames = {
@@ -142,24 +143,28 @@ TimerNameList_t<MiniQMCTimers> MiniQMCTimerNames = {
     {Timer_evalGrad, "Current Gradient"},
     {Timer_ratioGrad, "New Gradient"},
     {Timer_Update, "Update"},
+    {Timer_Reorder, "Reorder"},
 };
 
 void print_help()
 {
   // clang-format off
   app_summary() << "usage:" << '\n';
-  app_summary() << "  miniqmc   [-hjvV] [-g \"n0 n1 n2\"] [-m meshfactor]"       << '\n';
+  app_summary() << "  miniqmc   [-fhjvV] [-g \"n0 n1 n2\"] [-m meshfactor]"      << '\n';
   app_summary() << "            [-n steps] [-N substeps] [-r rmax] [-s seed]"    << '\n';
   app_summary() << "            [-w walkers] [-a tile_size] [-t timer_level]"    << '\n';
+  app_summary() << "            [-o reorder_interval]"                           << '\n';
   app_summary() << "options:"                                                    << '\n';
   app_summary() << "  -a  size of each spline tile       default: num of orbs"   << '\n';
   app_summary() << "  -b  use reference implementations  default: off"           << '\n';
+  app_summary() << "  -f  fuse the Jastrow factors       default: off"           << '\n';
   app_summary() << "  -g  set the 3D tiling.             default: 1 1 1"         << '\n';
   app_summary() << "  -h  print help and exit"                                   << '\n';
   app_summary() << "  -j  enable three body Jastrow      default: off"           << '\n';
   app_summary() << "  -m  meshfactor                     default: 1.0"           << '\n';
   app_summary() << "  -n  number of MC steps             default: 5"             << '\n';
   app_summary() << "  -N  number of MC substeps          default: 1"             << '\n';
+  app_summary() << "  -o  Morton reorder every o steps   default: 0 (off)"       << '\n';
   app_summary() << "  -r  set the Rmax.                  default: 1.7"           << '\n';
   app_summary() << "  -s  set the random seed.           default: 11"            << '\n';
   app_summary() << "  -t  timer level: coarse or fine    default: fine"          << '\n';
@@ -194,12 +199,14 @@ int main(int argc, char** argv)
   int tileSize  = -1;
   int team_size = 1;
   int nsubsteps = 1;
+  // sort particles by Morton key every reorder_interval steps, 0 for off
+  int reorder_interval = 0;
   // Set cutoff for NLPP use.
   RealType Rmax(1.7);
   bool useRef   = false;
   bool enableJ3 = false;
+  bool fuseJas  = false;
 
-  PrimeNumberSet<uint32_t> myPrimes;
 
   bool verbose                 = false;
   std::string timer_level_name = "fine";
@@ -212,7 +219,7 @@ int main(int argc, char** argv)
   int opt;
   while (optind < argc)
   {
-    if ((opt = getopt(argc, argv, "bhjvVa:c:g:m:n:N:r:s:w:t:")) != -1)
+    if ((opt = getopt(argc, argv, "bfhjvVa:c:g:m:n:N:o:r:s:w:t:")) != -1)
     {
       switch (opt)
       {
@@ -225,6 +232,9 @@ int main(int argc, char** argv)
       case 'c': // number of members per team
         team_size = atoi(optarg);
         break;
+      case 'f':
+        fuseJas = true;
+        break;
       case 'g': // tiling1 tiling2 tiling3
         sscanf(optarg, "%d %d %d", &na, &nb, &nc);
         break;
@@ -249,6 +259,9 @@ int main(int argc, char** argv)
       case 'N':
         nsubsteps = atoi(optarg);
         break;
+      case 'o':
+        reorder_interval = atoi(optarg);
+        break;
       case 'r': // rmax
         Rmax = atof(optarg);
         break;
@@ -318,6 +331,11 @@ int main(int argc, char** argv)
   {
     Tensor<OHMMS_PRECISION, 3> lattice_b;
     build_ions(ions, tmat, lattice_b);
+    if (reorder_interval > 0)
+    {
+      std::vector<int> new2old;
+      ions.sortByMorton(new2old);
+    }
     const int nels = count_electrons(ions, 1);
     const int norb = nels / 2;
     tileSize       = (tileSize > 0) ? tileSize : norb;
@@ -366,34 +384,47 @@ int main(int argc, char** argv)
     const int member_id = ip % team_size;
 
     // create and initialize movers
-    Mover* thiswalker = new Mover(myPrimes[ip], ions);
+    Mover* thiswalker = new Mover(iseed, iw, ions);
     mover_list[iw]    = thiswalker;
 
+    if (reorder_interval > 0)
+    {
+      std::vector<int> new2old;
+      thiswalker->els.sortByMorton(new2old);
+    }
+
     // create a spo view in each Mover
     thiswalker->spo = build_SPOSet_view(useRef, spo_main, team_size, member_id);
 
     // create wavefunction per mover
-    build_WaveFunction(useRef, thiswalker->wavefunction, ions, thiswalker->els, thiswalker->rng, enableJ3);
+    build_WaveFunction(useRef, thiswalker->wavefunction, ions, thiswalker->els, thiswalker->rng, enableJ3, fuseJas);
+
+    // NLPP only visits the ions within Rmax
+    thiswalker->els.DistTables[thiswalker->wavefunction.get_ei_TableID()]->requestNeighborList(Rmax);
 
     // initial computing
     thiswalker->els.update();
   }
 
-  { // initial computing
-    const std::vector<ParticleSet*> P_list(extract_els_list(mover_list));
-    const std::vector<WaveFunction*> WF_list(extract_wf_list(mover_list));
-    mover_list[0]->wavefunction.multi_evaluateLog(WF_list, P_list);
-  }
+  // lists and scratch of the movers, kept for the whole run
+  Crowd crowd(mover_list);
+
+  // initial computing
+  mover_list[0]->wavefunction.multi_evaluateLog(crowd.WF_list, crowd.P_list, crowd.wf_scratch);
   Timers[Timer_Init]->stop();
 
-  const int nions    = ions.getTotalNum();
   const int nels     = mover_list[0]->els.getTotalNum();
   const int nels3    = 3 * nels;
-  const int nmovers3 = 3 * nmovers;
 
   // this is the number of qudrature points for the non-local PP
   const int nknots(mover_list[0]->nlpp.size());
 
+  // number of the NLPP virtual moves per batch of orbital evaluations
+  const int nlpp_batch = 64;
+  // the orbitals of spo_main fill the rows of both determinants
+  if (nels - nels / 2 > spo_main->size())
+    APP_ABORT("miniqmc_sync_move needs an even number of electrons for the NLPP orbitals");
+
   // For VMC, tau is large and should result in an acceptance ratio of roughly
   // 50%
   // For DMC, tau is small and should result in an acceptance ratio of 99%
@@ -404,25 +435,24 @@ int main(int argc, char** argv)
 
   // synchronous walker moves
   {
-    std::vector<PosType> delta(nmovers);
-    std::vector<PosType> pos_list(nmovers);
-    std::vector<GradType> grad_now(nmovers);
-    std::vector<GradType> grad_new(nmovers);
-    std::vector<ValueType> ratios(nmovers);
-    aligned_vector<RealType> ur(nmovers);
-    /// masks for movers with valid moves
-    std::vector<int> isValid(nmovers);
+    const std::vector<ParticleSet*>& P_list(crowd.P_list);
+    const std::vector<WaveFunction*>& WF_list(crowd.WF_list);
+    const std::vector<ParticleSet*>& valid_P_list(crowd.valid_P_list);
+    const std::vector<SPOSet*>& valid_spo_list(crowd.valid_spo_list);
+    const std::vector<WaveFunction*>& valid_WF_list(crowd.valid_WF_list);
+    const std::vector<Mover*>& valid_mover_list(crowd.valid_movers);
+    std::vector<bool>& isAccepted(crowd.isAccepted);
+    MultiWaveFunctionScratch& wf_scratch(crowd.wf_scratch);
 
     for (int mc = 0; mc < nsteps; ++mc)
     {
       Timers[Timer_Diffusion]->start();
 
-      const std::vector<ParticleSet*> P_list(extract_els_list(mover_list));
-      const std::vector<WaveFunction*> WF_list(extract_wf_list(mover_list));
       const Mover& anon_mover = *mover_list[0];
 
       for (int l = 0; l < nsubsteps; ++l) // drift-and-diffusion
       {
+        crowd.drawSubstep(mc, l);
         for (int iel = 0; iel < nels; ++iel)
         {
 	  // Operate on electron with index iel
@@ -432,46 +462,42 @@ int main(int argc, char** argv)
 
           // Compute gradient at the current position
           Timers[Timer_evalGrad]->start();
-          anon_mover.wavefunction.multi_evalGrad(WF_list, P_list, iel, grad_now);
+          anon_mover.wavefunction.multi_evalGrad(WF_list, P_list, iel, crowd.grad_now, wf_scratch);
           Timers[Timer_evalGrad]->stop();
 
           // Construct trial move
-          mover_list[0]->rng.generate_uniform(ur.data(), nmovers);
-          mover_list[0]->rng.generate_normal(&delta[0][0], nmovers3);
-
-          #pragma omp parallel for
           for (int iw = 0; iw < nmovers; iw++)
-          {
-            PosType dr  = sqrttau * delta[iw];
-            isValid[iw] = mover_list[iw]->els.makeMoveAndCheck(iel, dr);
-          }
+            crowd.delta[iw] = sqrttau * crowd.substep_delta[iw * nels + iel];
+          mover_list[0]->els.multi_makeMoveAndCheck(P_list, iel, crowd.delta, crowd.isValid);
 
-          std::vector<Mover*> valid_mover_list(filtered_list(mover_list, isValid));
-          std::vector<bool> isAccepted(valid_mover_list.size());
-
-          const std::vector<ParticleSet*> valid_P_list(extract_els_list(valid_mover_list));
-          const std::vector<SPOSet*> valid_spo_list(extract_spo_list(valid_mover_list));
-          const std::vector<WaveFunction*> valid_WF_list(extract_wf_list(valid_mover_list));
+          crowd.filterValid();
 
           // Compute gradient at the trial position
           Timers[Timer_ratioGrad]->start();
-          anon_mover.wavefunction.multi_ratioGrad(valid_WF_list, valid_P_list, iel, ratios, grad_new);
+          anon_mover.wavefunction.multi_ratioGrad(valid_WF_list,
+                                                  valid_P_list,
+                                                  iel,
+                                                  crowd.ratios,
+                                                  crowd.grad_new,
+                                                  wf_scratch);
 
           for (int iw = 0; iw < valid_mover_list.size(); iw++)
-            pos_list[iw] = valid_mover_list[iw]->els.R[iel];
-          anon_mover.spo->multi_evaluate_vgh(valid_spo_list, pos_list);
+            crowd.pos_list[iw] = valid_mover_list[iw]->els.R[iel];
+          anon_mover.spo->multi_evaluate_vgh(valid_spo_list, crowd.pos_list);
           Timers[Timer_ratioGrad]->stop();
 
           // Accept/reject the trial move
-          for (int iw = 0; iw < valid_mover_list.size(); iw++)
-            if (ur[iw] > accept)
-              isAccepted[iw] = true;
-            else
-              isAccepted[iw] = false;
+          for (int iw = 0, iv = 0; iw < nmovers; iw++)
+            if (crowd.isValid[iw])
+              isAccepted[iv++] = crowd.substep_ur[iw * nels + iel] > accept;
 
           Timers[Timer_Update]->start();
           // update WF storage
-          anon_mover.wavefunction.multi_acceptrestoreMove(valid_WF_list, valid_P_list, isAccepted, iel);
+          anon_mover.wavefunction.multi_acceptrestoreMove(valid_WF_list,
+                                                          valid_P_list,
+                                                          isAccepted,
+                                                          iel,
+                                                          wf_scratch);
           Timers[Timer_Update]->stop();
 
           // Update position
@@ -492,47 +518,153 @@ int main(int argc, char** argv)
         mover_list[iw]->els.donePbyP();
         // evaluate Kinetic Energy
       }
-      anon_mover.wavefunction.multi_evaluateGL(WF_list, P_list);
+      anon_mover.wavefunction.multi_evaluateGL(WF_list, P_list, wf_scratch);
 
       Timers[Timer_Diffusion]->stop();
 
       // Compute NLPP energy using integral over spherical points
-      // Ye: I have not found a strategy for NLPP
+      // The virtual moves of all the movers are gathered in a work list. The
+      // orbitals are evaluated in batches of positions sorted by grid cell and
+      // give the ratios of the determinants, then each mover multiplies the
+      // ratios of its own moves by those of the Jastrow factors.
       Timers[Timer_ECP]->start();
-      #pragma omp parallel for
-      for (int iw = 0; iw < nmovers; iw++)
       {
-        auto& els          = mover_list[iw]->els;
-        auto& spo          = *mover_list[iw]->spo;
-        auto& wavefunction = mover_list[iw]->wavefunction;
-        auto& ecp          = mover_list[iw]->nlpp;
+        std::vector<int>& first(crowd.nlpp_first);
+        first.resize(nmovers * (nels + 1));
 
-        ParticlePos_t rOnSphere(nknots);
-        ecp.randomize(rOnSphere); // pick random sphere
-        const DistanceTableData* d_ie = els.DistTables[wavefunction.get_ei_TableID()];
+        // pick random spheres and count the moves per electron
+        #pragma omp parallel for
+        for (int iw = 0; iw < nmovers; iw++)
+        {
+          auto& els                     = mover_list[iw]->els;
+          const DistanceTableData* d_ie = els.DistTables[mover_list[iw]->wavefunction.get_ei_TableID()];
 
-        for (int jel = 0; jel < els.getTotalNum(); ++jel)
+          crowd.nlpp_knots[iw].resize(nknots);
+          mover_list[iw]->nlpp.myRNG.setCounter(mc, RandomStepNLPP);
+          mover_list[iw]->nlpp.randomize(crowd.nlpp_knots[iw]);
+          for (int jel = 0; jel < nels; ++jel)
+          {
+            const auto& dist = d_ie->NeighborDistances[jel];
+            int nmoves       = 0;
+            for (int inn = 0; inn < d_ie->NeighborCounts[jel]; ++inn)
+              if (dist[inn] < Rmax)
+                nmoves += nknots;
+            first[iw * (nels + 1) + jel] = nmoves;
+          }
+        }
+
+        int nmoves = 0;
+        for (int iw = 0; iw < nmovers; iw++)
+        {
+          for (int jel = 0; jel < nels; ++jel)
+          {
+            const int n                  = first[iw * (nels + 1) + jel];
+            first[iw * (nels + 1) + jel] = nmoves;
+            nmoves += n;
+          }
+          first[iw * (nels + 1) + nels] = nmoves;
+        }
+        crowd.nlpp_delta.resize(nmoves);
+        crowd.nlpp_pos.resize(nmoves);
+        crowd.nlpp_cell.resize(nmoves);
+        crowd.nlpp_owner.resize(nmoves);
+        crowd.nlpp_order.resize(nmoves);
+        crowd.nlpp_sorted_pos.resize(nmoves);
+        crowd.nlpp_ratios.resize(nmoves);
+
+        // fill the work list
+        #pragma omp parallel for
+        for (int iw = 0; iw < nmovers; iw++)
+        {
+          const auto& els               = mover_list[iw]->els;
+          const auto& rOnSphere         = crowd.nlpp_knots[iw];
+          const DistanceTableData* d_ie = els.DistTables[mover_list[iw]->wavefunction.get_ei_TableID()];
+
+          int m = first[iw * (nels + 1)];
+          for (int jel = 0; jel < nels; ++jel)
+          {
+            const auto& dist  = d_ie->NeighborDistances[jel];
+            const auto& displ = d_ie->NeighborDisplacements[jel];
+            for (int inn = 0; inn < d_ie->NeighborCounts[jel]; ++inn)
+              if (dist[inn] < Rmax)
+                for (int k = 0; k < nknots; k++, m++)
+                {
+                  crowd.nlpp_delta[m] = PosType(dist[inn] * rOnSphere[k] - displ[inn]);
+                  crowd.nlpp_pos[m]   = els.R[jel] + crowd.nlpp_delta[m];
+                  crowd.nlpp_order[m] = m;
+                  crowd.nlpp_cell[m]  = spo_main->cellIndex(crowd.nlpp_pos[m]);
+                  crowd.nlpp_owner[m] = iw * nels + jel;
+                }
+          }
+        }
+
+        // evaluate the moves in the order of their grid cells, so the
+        // consecutive positions of a batch share the spline coefficients
+        const std::vector<int>& cell(crowd.nlpp_cell);
+        std::sort(crowd.nlpp_order.begin(), crowd.nlpp_order.end(), [&cell](int a, int b) {
+          return cell[a] < cell[b];
+        });
+        #pragma omp parallel for
+        for (int i = 0; i < nmoves; i++)
+          crowd.nlpp_sorted_pos[i] = crowd.nlpp_pos[crowd.nlpp_order[i]];
+
+        Timers[Timer_Value]->start();
+        // evaluate the orbitals at the moved positions, a batch at a time, and
+        // scatter the ratios of the determinants to the moves
+        #pragma omp parallel
+        {
+          const int norb = spo_main->size();
+          aligned_vector<ValueType> psi(nlpp_batch * norb);
+          #pragma omp for
+          for (int im = 0; im < nmoves; im += nlpp_batch)
+          {
+            const int nb = std::min(nlpp_batch, nmoves - im);
+            spo_main->evaluate_v_batch(crowd.nlpp_sorted_pos.data() + im, nb, psi.data());
+            for (int k = 0; k < nb; k++)
+            {
+              const int m   = crowd.nlpp_order[im + k];
+              const int iw  = crowd.nlpp_owner[m] / nels;
+              const int jel = crowd.nlpp_owner[m] % nels;
+              crowd.nlpp_ratios[m] =
+                  mover_list[iw]->wavefunction.ratioFromOrbitals(jel, psi.data() + k * norb);
+            }
+          }
+        }
+
+        // multiply by the ratios of the Jastrow factors, each mover going
+        // through its own moves
+        #pragma omp parallel for
+        for (int iw = 0; iw < nmovers; iw++)
         {
-          const auto& dist  = d_ie->Distances[jel];
-          const auto& displ = d_ie->Displacements[jel];
-          for (int iat = 0; iat < nions; ++iat)
-            if (dist[iat] < Rmax)
-              for (int k = 0; k < nknots; k++)
-              {
-                PosType deltar(dist[iat] * rOnSphere[k] - displ[iat]);
-
-                els.makeMoveOnSphere(jel, deltar);
-
-                Timers[Timer_Value]->start();
-                spo.evaluate_v(els.R[jel]);
-                wavefunction.ratio(els, jel);
-                Timers[Timer_Value]->stop();
-
-                els.rejectMove(jel);
-              }
+          auto& els          = mover_list[iw]->els;
+          auto& wavefunction = mover_list[iw]->wavefunction;
+
+          for (int jel = 0; jel < nels; ++jel)
+            for (int m = first[iw * (nels + 1) + jel]; m < first[iw * (nels + 1) + jel + 1]; m++)
+            {
+              els.makeMoveOnSphere(jel, crowd.nlpp_delta[m]);
+              crowd.nlpp_ratios[m] *= wavefunction.ratioJastrow(els, jel);
+              els.rejectMove(jel);
+            }
         }
+        Timers[Timer_Value]->stop();
       }
       Timers[Timer_ECP]->stop();
+
+      if (reorder_interval > 0 && (mc + 1) % reorder_interval == 0)
+      {
+        Timers[Timer_Reorder]->start();
+        #pragma omp parallel for
+        for (int iw = 0; iw < nmovers; iw++)
+        {
+          auto& els = mover_list[iw]->els;
+          std::vector<int> new2old;
+          els.sortByMorton(new2old);
+          els.update();
+          mover_list[iw]->wavefunction.reorderParticles(els, new2old);
+        }
+        Timers[Timer_Reorder]->stop();
+      }
     } // nsteps
   }
   Timers[Timer_Total]->stop();
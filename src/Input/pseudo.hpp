@@ -40,11 +40,16 @@ struct NonLocalPP
   std::vector<RealType> weight_m;
   /** positions on a sphere */
   std::vector<PosType> sgridxyz_m;
-  /** default constructor with knots=12 */
+  /** constructor with knots=12
+   * @param rng generator of the walker, whose seed and stream key the rotations
+   *
+   * A driver restarts myRNG at setCounter(step, RandomStepNLPP) for the
+   * rotations of each step, and follows the walker with setStream when the
+   * walkers are swapped through the movers.
+   */
   NonLocalPP(const RandomGenerator<RealType>& rng) : myRNG(rng)
   {
-    // use fixed seed
-    myRNG.init(0, 1, 11);
+    myRNG.setCounter(RandomInitStep, RandomInitNLPP);
     weight_m.resize(12);
     sgridxyz_m.resize(12);
     const RealType w = RealType(1.0 / 12.0);
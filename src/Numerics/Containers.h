@@ -207,7 +207,8 @@ struct VectorSoAContainer
     size_t M;
     T* _base;
     __forceinline Accessor(T* a, size_t ng) : _base(a), M(ng) {}
-    __forceinline Accessor& operator=(const TinyVector<T, D>& rhs)
+    template<typename T1>
+    __forceinline Accessor& operator=(const TinyVector<T1, D>& rhs)
     {
 #pragma unroll
       for (size_t i = 0; i < D; ++i)
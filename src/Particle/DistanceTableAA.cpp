@@ -46,8 +46,21 @@ DistanceTableData* createDistanceTable(ParticleSet& s, int dt_type)
   o << "  Distance table for AA: source/target = " << s.getName() << " useSoA =" << useSoA << "\n";
   if (sc == SUPERCELL_BULK)
   {
-    o << "  Using SoaDistanceTableAA<T,D,PPPG> of SoA layout " << PPPG << std::endl;
-    dt = new DistanceTableAA<RealType, DIM, PPPG + SOA_OFFSET>(s);
+    if (s.Lattice.DiagonalOnly)
+    {
+      o << "  Using SoaDistanceTableAA<T,D,PPPO> of SoA layout " << PPPO << std::endl;
+      dt = new DistanceTableAA<RealType, DIM, PPPO + SOA_OFFSET>(s);
+    }
+    else if (s.Lattice.WignerSeitzRadius > s.Lattice.SimulationCellRadius)
+    {
+      o << "  Using SoaDistanceTableAA<T,D,PPPG> of SoA layout " << PPPG << std::endl;
+      dt = new DistanceTableAA<RealType, DIM, PPPG + SOA_OFFSET>(s);
+    }
+    else
+    {
+      o << "  Using SoaDistanceTableAA<T,D,PPPS> of SoA layout " << PPPS << std::endl;
+      dt = new DistanceTableAA<RealType, DIM, PPPS + SOA_OFFSET>(s);
+    }
     o << "\n    Setting Rmax = " << s.Lattice.SimulationCellRadius;
   }
   else
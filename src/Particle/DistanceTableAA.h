@@ -18,6 +18,7 @@
 #ifndef QMCPLUSPLUS_DTDIMPL_AA_H
 #define QMCPLUSPLUS_DTDIMPL_AA_H
 #include "Utilities/SIMD/algorithm.hpp"
+#include "Utilities/WalkerTeam.h"
 
 namespace qmcplusplus
 {
@@ -30,6 +31,9 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
   int Ntargets;
   int Ntargets_padded;
   int BlockSize;
+  /// full-row scratch of each member of the walker team in evaluate
+  std::vector<aligned_vector<DistRealType>> team_r;
+  std::vector<RowContainer> team_dr;
 
   DistanceTableAA(ParticleSet& target)
       : DTD_BConds<T, D, SC>(target.Lattice), DistanceTableData(target, target)
@@ -43,8 +47,8 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
 
   size_t compute_size(int N)
   {
-    const size_t N_padded  = getAlignedSize<T>(N);
-    const size_t Alignment = getAlignment<T>();
+    const size_t N_padded  = getAlignedSize<DistRealType>(N);
+    const size_t Alignment = getAlignment<DistRealType>();
     return (N_padded * (2 * N - N_padded + 1) + (Alignment - 1) * N_padded) / 2;
   }
 
@@ -53,7 +57,7 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
     N[SourceIndex]  = n;
     N[VisitorIndex] = n;
     Ntargets        = n;
-    Ntargets_padded = getAlignedSize<T>(n);
+    Ntargets_padded = getAlignedSize<DistRealType>(n);
     Distances.resize(Ntargets, Ntargets_padded);
     const size_t total_size = compute_size(Ntargets);
     memoryPool.resize(total_size * D);
@@ -67,7 +71,13 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
 
   inline void evaluate(ParticleSet& P)
   {
-    constexpr T BigR = std::numeric_limits<T>::max();
+    constexpr DistRealType BigR = std::numeric_limits<DistRealType>::max();
+    const int nt                = getWalkerTeamSize(P.WalkerTeamSize, Ntargets);
+    if (nt > 1)
+    {
+      evaluateTeam(P, nt);
+      return;
+    }
     // P.RSoA.copyIn(P.R);
     for (int iat = 0; iat < Ntargets; ++iat)
     {
@@ -82,6 +92,52 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
     }
   }
 
+  /** evaluate the full table by a walker team of nt members, each owning a block of rows
+   *
+   * A row of Displacements overlaps the following rows beyond its capacity,
+   * which the serial build fills in order. The members write the capacity
+   * of their rows only, and compute the rest of the distances in their
+   * scratch, leaving the same table as the serial build.
+   */
+  inline void evaluateTeam(ParticleSet& P, int nt)
+  {
+    constexpr DistRealType BigR = std::numeric_limits<DistRealType>::max();
+    team_r.resize(nt);
+    team_dr.resize(nt);
+#pragma omp parallel num_threads(nt)
+    {
+      const int ip = omp_get_thread_num();
+      team_r[ip].resize(Ntargets);
+      team_dr[ip].resize(Ntargets);
+      int first, last;
+      getWalkerTeamRange(Ntargets, ip, nt, first, last);
+      for (int iat = first; iat < last; ++iat)
+      {
+        const size_t capacity = compute_size(iat + 1) - compute_size(iat);
+        const int ncap        = std::min(static_cast<size_t>(Ntargets), capacity);
+        DTD_BConds<T, D, SC>::computeDistances(P.R[iat],
+                                               P.RSoA,
+                                               Distances[iat],
+                                               Displacements[iat],
+                                               0,
+                                               ncap,
+                                               iat);
+        if (ncap < Ntargets)
+        {
+          DTD_BConds<T, D, SC>::computeDistances(P.R[iat],
+                                                 P.RSoA,
+                                                 team_r[ip].data(),
+                                                 team_dr[ip],
+                                                 ncap,
+                                                 Ntargets,
+                                                 iat);
+          std::copy(team_r[ip].data() + ncap, team_r[ip].data() + Ntargets, Distances[iat] + ncap);
+        }
+        Distances[iat][iat] = BigR; // assign big distance
+      }
+    }
+  }
+
   inline void evaluate(ParticleSet& P, IndexType jat)
   {
     DTD_BConds<T, D, SC>::computeDistances(P.R[jat],
@@ -91,7 +147,7 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
                                            0,
                                            Ntargets,
                                            jat);
-    Distances[jat][jat] = std::numeric_limits<T>::max(); // assign a big number
+    Distances[jat][jat] = std::numeric_limits<DistRealType>::max(); // assign a big number
   }
 
   inline void moveOnSphere(const ParticleSet& P, const PosType& rnew)
@@ -99,11 +155,49 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
     DTD_BConds<T, D, SC>::computeDistances(rnew, P.RSoA, Temp_r.data(), Temp_dr, 0, Ntargets, P.activePtcl);
   }
 
-  /// evaluate the temporary pair relations
+  /// evaluate the temporary pair relations, split over the walker team
   inline void move(const ParticleSet& P, const PosType& rnew)
   {
-    //#pragma omp master
-    moveOnSphere(P, rnew);
+    const int nt = getWalkerTeamSize(P.WalkerTeamSize, Ntargets);
+    if (nt == 1)
+    {
+      moveOnSphere(P, rnew);
+      return;
+    }
+#pragma omp parallel num_threads(nt)
+    {
+      int first, last;
+      getWalkerTeamRange(Ntargets, omp_get_thread_num(), nt, first, last);
+      DTD_BConds<T, D, SC>::computeDistances(rnew,
+                                             P.RSoA,
+                                             Temp_r.data(),
+                                             Temp_dr,
+                                             first,
+                                             last,
+                                             P.activePtcl);
+    }
+  }
+
+  /** evaluate the trial rows of a crowd of walkers moving the same particle
+   *
+   * The boundary conditions of this table are shared by the whole crowd and
+   * the walker tables only provide the output rows.
+   */
+  inline void multi_move(const std::vector<DistanceTableData*>& dt_list,
+                         const std::vector<ParticleSet*>& P_list,
+                         const std::vector<PosType>& rnew_list,
+                         bool serial = false)
+  {
+    crowd_for(serial, dt_list.size(), [&](int iw) {
+      DistanceTableData& dt = *dt_list[iw];
+      DTD_BConds<T, D, SC>::computeDistances(rnew_list[iw],
+                                             P_list[iw]->RSoA,
+                                             dt.Temp_r.data(),
+                                             dt.Temp_dr,
+                                             0,
+                                             Ntargets,
+                                             P_list[iw]->activePtcl);
+    });
   }
 
   /// update the iat-th row for iat=[0,iat-1)
@@ -112,7 +206,7 @@ struct DistanceTableAA : public DTD_BConds<T, D, SC>, public DistanceTableData
     if (iat == 0)
       return;
     // update by a cache line
-    const int nupdate = getAlignedSize<T>(iat);
+    const int nupdate = getAlignedSize<DistRealType>(iat);
     simd::copy_n(Temp_r.data(), nupdate, Distances[iat]);
     for (int idim = 0; idim < D; ++idim)
       simd::copy_n(Temp_dr.data(idim), nupdate, Displacements[iat].data(idim));
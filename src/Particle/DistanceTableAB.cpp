@@ -46,8 +46,21 @@ DistanceTableData* createDistanceTable(const ParticleSet& s, ParticleSet& t, int
   o << "  Distance table for AB: source = " << s.getName() << " target = " << t.getName() << "\n";
   if (sc == SUPERCELL_BULK)
   {
-    o << "  Using SoaDistanceTableBA<T,D,PPPG> of SoA layout " << PPPG << std::endl;
-    dt = new DistanceTableBA<RealType, DIM, PPPG + SOA_OFFSET>(s, t);
+    if (s.Lattice.DiagonalOnly)
+    {
+      o << "  Using SoaDistanceTableBA<T,D,PPPO> of SoA layout " << PPPO << std::endl;
+      dt = new DistanceTableBA<RealType, DIM, PPPO + SOA_OFFSET>(s, t);
+    }
+    else if (s.Lattice.WignerSeitzRadius > s.Lattice.SimulationCellRadius)
+    {
+      o << "  Using SoaDistanceTableBA<T,D,PPPG> of SoA layout " << PPPG << std::endl;
+      dt = new DistanceTableBA<RealType, DIM, PPPG + SOA_OFFSET>(s, t);
+    }
+    else
+    {
+      o << "  Using SoaDistanceTableBA<T,D,PPPS> of SoA layout " << PPPS << std::endl;
+      dt = new DistanceTableBA<RealType, DIM, PPPS + SOA_OFFSET>(s, t);
+    }
     o << "    Setting Rmax = " << s.Lattice.SimulationCellRadius;
   }
   else
@@ -44,8 +44,8 @@ struct DistanceTableBA : public DTD_BConds<T, D, SC>, public DistanceTableData
     if (Nsources * Ntargets == 0)
       return;
 
-    int Ntargets_padded = getAlignedSize<T>(Ntargets);
-    int Nsources_padded = getAlignedSize<T>(Nsources);
+    int Ntargets_padded = getAlignedSize<DistRealType>(Ntargets);
+    int Nsources_padded = getAlignedSize<DistRealType>(Nsources);
 
     Distances.resize(Ntargets, Nsources_padded);
 
@@ -68,12 +68,16 @@ struct DistanceTableBA : public DTD_BConds<T, D, SC>, public DistanceTableData
   {
     // be aware of the sign of Displacement
     for (int iat = 0; iat < Ntargets; ++iat)
+    {
       DTD_BConds<T, D, SC>::computeDistances(P.R[iat],
                                              Origin->RSoA,
                                              Distances[iat],
                                              Displacements[iat],
                                              0,
                                              Nsources);
+      if (NeighborCutoff > 0)
+        compressRow(iat);
+    }
   }
 
   /** evaluate the iat-row with the current position
@@ -88,17 +92,46 @@ struct DistanceTableBA : public DTD_BConds<T, D, SC>, public DistanceTableData
                                            Displacements[iat],
                                            0,
                                            Nsources);
+    if (NeighborCutoff > 0)
+      compressRow(iat);
   }
 
   inline void moveOnSphere(const ParticleSet& P, const PosType& rnew)
   {
     DTD_BConds<T, D, SC>::computeDistances(rnew, Origin->RSoA, Temp_r.data(), Temp_dr, 0, Nsources);
+    if (NeighborCutoff > 0)
+      compressTemp(*this);
   }
 
   /// evaluate the temporary pair relations
   inline void move(const ParticleSet& P, const PosType& rnew)
   {
     DTD_BConds<T, D, SC>::computeDistances(rnew, Origin->RSoA, Temp_r.data(), Temp_dr, 0, Nsources);
+    if (NeighborCutoff > 0)
+      compressTemp(*this);
+  }
+
+  /** evaluate the trial rows of a crowd of walkers moving the same particle
+   *
+   * The boundary conditions of this table are shared by the whole crowd and
+   * the walker tables only provide the sources and the output rows.
+   */
+  inline void multi_move(const std::vector<DistanceTableData*>& dt_list,
+                         const std::vector<ParticleSet*>& P_list,
+                         const std::vector<PosType>& rnew_list,
+                         bool serial = false)
+  {
+    crowd_for(serial, dt_list.size(), [&](int iw) {
+      DistanceTableData& dt = *dt_list[iw];
+      DTD_BConds<T, D, SC>::computeDistances(rnew_list[iw],
+                                             dt.Origin->RSoA,
+                                             dt.Temp_r.data(),
+                                             dt.Temp_dr,
+                                             0,
+                                             Nsources);
+      if (dt.NeighborCutoff > 0)
+        compressTemp(dt);
+    });
   }
 
   /// update the stripe for jat-th particle
@@ -107,6 +140,96 @@ struct DistanceTableBA : public DTD_BConds<T, D, SC>, public DistanceTableData
     simd::copy_n(Temp_r.data(), Nsources, Distances[iat]);
     for (int idim = 0; idim < D; ++idim)
       simd::copy_n(Temp_dr.data(idim), Nsources, Displacements[iat].data(idim));
+    if (NeighborCutoff > 0)
+    {
+      const int nn        = Temp_nn_count;
+      NeighborCounts[iat] = nn;
+      std::copy_n(Temp_nn_ids.data(), nn, NeighborIDs[iat]);
+      simd::copy_n(Temp_nn_r.data(), nn, NeighborDistances[iat]);
+      for (int idim = 0; idim < D; ++idim)
+        simd::copy_n(Temp_nn_dr.data(idim), nn, NeighborDisplacements[iat].data(idim));
+    }
+  }
+
+  void requestNeighborList(RealType rcut)
+  {
+    if (rcut <= NeighborCutoff)
+      return;
+    NeighborCutoff = rcut;
+
+    const int Nsources_padded = getAlignedSize<DistRealType>(Nsources);
+    NeighborCounts.resize(Ntargets);
+    NeighborIDs.resize(Ntargets, Nsources_padded);
+    NeighborDistances.resize(Ntargets, Nsources_padded);
+    neighborPool.resize(Ntargets * BlockSize);
+    NeighborDisplacements.resize(Ntargets);
+    for (int i = 0; i < Ntargets; ++i)
+      NeighborDisplacements[i].attachReference(Nsources,
+                                               Nsources_padded,
+                                               neighborPool.data() + i * BlockSize);
+    Temp_nn_ids.resize(Nsources);
+    Temp_nn_r.resize(Nsources);
+    Temp_nn_dr.resize(Nsources);
+
+    for (int iat = 0; iat < Ntargets; ++iat)
+      compressRow(iat);
+  }
+
+private:
+  /** gather the sources within a cutoff
+   * @param rcut cutoff of the neighbor list
+   * @param r distances to all the sources
+   * @param dr displacements to all the sources
+   * @param ids source indices of the neighbors
+   * @param nn_r distances of the neighbors
+   * @param nn_dr displacements of the neighbors
+   * @return the number of the neighbors
+   */
+  inline int compress(const DistRealType rcut,
+                      const DistRealType* restrict r,
+                      const RowContainer& dr,
+                      int* restrict ids,
+                      DistRealType* restrict nn_r,
+                      RowContainer& nn_dr) const
+  {
+    int nn = 0;
+    for (int jat = 0; jat < Nsources; ++jat)
+      if (r[jat] < rcut)
+      {
+        ids[nn]  = jat;
+        nn_r[nn] = r[jat];
+        nn++;
+      }
+    for (int idim = 0; idim < D; ++idim)
+    {
+      const DistRealType* restrict src = dr.data(idim);
+      DistRealType* restrict dst       = nn_dr.data(idim);
+      for (int k = 0; k < nn; ++k)
+        dst[k] = src[ids[k]];
+    }
+    return nn;
+  }
+
+  /// rebuild the neighbor list of the iat-th target
+  inline void compressRow(int iat)
+  {
+    NeighborCounts[iat] = compress(NeighborCutoff,
+                                   Distances[iat],
+                                   Displacements[iat],
+                                   NeighborIDs[iat],
+                                   NeighborDistances[iat],
+                                   NeighborDisplacements[iat]);
+  }
+
+  /// build the neighbor list of the proposed move of dt
+  inline void compressTemp(DistanceTableData& dt) const
+  {
+    dt.Temp_nn_count = compress(dt.NeighborCutoff,
+                                dt.Temp_r.data(),
+                                dt.Temp_dr,
+                                dt.Temp_nn_ids.data(),
+                                dt.Temp_nn_r.data(),
+                                dt.Temp_nn_dr);
   }
 };
 } // namespace qmcplusplus
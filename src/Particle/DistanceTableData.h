@@ -24,6 +24,7 @@
 
 #include "Particle/ParticleSet.h"
 #include "Utilities/PooledData.h"
+#include "Utilities/CrowdThreads.h"
 #include "Numerics/OhmmsPETE/OhmmsVector.h"
 #include "Numerics/OhmmsPETE/OhmmsMatrix.h"
 #include "Utilities/SIMD/allocator.hpp"
@@ -76,17 +77,19 @@ struct DistanceTableData
 #if (__cplusplus >= 201103L)
   using IndexType       = QMCTraits::IndexType;
   using RealType        = QMCTraits::RealType;
+  using DistRealType    = OHMMS_DT_PRECISION;
   using PosType         = QMCTraits::PosType;
   using IndexVectorType = aligned_vector<IndexType>;
   using ripair          = std::pair<RealType, IndexType>;
-  using RowContainer    = VectorSoAContainer<RealType, DIM>;
+  using RowContainer    = VectorSoAContainer<DistRealType, DIM>;
 #else
   typedef QMCTraits::IndexType IndexType;
   typedef QMCTraits::RealType RealType;
+  typedef OHMMS_DT_PRECISION DistRealType;
   typedef QMCTraits::PosType PosType;
   typedef aligned_vector<IndexType> IndexVectorType;
   typedef std::pair<RealType, IndexType> ripair;
-  typedef Container<RealType, DIM> RowContainer;
+  typedef Container<DistRealType, DIM> RowContainer;
 #endif
 
   /// type of cell
@@ -96,19 +99,23 @@ struct DistanceTableData
   /// size of indicies
   TinyVector<IndexType, 4> N;
 
-  /**defgroup SoA data */
+  /**defgroup SoA data
+   *
+   * The entries are stored in DistRealType, which can be narrower than the
+   * RealType of the particle positions.
+   */
   /*@{*/
   /** Distances[i][j] , [Nsources][Ntargets] */
-  Matrix<RealType, aligned_allocator<RealType>> Distances;
+  Matrix<DistRealType, aligned_allocator<DistRealType>> Distances;
 
   /** Displacements[Nsources]x[3][Ntargets] */
   std::vector<RowContainer> Displacements;
 
   /// actual memory for Displacements
-  aligned_vector<RealType> memoryPool;
+  aligned_vector<DistRealType> memoryPool;
 
   /** temp_r */
-  aligned_vector<RealType> Temp_r;
+  aligned_vector<DistRealType> Temp_r;
 
   /** temp_dr */
   RowContainer Temp_dr;
@@ -117,11 +124,39 @@ struct DistanceTableData
   bool Need_full_table_loadWalker;
   /*@}*/
 
+  /**defgroup compressed neighbor lists
+   *
+   * Per-target lists of the sources within NeighborCutoff, sorted by the
+   * source index. Only AB tables maintain them, on request of the consumers.
+   */
+  /*@{*/
+  /// cutoff of the neighbor lists, the largest cutoff requested so far
+  RealType NeighborCutoff;
+  /// NeighborCounts[i] number of the neighbors of the i-th target
+  aligned_vector<int> NeighborCounts;
+  /// NeighborIDs[i][k] source index of the k-th neighbor of the i-th target
+  Matrix<int, aligned_allocator<int>> NeighborIDs;
+  /// NeighborDistances[i][k] distance of the k-th neighbor of the i-th target
+  Matrix<DistRealType, aligned_allocator<DistRealType>> NeighborDistances;
+  /// NeighborDisplacements[i] displacements of the neighbors of the i-th target
+  std::vector<RowContainer> NeighborDisplacements;
+  /// actual memory for NeighborDisplacements
+  aligned_vector<DistRealType> neighborPool;
+  /// number of the neighbors of the proposed move
+  int Temp_nn_count;
+  /// source indices of the neighbors of the proposed move
+  aligned_vector<int> Temp_nn_ids;
+  /// distances of the neighbors of the proposed move
+  aligned_vector<DistRealType> Temp_nn_r;
+  /// displacements of the neighbors of the proposed move
+  RowContainer Temp_nn_dr;
+  /*@}*/
+
   /// name of the table
   std::string Name;
   /// constructor using source and target ParticleSet
   DistanceTableData(const ParticleSet& source, const ParticleSet& target)
-      : Origin(&source), N(0), Need_full_table_loadWalker(false)
+      : Origin(&source), N(0), Need_full_table_loadWalker(false), NeighborCutoff(0), Temp_nn_count(0)
   {}
 
   /// virutal destructor
@@ -159,9 +194,86 @@ struct DistanceTableData
   /// evaluate the distance tables with a sphere move
   virtual void moveOnSphere(const ParticleSet& P, const PosType& rnew) = 0;
 
+  /** evaluate the temporary pair relations of a crowd of walkers moving the same particle
+   * @param dt_list tables of the walkers, of the same type as this
+   * @param P_list target particle sets of the walkers
+   * @param rnew_list proposed positions, one per walker
+   * @param serial if true, the calling thread evaluates all the walkers
+   *
+   * Default implementation calls move on each walker table.
+   */
+  virtual void multi_move(const std::vector<DistanceTableData*>& dt_list,
+                          const std::vector<ParticleSet*>& P_list,
+                          const std::vector<PosType>& rnew_list,
+                          bool serial = false)
+  {
+    crowd_for(serial, dt_list.size(), [&](int iw) {
+      dt_list[iw]->move(*P_list[iw], rnew_list[iw]);
+    });
+  }
+
   /// update the distance table by the pair relations
   virtual void update(IndexType jat) = 0;
 
+  /**@{ walker buffer
+   *
+   * The full table of a walker, including the neighbor lists if any, in the
+   * layout set by registerData. Entries of other types than the RealType of
+   * the buffer go to its full-precision storage.
+   */
+  /// add the current table to buf
+  void registerData(PooledData<RealType>& buf)
+  {
+    buf.add(Distances.first_address(), Distances.last_address());
+    buf.add(memoryPool.data(), memoryPool.data() + memoryPool.size());
+    if (NeighborCutoff > 0)
+    {
+      buf.add(NeighborCounts.data(), NeighborCounts.data() + NeighborCounts.size());
+      buf.add(NeighborIDs.first_address(), NeighborIDs.last_address());
+      buf.add(NeighborDistances.first_address(), NeighborDistances.last_address());
+      buf.add(neighborPool.data(), neighborPool.data() + neighborPool.size());
+    }
+  }
+
+  /// copy the current table to buf, at its cursor
+  void copyToBuffer(PooledData<RealType>& buf)
+  {
+    buf.put(Distances.first_address(), Distances.last_address());
+    buf.put(memoryPool.data(), memoryPool.data() + memoryPool.size());
+    if (NeighborCutoff > 0)
+    {
+      buf.put(NeighborCounts.data(), NeighborCounts.data() + NeighborCounts.size());
+      buf.put(NeighborIDs.first_address(), NeighborIDs.last_address());
+      buf.put(NeighborDistances.first_address(), NeighborDistances.last_address());
+      buf.put(neighborPool.data(), neighborPool.data() + neighborPool.size());
+    }
+  }
+
+  /// restore the table from buf, at its cursor
+  void copyFromBuffer(PooledData<RealType>& buf)
+  {
+    buf.get(Distances.first_address(), Distances.last_address());
+    buf.get(memoryPool.data(), memoryPool.data() + memoryPool.size());
+    if (NeighborCutoff > 0)
+    {
+      buf.get(NeighborCounts.data(), NeighborCounts.data() + NeighborCounts.size());
+      buf.get(NeighborIDs.first_address(), NeighborIDs.last_address());
+      buf.get(NeighborDistances.first_address(), NeighborDistances.last_address());
+      buf.get(neighborPool.data(), neighborPool.data() + neighborPool.size());
+    }
+  }
+  /**@}*/
+
+  /** request the compressed neighbor lists within rcut
+   * @param rcut cutoff of the consumer
+   *
+   * The lists are rebuilt from the current table when rcut extends them.
+   */
+  virtual void requestNeighborList(RealType rcut)
+  {
+    APP_ABORT("DistanceTableData::requestNeighborList is only supported by AB tables.\n");
+  }
+
   const ParticleSet* Origin;
 };
 } // namespace qmcplusplus
@@ -150,11 +150,16 @@ struct DTD_BConds<T, 3, PPPG + SOA_OFFSET>
     corners(7) = minusone * (rb[0] + rb[1] + rb[2]);
   }
 
-  template<typename PT, typename RSoA>
+  /** compute the distances and displacements of R0[first,last) from pos
+   *
+   * The minimum image is computed in T and stored in TR, the precision
+   * of the distance table entries.
+   */
+  template<typename PT, typename RSoA, typename TR, typename DSoA>
   void computeDistances(const PT& pos,
                         const RSoA& R0,
-                        T* restrict temp_r,
-                        RSoA& temp_dr,
+                        TR* restrict temp_r,
+                        DSoA& temp_dr,
                         int first,
                         int last,
                         int flip_ind = 0)
@@ -167,9 +172,9 @@ struct DTD_BConds<T, 3, PPPG + SOA_OFFSET>
     const T* restrict py = R0.data(1);
     const T* restrict pz = R0.data(2);
 
-    T* restrict dx = temp_dr.data(0);
-    T* restrict dy = temp_dr.data(1);
-    T* restrict dz = temp_dr.data(2);
+    TR* restrict dx = temp_dr.data(0);
+    TR* restrict dy = temp_dr.data(1);
+    TR* restrict dz = temp_dr.data(2);
 
     const T* restrict cellx = corners.data(0);
     ASSUME_ALIGNED(cellx);
@@ -217,6 +222,154 @@ struct DTD_BConds<T, 3, PPPG + SOA_OFFSET>
   }
 };
 
+/** specialization for a periodic 3D orthorombic cell
+ *
+ * The minimum image is found by wrapping each Cartesian component
+ * independently without any image-cell check.
+*/
+template<class T>
+struct DTD_BConds<T, 3, PPPO + SOA_OFFSET>
+{
+  T Linv0, L0, Linv1, L1, Linv2, L2;
+
+  DTD_BConds(const CrystalLattice<T, 3>& lat)
+      : Linv0(lat.OneOverLength[0]),
+        L0(lat.Length[0]),
+        Linv1(lat.OneOverLength[1]),
+        L1(lat.Length[1]),
+        Linv2(lat.OneOverLength[2]),
+        L2(lat.Length[2])
+  {}
+
+  template<typename PT, typename RSoA, typename TR, typename DSoA>
+  void computeDistances(const PT& pos,
+                        const RSoA& R0,
+                        TR* restrict temp_r,
+                        DSoA& temp_dr,
+                        int first,
+                        int last,
+                        int flip_ind = 0)
+  {
+    const T x0 = pos[0];
+    const T y0 = pos[1];
+    const T z0 = pos[2];
+
+    const T* restrict px = R0.data(0);
+    const T* restrict py = R0.data(1);
+    const T* restrict pz = R0.data(2);
+
+    TR* restrict dx = temp_dr.data(0);
+    TR* restrict dy = temp_dr.data(1);
+    TR* restrict dz = temp_dr.data(2);
+
+    constexpr T minusone(-1);
+    constexpr T one(1);
+    constexpr T half(0.5);
+    #pragma omp simd aligned(temp_r, px, py, pz, dx, dy, dz)
+    for (int iat = first; iat < last; ++iat)
+    {
+      const T flip    = iat < flip_ind ? one : minusone;
+      const T displ_0 = (px[iat] - x0) * flip;
+      const T displ_1 = (py[iat] - y0) * flip;
+      const T displ_2 = (pz[iat] - z0) * flip;
+
+      const T delx = displ_0 - L0 * std::floor(displ_0 * Linv0 + half);
+      const T dely = displ_1 - L1 * std::floor(displ_1 * Linv1 + half);
+      const T delz = displ_2 - L2 * std::floor(displ_2 * Linv2 + half);
+
+      temp_r[iat] = std::sqrt(delx * delx + dely * dely + delz * delz);
+      dx[iat]     = flip * delx;
+      dy[iat]     = flip * dely;
+      dz[iat]     = flip * delz;
+    }
+  }
+};
+
+/** specialization for a periodic 3D general cell
+ *
+ * Wigner-Seitz cell radius == simulation cell radius
+ * The minimum image is found by wrapping the reduced coordinates
+ * without any image-cell check.
+*/
+template<class T>
+struct DTD_BConds<T, 3, PPPS + SOA_OFFSET>
+{
+  T g00, g10, g20, g01, g11, g21, g02, g12, g22;
+  T r00, r10, r20, r01, r11, r21, r02, r12, r22;
+
+  DTD_BConds(const CrystalLattice<T, 3>& lat)
+      : g00(lat.G(0)),
+        g10(lat.G(3)),
+        g20(lat.G(6)),
+        g01(lat.G(1)),
+        g11(lat.G(4)),
+        g21(lat.G(7)),
+        g02(lat.G(2)),
+        g12(lat.G(5)),
+        g22(lat.G(8)),
+        r00(lat.R(0)),
+        r10(lat.R(3)),
+        r20(lat.R(6)),
+        r01(lat.R(1)),
+        r11(lat.R(4)),
+        r21(lat.R(7)),
+        r02(lat.R(2)),
+        r12(lat.R(5)),
+        r22(lat.R(8))
+  {}
+
+  template<typename PT, typename RSoA, typename TR, typename DSoA>
+  void computeDistances(const PT& pos,
+                        const RSoA& R0,
+                        TR* restrict temp_r,
+                        DSoA& temp_dr,
+                        int first,
+                        int last,
+                        int flip_ind = 0)
+  {
+    const T x0 = pos[0];
+    const T y0 = pos[1];
+    const T z0 = pos[2];
+
+    const T* restrict px = R0.data(0);
+    const T* restrict py = R0.data(1);
+    const T* restrict pz = R0.data(2);
+
+    TR* restrict dx = temp_dr.data(0);
+    TR* restrict dy = temp_dr.data(1);
+    TR* restrict dz = temp_dr.data(2);
+
+    constexpr T minusone(-1);
+    constexpr T one(1);
+    constexpr T half(0.5);
+    #pragma omp simd aligned(temp_r, px, py, pz, dx, dy, dz)
+    for (int iat = first; iat < last; ++iat)
+    {
+      const T flip    = iat < flip_ind ? one : minusone;
+      const T displ_0 = (px[iat] - x0) * flip;
+      const T displ_1 = (py[iat] - y0) * flip;
+      const T displ_2 = (pz[iat] - z0) * flip;
+
+      T ar_0 = displ_0 * g00 + displ_1 * g10 + displ_2 * g20;
+      T ar_1 = displ_0 * g01 + displ_1 * g11 + displ_2 * g21;
+      T ar_2 = displ_0 * g02 + displ_1 * g12 + displ_2 * g22;
+
+      ar_0 -= std::floor(ar_0 + half);
+      ar_1 -= std::floor(ar_1 + half);
+      ar_2 -= std::floor(ar_2 + half);
+
+      const T delx = ar_0 * r00 + ar_1 * r10 + ar_2 * r20;
+      const T dely = ar_0 * r01 + ar_1 * r11 + ar_2 * r21;
+      const T delz = ar_0 * r02 + ar_1 * r12 + ar_2 * r22;
+
+      temp_r[iat] = std::sqrt(delx * delx + dely * dely + delz * delz);
+      dx[iat]     = flip * delx;
+      dy[iat]     = flip * dely;
+      dz[iat]     = flip * delz;
+    }
+  }
+};
+
 } // namespace qmcplusplus
 
 #endif // OHMMS_PARTICLE_BCONDS_H
@@ -29,6 +29,8 @@
 
 #include <numeric>
 #include <iomanip>
+#include <algorithm>
+#include <cstdint>
 #include "Particle/ParticleSet.h"
 #include "Particle/DistanceTableData.h"
 #include "Particle/DistanceTable.h"
@@ -56,7 +58,13 @@ TimerNameList_t<DistanceTimers> DistanceTimerNames{
 };
 
 ParticleSet::ParticleSet()
-    : UseBoundBox(true), IsGrouped(true), myName("none"), SameMass(true), myTwist(0.0), activePtcl(-1)
+    : UseBoundBox(true),
+      IsGrouped(true),
+      myName("none"),
+      SameMass(true),
+      myTwist(0.0),
+      activePtcl(-1),
+      WalkerTeamSize(1)
 {
   setup_timers(timers, DistanceTimerNames, timer_level_coarse);
 }
@@ -67,7 +75,8 @@ ParticleSet::ParticleSet(const ParticleSet& p)
       mySpecies(p.getSpeciesSet()),
       SameMass(true),
       myTwist(0.0),
-      activePtcl(-1)
+      activePtcl(-1),
+      WalkerTeamSize(p.WalkerTeamSize)
 {
   //distance_timer = TimerManager.createTimer("Distance Tables", timer_level_coarse);
   setup_timers(timers, DistanceTimerNames, timer_level_coarse);
@@ -106,6 +115,8 @@ void ParticleSet::create(int numPtcl)
   resize(numPtcl);
   GroupID = 0;
   R       = RealType(0);
+  for (int iat = 0; iat < numPtcl; ++iat)
+    ID[iat] = iat;
 }
 
 void ParticleSet::create(const std::vector<int>& agroup)
@@ -121,7 +132,10 @@ void ParticleSet::create(const std::vector<int>& agroup)
   for (int i = 0; i < agroup.size(); i++)
   {
     for (int j = 0; j < agroup[i]; j++, loc++)
+    {
       GroupID[loc] = i;
+      ID[loc]      = loc;
+    }
   }
 }
 
@@ -291,6 +305,56 @@ void ParticleSet::update(bool skipSK)
   activePtcl = -1;
 }
 
+/** interleave the lowest 21 bits of v with two zero bits
+ */
+inline uint64_t spreadBits3D(uint64_t v)
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+
+void ParticleSet::sortByMorton(std::vector<int>& new2old)
+{
+  constexpr uint64_t nbins = 1 << 21;
+  std::vector<uint64_t> keys(TotalNum);
+  new2old.resize(TotalNum);
+  for (int iat = 0; iat < TotalNum; ++iat)
+  {
+    const SingleParticlePos_t u = Lattice.toUnit_floor(R[iat]);
+    uint64_t key                = 0;
+    for (int idim = 0; idim < DIM; ++idim)
+      key |= spreadBits3D(std::min(static_cast<uint64_t>(u[idim] * nbins), nbins - 1)) << idim;
+    keys[iat]    = key;
+    new2old[iat] = iat;
+  }
+
+  const int ng = groups();
+  for (int ig = 0; ig < std::max(ng, 1); ++ig)
+    std::stable_sort(new2old.begin() + (ng > 0 ? first(ig) : 0),
+                     new2old.begin() + (ng > 0 ? last(ig) : TotalNum),
+                     [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+  const ParticlePos_t R_old(R);
+  const ParticleIndex_t ID_old(ID), PCID_old(PCID), GroupID_old(GroupID);
+  const ParticleScalar_t Mass_old(Mass), Z_old(Z);
+  for (int iat = 0; iat < TotalNum; ++iat)
+  {
+    const int jat = new2old[iat];
+    R[iat]        = R_old[jat];
+    ID[iat]       = ID_old[jat];
+    PCID[iat]     = PCID_old[jat];
+    GroupID[iat]  = GroupID_old[jat];
+    Mass[iat]     = Mass_old[jat];
+    Z[iat]        = Z_old[jat];
+  }
+  RSoA.copyIn(R);
+}
+
 void ParticleSet::setActive(int iat)
 {
   ScopedTimer local_timer(timers[Timer_setActive]);
@@ -339,6 +403,46 @@ bool ParticleSet::makeMoveAndCheck(Index_t iat, const SingleParticlePos_t& displ
   }
 }
 
+void ParticleSet::multi_makeMoveAndCheck(const std::vector<ParticleSet*>& P_list,
+                                         Index_t iat,
+                                         const std::vector<SingleParticlePos_t>& displs,
+                                         std::vector<int>& isValid,
+                                         bool serial)
+{
+  ScopedTimer local_timer(timers[Timer_makeMove]);
+
+  const int nw = P_list.size();
+  mw_valid_P_list.clear();
+  mw_valid_pos_list.clear();
+  for (int iw = 0; iw < nw; iw++)
+  {
+    ParticleSet& P = *P_list[iw];
+    P.activePtcl   = iat;
+    P.activePos    = P.R[iat] + displs[iw];
+    isValid[iw]    = true;
+    if (P.UseBoundBox)
+    {
+      P.newRedPos = P.Lattice.toUnit(P.activePos);
+      if (P.Lattice.outOfBound(P.Lattice.toUnit(displs[iw])) || !P.Lattice.isValid(P.newRedPos))
+      {
+        P.activePtcl = -1;
+        isValid[iw]  = false;
+        continue;
+      }
+    }
+    mw_valid_P_list.push_back(&P);
+    mw_valid_pos_list.push_back(P.activePos);
+  }
+
+  mw_dt_list.resize(mw_valid_P_list.size());
+  for (int i = 0; i < DistTables.size(); ++i)
+  {
+    for (int iw = 0; iw < mw_valid_P_list.size(); iw++)
+      mw_dt_list[iw] = mw_valid_P_list[iw]->DistTables[i];
+    DistTables[i]->multi_move(mw_dt_list, mw_valid_P_list, mw_valid_pos_list, serial);
+  }
+}
+
 /** move the iat-th particle by displ
  *
  * @param iat the particle that is moved on a sphere
@@ -401,6 +505,24 @@ void ParticleSet::loadWalker(Walker_t& awalker, bool pbyp)
 
 void ParticleSet::saveWalker(Walker_t& awalker) { awalker.R = R; }
 
+void ParticleSet::registerData(Buffer_t& buf)
+{
+  for (int i = 0; i < DistTables.size(); i++)
+    DistTables[i]->registerData(buf);
+}
+
+void ParticleSet::copyToBuffer(Buffer_t& buf)
+{
+  for (int i = 0; i < DistTables.size(); i++)
+    DistTables[i]->copyToBuffer(buf);
+}
+
+void ParticleSet::copyFromBuffer(Buffer_t& buf)
+{
+  for (int i = 0; i < DistTables.size(); i++)
+    DistTables[i]->copyFromBuffer(buf);
+}
+
 void ParticleSet::clearDistanceTables()
 {
   // Physically remove the tables
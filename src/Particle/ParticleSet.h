@@ -144,6 +144,9 @@ public:
   /// current MC step
   int current_step;
 
+  /// number of the threads serving this walker, set by the driver
+  int WalkerTeamSize;
+
 
   /// default constructor
   ParticleSet();
@@ -187,6 +190,14 @@ public:
    */
   void update(bool skipSK = false);
 
+  /** sort the particles within each group by the Morton key of the reduced positions
+   * @param new2old new2old[i] is the old index of the particle at the new index i
+   *
+   * Neighboring particles in space get nearby indices. ID keeps the persistent
+   * indices. The distance tables need to be updated by the caller.
+   */
+  void sortByMorton(std::vector<int>& new2old);
+
   /// retrun the SpeciesSet of this particle set
   inline SpeciesSet& getSpeciesSet() { return mySpecies; }
   /// retrun the const SpeciesSet of this particle set
@@ -220,6 +231,22 @@ public:
    */
   bool makeMoveAndCheck(Index_t iat, const SingleParticlePos_t& displ);
 
+  /** move the same particle of a crowd of walkers
+   * @param P_list particle sets of the walkers, including this
+   * @param iat the index of the particle to be moved
+   * @param displs random displacements of the iat-th particle, one per walker
+   * @param isValid set to 1 for the walkers with a valid move
+   * @param serial if true, the calling thread moves all the walkers
+   *
+   * The distance tables of the valid walkers are evaluated together by
+   * DistanceTableData::multi_move of the tables of this ParticleSet.
+   */
+  void multi_makeMoveAndCheck(const std::vector<ParticleSet*>& P_list,
+                              Index_t iat,
+                              const std::vector<SingleParticlePos_t>& displs,
+                              std::vector<int>& isValid,
+                              bool serial = false);
+
   /** move a particle
    * @param iat the index of the particle to be moved
    * @param displ random displacement of the iat-th particle
@@ -252,6 +279,19 @@ public:
    */
   void saveWalker(Walker_t& awalker);
 
+  /**@{ walker buffer of the distance tables
+   *
+   * With the positions of loadWalker, copyFromBuffer restores the tables
+   * without evaluating them.
+   */
+  /// add the current tables to buf
+  void registerData(Buffer_t& buf);
+  /// copy the current tables to buf, at its cursor
+  void copyToBuffer(Buffer_t& buf);
+  /// restore the tables from buf, at its cursor
+  void copyFromBuffer(Buffer_t& buf);
+  /**@}*/
+
   /** update the buffer
    *@param skip SK update if skipSK is true
    */
@@ -326,6 +366,11 @@ protected:
 
   /// Timer
   TimerList_t timers;
+
+  /// walkers with a valid move, their positions and tables in multi_makeMoveAndCheck
+  std::vector<ParticleSet*> mw_valid_P_list;
+  std::vector<PosType> mw_valid_pos_list;
+  std::vector<DistanceTableData*> mw_dt_list;
 };
 
 const std::vector<ParticleSet::ParticleGradient_t*>
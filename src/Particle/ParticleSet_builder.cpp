@@ -33,8 +33,7 @@ int build_ions(ParticleSet& ions, const Tensor<int, 3>& tmat, Tensor<QMCTraits::
 int build_els(ParticleSet& els, const ParticleSet& ions, RandomGenerator<QMCTraits::RealType>& rng)
 {
   els.setName("e");
-  const int nels  = count_electrons(ions, 1);
-  const int nels3 = 3 * nels;
+  const int nels = count_electrons(ions, 1);
 
   { // create up/down electrons
     els.Lattice.BoxBConds = 1;
@@ -43,13 +42,18 @@ int build_els(ParticleSet& els, const ParticleSet& ions, RandomGenerator<QMCTrai
     ud[0] = nels / 2;
     ud[1] = nels - ud[0];
     els.create(ud);
-    els.R.InUnit = 1;
-    rng.generate_uniform(&els.R[0][0], nels3);
-    els.convert2Cart(els.R); // convert to Cartiesian
-    els.RSoA = els.R;
+    random_els(els, rng);
   }
 
   return nels;
 }
 
+void random_els(ParticleSet& els, RandomGenerator<QMCTraits::RealType>& rng)
+{
+  els.R.InUnit = 1;
+  rng.generate_uniform(&els.R[0][0], 3 * els.getTotalNum());
+  els.convert2Cart(els.R); // convert to Cartiesian
+  els.RSoA = els.R;
+}
+
 } // namespace qmcplusplus
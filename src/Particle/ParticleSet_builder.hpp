@@ -24,6 +24,9 @@ int build_ions(ParticleSet& ions, const Tensor<int, 3>& tmat, Tensor<QMCTraits::
 
 /// build the ParticleSet of electrons
 int build_els(ParticleSet& els, const ParticleSet& ions, RandomGenerator<QMCTraits::RealType>& rng);
+
+/// place the electrons uniformly in the cell
+void random_els(ParticleSet& els, RandomGenerator<QMCTraits::RealType>& rng);
 } // namespace qmcplusplus
 
 #endif
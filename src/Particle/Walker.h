@@ -170,8 +170,9 @@ struct Walker
     Multiplicity = a.Multiplicity;
     if (R.size() != a.R.size())
       resize(a.R.size());
-    R       = a.R;
-    DataSet = a.DataSet;
+    R          = a.R;
+    DataSet    = a.DataSet;
+    Properties = a.Properties;
   }
 
   /** byte size for a packed message
@@ -20,6 +20,7 @@
 #include "Numerics/OhmmsPETE/OhmmsMatrix.h"
 #include "Numerics/DeterminantOperators.h"
 #include "QMCWaveFunctions/WaveFunctionComponent.h"
+#include "Utilities/WalkerTeam.h"
 
 namespace qmcplusplus
 {
@@ -125,20 +126,48 @@ inline void
   getri(n, x, lda, pivot, work, lwork);
 }
 
-/** update Row as implemented in the full code */
+/** update Row as implemented in the full code
+ * @param team size of the team serving the walker, splitting the rows of pinv
+ */
 /** [UpdateRow] */
 template<typename T, typename RT>
-inline void
-    updateRow(T* restrict pinv, const T* restrict tv, int m, int lda, int rowchanged, RT c_ratio_in)
+inline void updateRow(T* restrict pinv,
+                      const T* restrict tv,
+                      int m,
+                      int lda,
+                      int rowchanged,
+                      RT c_ratio_in,
+                      int team = 1)
 {
   constexpr T cone(1);
   constexpr T czero(0);
   T temp[m], rcopy[m];
-  T c_ratio = cone / c_ratio_in;
-  BLAS::gemv('T', m, m, c_ratio, pinv, m, tv, 1, czero, temp, 1);
-  temp[rowchanged] = cone - c_ratio;
-  std::copy_n(pinv + m * rowchanged, m, rcopy);
-  BLAS::ger(m, m, -cone, rcopy, 1, temp, 1, pinv, m);
+  T c_ratio    = cone / c_ratio_in;
+  const int nt = getWalkerTeamSize(team, m);
+  if (nt == 1)
+  {
+    BLAS::gemv('T', m, m, c_ratio, pinv, m, tv, 1, czero, temp, 1);
+    temp[rowchanged] = cone - c_ratio;
+    std::copy_n(pinv + m * rowchanged, m, rcopy);
+    BLAS::ger(m, m, -cone, rcopy, 1, temp, 1, pinv, m);
+    return;
+  }
+  // each member of the walker team owns a block of rows of pinv
+#pragma omp parallel num_threads(nt)
+  {
+    int first, last;
+    getWalkerTeamRange(m, omp_get_thread_num(), nt, first, last);
+    if (first < last)
+      BLAS::gemv('T', m, last - first, c_ratio, pinv + m * first, m, tv, 1, czero, temp + first, 1);
+#pragma omp barrier
+#pragma omp single
+    {
+      temp[rowchanged] = cone - c_ratio;
+      std::copy_n(pinv + m * rowchanged, m, rcopy);
+    }
+    if (first < last)
+      BLAS::ger(m, last - first, -cone, rcopy, 1, temp + first, 1, pinv + m * first, m);
+  }
 }
 /** [UpdateRow] */
 /**@}*/
@@ -202,6 +231,7 @@ struct DiracDeterminant : public WaveFunctionComponent
     work.resize(LWork);
 
     constexpr double shift(0.5);
+    myRandom.setCounter(RandomInitStep, RandomInitDeterminant + FirstIndex);
     myRandom.generate_uniform(psiMsave.data(), nels * nels);
     psiMsave -= shift;
 
@@ -263,14 +293,60 @@ struct DiracDeterminant : public WaveFunctionComponent
     return curRatio;
   }
 
+  /** return determinant ratio for the row replacement by the orbitals psi
+   * @param iel the row (active particle) index
+   * @param psi the orbitals at the new position of iel
+   */
+  inline ValueType ratioFromOrbitals(int iel, const ValueType* psi) const
+  {
+    constexpr double czero(0);
+    return inner_product_n(psi, psiMinv[iel - FirstIndex], psiV.size(), czero);
+  }
+
   /** accept the row and update the inverse */
   inline void acceptMove(ParticleSet& P, int iel)
   {
     const int nels = psiV.size();
-    updateRow(psiMinv.data(), psiV.data(), nels, nels, iel - FirstIndex, curRatio);
+    updateRow(psiMinv.data(),
+              psiV.data(),
+              nels,
+              nels,
+              iel - FirstIndex,
+              curRatio,
+              P.WalkerTeamSize);
     std::copy_n(psiV.data(), nels, psiMsave[iel - FirstIndex]);
   }
 
+  /** permute the rows following the reordered particles
+   * @param new2old new2old[i] is the old index of the particle at the new index i
+   */
+  void reorderParticles(const std::vector<int>& new2old)
+  {
+    const int nels = psiV.size();
+    const Matrix<RealType> psiMsave_old(psiMsave);
+    for (int iel = 0; iel < nels; ++iel)
+      std::copy_n(psiMsave_old[new2old[iel + FirstIndex] - FirstIndex], nels, psiMsave[iel]);
+  }
+
+  /** the inverse and the rows are kept */
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    buf.add(psiMinv.first_address(), psiMinv.last_address());
+    buf.add(psiMsave.first_address(), psiMsave.last_address());
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.put(psiMinv.first_address(), psiMinv.last_address());
+    buf.put(psiMsave.first_address(), psiMsave.last_address());
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.get(psiMinv.first_address(), psiMinv.last_address());
+    buf.get(psiMsave.first_address(), psiMsave.last_address());
+  }
+
   /** accessor functions for checking */
   inline double operator()(int i) const { return psiMinv(i); }
   inline int size() const { return psiMinv.size(); }
@@ -205,6 +205,7 @@ struct DiracDeterminantRef : public qmcplusplus::WaveFunctionComponent
     work.resize(LWork);
 
     constexpr double shift(0.5);
+    myRandom.setCounter(RandomInitStep, RandomInitDeterminant + FirstIndex);
     myRandom.generate_uniform(psiMsave.data(), nels * nels);
     psiMsave -= shift;
 
@@ -264,6 +265,16 @@ struct DiracDeterminantRef : public qmcplusplus::WaveFunctionComponent
     return curRatio;
   }
 
+  /** return determinant ratio for the row replacement by the orbitals psi
+   * @param iel the row (active particle) index
+   * @param psi the orbitals at the new position of iel
+   */
+  inline ValueType ratioFromOrbitals(int iel, const ValueType* psi) const
+  {
+    constexpr double czero(0);
+    return inner_product_n(psi, psiMinv[iel - FirstIndex], psiV.size(), czero);
+  }
+
   /** accept the row and update the inverse */
   inline void acceptMove(ParticleSet& P, int iel)
   {
@@ -272,6 +283,36 @@ struct DiracDeterminantRef : public qmcplusplus::WaveFunctionComponent
     std::copy_n(psiV.data(), nels, psiMsave[iel - FirstIndex]);
   }
 
+  /** permute the rows following the reordered particles
+   * @param new2old new2old[i] is the old index of the particle at the new index i
+   */
+  void reorderParticles(const std::vector<int>& new2old)
+  {
+    const int nels = psiV.size();
+    const qmcplusplus::Matrix<RealType> psiMsave_old(psiMsave);
+    for (int iel = 0; iel < nels; ++iel)
+      std::copy_n(psiMsave_old[new2old[iel + FirstIndex] - FirstIndex], nels, psiMsave[iel]);
+  }
+
+  /** the inverse and the rows are kept */
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    buf.add(psiMinv.first_address(), psiMinv.last_address());
+    buf.add(psiMsave.first_address(), psiMsave.last_address());
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.put(psiMinv.first_address(), psiMinv.last_address());
+    buf.put(psiMsave.first_address(), psiMsave.last_address());
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.get(psiMinv.first_address(), psiMinv.last_address());
+    buf.get(psiMsave.first_address(), psiMsave.last_address());
+  }
+
   /** accessor functions for checking */
   inline double operator()(int i) const { return psiMinv(i); }
   inline int size() const { return psiMinv.size(); }
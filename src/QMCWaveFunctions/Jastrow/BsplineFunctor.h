@@ -32,6 +32,7 @@
 #define QMCPLUSPLUS_BSPLINE_FUNCTOR_H
 #include "Numerics/OptimizableFunctorBase.h"
 #include "Utilities/SIMD/allocator.hpp"
+#include <algorithm>
 #include <cstdio>
 
 /*!
@@ -48,6 +49,13 @@ struct BsplineFunctor : public OptimizableFunctorBase
   int Dummy;
   const TinyVector<real_type, 16> A, dA, d2A, d3A;
   aligned_vector<real_type> SplineCoefs;
+  /** polynomial coefficients of each interval, refreshed by reset()
+   *
+   * PolyCoefs[4*i+k] is the coefficient of \f$t^{3-k}\f$ on the i-th interval,
+   * \f$u = ((c_0 t + c_1) t + c_2) t + c_3\f$ with \f$t = r/\Delta r - i\f$.
+   * The four coefficients of an interval are contiguous for a single gather.
+   */
+  aligned_vector<real_type> PolyCoefs;
 
   // static const real_type A[16], dA[16], d2A[16];
   real_type DeltaR, DeltaRInv;
@@ -63,6 +71,13 @@ struct BsplineFunctor : public OptimizableFunctorBase
   int ResetCount;
   bool notOpt;
   bool periodic;
+  /** minimum fraction of the pairs inside the cutoff to use the masked kernels
+   *
+   * Below it, evaluateV and evaluateVGL compress the pairs inside the cutoff
+   * before computing. Above it, all the pairs are computed and the ones
+   * outside are zeroed, which saves the compression and the scatter.
+   */
+  real_type MaskedFraction;
 
   /// constructor
   // clang-format off
@@ -84,7 +99,7 @@ struct BsplineFunctor : public OptimizableFunctorBase
         0.0, 0.0,  0.0,  3.0,
         0.0, 0.0,  0.0, -3.0,
         0.0, 0.0,  0.0,  1.0),
-    CuspValue(cusp), ResetCount(0), notOpt(false), periodic(true)
+    CuspValue(cusp), ResetCount(0), notOpt(false), periodic(true), MaskedFraction(0.5)
   {
     cutoff_radius = 0.0;
   }
@@ -115,6 +130,13 @@ struct BsplineFunctor : public OptimizableFunctorBase
     SplineCoefs[0] = Parameters[1] - 2.0 * DeltaR * CuspValue;
     for (int i = 2; i < Parameters.size(); i++)
       SplineCoefs[i + 1] = Parameters[i];
+    // contract the basis with the coefficients of each interval
+    const int numIntervals = numCoefs - 3;
+    PolyCoefs.resize(4 * numIntervals);
+    for (int i = 0; i < numIntervals; i++)
+      for (int k = 0; k < 4; k++)
+        PolyCoefs[4 * i + k] = SplineCoefs[i + 0] * A[k] + SplineCoefs[i + 1] * A[4 + k] +
+            SplineCoefs[i + 2] * A[8 + k] + SplineCoefs[i + 3] * A[12 + k];
   }
 
   void setupParameters(int n, real_type rcut, real_type cusp, std::vector<real_type>& params)
@@ -132,7 +154,7 @@ struct BsplineFunctor : public OptimizableFunctorBase
   /** compute value, gradient and laplacian for [iStart, iEnd) pairs
    * @param iStart starting particle index
    * @param iEnd ending particle index
-   * @param _distArray distance arrUay
+   * @param _distArray distance arrUay, in the precision of the distance table
    * @param _valArray  u(r_j) for j=[iStart,iEnd)
    * @param _gradArray  du(r_j)/dr /r_j for j=[iStart,iEnd)
    * @param _lapArray  d2u(r_j)/dr2 for j=[iStart,iEnd)
@@ -140,8 +162,9 @@ struct BsplineFunctor : public OptimizableFunctorBase
    * @param distIndices temp storage for the compressed index
    */
   // clang-format off
+  template<typename TD>
   void evaluateVGL(const int iat, const int iStart, const int iEnd, 
-      const T* _distArray,  
+      const TD* _distArray,  
       T* restrict _valArray,
       T* restrict _gradArray, 
       T* restrict _laplArray, 
@@ -151,16 +174,35 @@ struct BsplineFunctor : public OptimizableFunctorBase
   /** evaluate sum of the pair potentials for [iStart,iEnd)
    * @param iStart starting particle index
    * @param iEnd ending particle index
-   * @param _distArray distance arrUay
+   * @param _distArray distance arrUay, in the precision of the distance table
    * @param distArrayCompressed temp storage to filter r_j < cutoff_radius
    * @return \f$\sum u(r_j)\f$ for r_j < cutoff_radius
    */
+  template<typename TD>
   T evaluateV(const int iat,
               const int iStart,
               const int iEnd,
-              const T* restrict _distArray,
+              const TD* restrict _distArray,
               T* restrict distArrayCompressed) const;
 
+  /** return true if MaskedFraction of the iLimit pairs from iStart are inside the cutoff
+   *
+   * A counting pass over the distances only, so that the kernel of a call
+   * depends on its own pairs and the functor stays read-only.
+   */
+  template<typename TD>
+  inline bool useMasked(const int iat,
+                        const int iStart,
+                        const int iLimit,
+                        const TD* restrict distArray) const
+  {
+    int iCount = 0;
+#pragma omp simd reduction(+ : iCount)
+    for (int jat = 0; jat < iLimit; jat++)
+      iCount += (distArray[jat] < cutoff_radius && iStart + jat != iat);
+    return iLimit > 0 && iCount >= MaskedFraction * iLimit;
+  }
+
   inline real_type evaluate(real_type r)
   {
     if (r >= cutoff_radius)
@@ -220,17 +262,38 @@ struct BsplineFunctor : public OptimizableFunctorBase
 };
 
 template<typename T>
+template<typename TD>
 inline T BsplineFunctor<T>::evaluateV(const int iat,
                                       const int iStart,
                                       const int iEnd,
-                                      const T* restrict _distArray,
+                                      const TD* restrict _distArray,
                                       T* restrict distArrayCompressed) const
 {
-  const real_type* restrict distArray = _distArray + iStart;
+  const TD* restrict distArray = _distArray + iStart;
+  const int iLimit             = iEnd - iStart;
+
+  if (useMasked(iat, iStart, iLimit, distArray))
+  {
+    // evaluate all the pairs, at r=0 for the ones outside, and zero the latter
+    const int iMax = PolyCoefs.size() / 4 - 1;
+    real_type d    = 0.0;
+#pragma omp simd reduction(+ : d)
+    for (int jat = 0; jat < iLimit; jat++)
+    {
+      const real_type r0          = distArray[jat];
+      const bool inside           = r0 < cutoff_radius && iStart + jat != iat;
+      const real_type r           = (inside ? r0 : real_type(0)) * DeltaRInv;
+      const int i                 = std::min((int)r, iMax);
+      real_type t                 = r - real_type(i);
+      const real_type* restrict c = PolyCoefs.data() + 4 * i;
+      const real_type u           = ((c[0] * t + c[1]) * t + c[2]) * t + c[3];
+      d += inside ? u : real_type(0);
+    }
+    return d;
+  }
 
   ASSUME_ALIGNED(distArrayCompressed);
-  int iCount       = 0;
-  const int iLimit = iEnd - iStart;
+  int iCount = 0;
 
 #pragma vector always
   for (int jat = 0; jat < iLimit; jat++)
@@ -247,26 +310,20 @@ inline T BsplineFunctor<T>::evaluateV(const int iat,
   {
     real_type r = distArrayCompressed[jat];
     r *= DeltaRInv;
-    int i         = (int)r;
-    real_type t   = r - real_type(i);
-    real_type tp0 = t * t * t;
-    real_type tp1 = t * t;
-    real_type tp2 = t;
-
-    real_type d1 = SplineCoefs[i + 0] * (A[0] * tp0 + A[1] * tp1 + A[2] * tp2 + A[3]);
-    real_type d2 = SplineCoefs[i + 1] * (A[4] * tp0 + A[5] * tp1 + A[6] * tp2 + A[7]);
-    real_type d3 = SplineCoefs[i + 2] * (A[8] * tp0 + A[9] * tp1 + A[10] * tp2 + A[11]);
-    real_type d4 = SplineCoefs[i + 3] * (A[12] * tp0 + A[13] * tp1 + A[14] * tp2 + A[15]);
-    d += (d1 + d2 + d3 + d4);
+    int i                       = (int)r;
+    real_type t                 = r - real_type(i);
+    const real_type* restrict c = PolyCoefs.data() + 4 * i;
+    d += ((c[0] * t + c[1]) * t + c[2]) * t + c[3];
   }
   return d;
 }
 
 template<typename T>
+template<typename TD>
 inline void BsplineFunctor<T>::evaluateVGL(const int iat,
                                            const int iStart,
                                            const int iEnd,
-                                           const T* _distArray,
+                                           const TD* _distArray,
                                            T* restrict _valArray,
                                            T* restrict _gradArray,
                                            T* restrict _laplArray,
@@ -275,6 +332,9 @@ inline void BsplineFunctor<T>::evaluateVGL(const int iat,
 {
   real_type dSquareDeltaRinv = DeltaRInv * DeltaRInv;
   constexpr real_type cOne(1);
+  constexpr real_type cTwo(2);
+  constexpr real_type cThree(3);
+  constexpr real_type cSix(6);
 
   //    START_MARK_FIRST();
 
@@ -282,11 +342,41 @@ inline void BsplineFunctor<T>::evaluateVGL(const int iat,
   ASSUME_ALIGNED(distArrayCompressed);
   int iCount                 = 0;
   int iLimit                 = iEnd - iStart;
-  const real_type* distArray = _distArray + iStart;
+  const TD* distArray        = _distArray + iStart;
   real_type* valArray        = _valArray + iStart;
   real_type* gradArray       = _gradArray + iStart;
   real_type* laplArray       = _laplArray + iStart;
 
+  if (useMasked(iat, iStart, iLimit, distArray))
+  {
+    // evaluate all the pairs, at r=0 for the ones outside, and zero the latter
+    const int iMax = PolyCoefs.size() / 4 - 1;
+#pragma omp simd
+    for (int jat = 0; jat < iLimit; jat++)
+    {
+      const real_type r0 = distArray[jat];
+      const bool inside  = r0 < cutoff_radius && iStart + jat != iat;
+      real_type rinv     = cOne / (inside ? r0 : cOne);
+      real_type r        = (inside ? r0 : real_type(0)) * DeltaRInv;
+      const int iGather  = std::min((int)r, iMax);
+      real_type t        = r - real_type(iGather);
+
+      const real_type* restrict c = PolyCoefs.data() + 4 * iGather;
+      const real_type c0          = c[0];
+      const real_type c1          = c[1];
+      const real_type c2          = c[2];
+      const real_type c3          = c[3];
+
+      const real_type lapl = dSquareDeltaRinv * (cSix * c0 * t + cTwo * c1);
+      const real_type grad = DeltaRInv * rinv * ((cThree * c0 * t + cTwo * c1) * t + c2);
+      const real_type val  = ((c0 * t + c1) * t + c2) * t + c3;
+      laplArray[jat]       = inside ? lapl : real_type(0);
+      gradArray[jat]       = inside ? grad : real_type(0);
+      valArray[jat]        = inside ? val : real_type(0);
+    }
+    return;
+  }
+
 #pragma vector always
   for (int jat = 0; jat < iLimit; jat++)
   {
@@ -306,35 +396,18 @@ inline void BsplineFunctor<T>::evaluateVGL(const int iat,
     int iScatter   = distIndices[j];
     real_type rinv = cOne / r;
     r *= DeltaRInv;
-    int iGather   = (int)r;
-    real_type t   = r - real_type(iGather);
-    real_type tp0 = t * t * t;
-    real_type tp1 = t * t;
-    real_type tp2 = t;
-
-    real_type sCoef0 = SplineCoefs[iGather + 0];
-    real_type sCoef1 = SplineCoefs[iGather + 1];
-    real_type sCoef2 = SplineCoefs[iGather + 2];
-    real_type sCoef3 = SplineCoefs[iGather + 3];
+    int iGather = (int)r;
+    real_type t = r - real_type(iGather);
 
-    // clang-format off
-    laplArray[iScatter] = dSquareDeltaRinv *
-      (sCoef0*( d2A[ 2]*tp2 + d2A[ 3])+
-       sCoef1*( d2A[ 6]*tp2 + d2A[ 7])+
-       sCoef2*( d2A[10]*tp2 + d2A[11])+
-       sCoef3*( d2A[14]*tp2 + d2A[15]));
+    const real_type* restrict c = PolyCoefs.data() + 4 * iGather;
+    const real_type c0          = c[0];
+    const real_type c1          = c[1];
+    const real_type c2          = c[2];
+    const real_type c3          = c[3];
 
-    gradArray[iScatter] = DeltaRInv * rinv *
-      (sCoef0*( dA[ 1]*tp1 + dA[ 2]*tp2 + dA[ 3])+
-       sCoef1*( dA[ 5]*tp1 + dA[ 6]*tp2 + dA[ 7])+
-       sCoef2*( dA[ 9]*tp1 + dA[10]*tp2 + dA[11])+
-       sCoef3*( dA[13]*tp1 + dA[14]*tp2 + dA[15]));
-
-    valArray[iScatter] = (sCoef0*(A[ 0]*tp0 + A[ 1]*tp1 + A[ 2]*tp2 + A[ 3])+
-        sCoef1*(A[ 4]*tp0 + A[ 5]*tp1 + A[ 6]*tp2 + A[ 7])+
-        sCoef2*(A[ 8]*tp0 + A[ 9]*tp1 + A[10]*tp2 + A[11])+
-        sCoef3*(A[12]*tp0 + A[13]*tp1 + A[14]*tp2 + A[15]));
-    // clang-format on
+    laplArray[iScatter] = dSquareDeltaRinv * (cSix * c0 * t + cTwo * c1);
+    gradArray[iScatter] = DeltaRInv * rinv * ((cThree * c0 * t + cTwo * c1) * t + c2);
+    valArray[iScatter]  = ((c0 * t + c1) * t + c2) * t + c3;
   }
 }
 } // namespace qmcplusplus
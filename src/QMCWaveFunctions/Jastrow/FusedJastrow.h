@@ -0,0 +1,336 @@
+//////////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License. See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+//////////////////////////////////////////////////////////////////////////////////////
+// -*- C++ -*-
+#ifndef QMCPLUSPLUS_FUSEDJASTROW_H
+#define QMCPLUSPLUS_FUSEDJASTROW_H
+#include "Utilities/Configuration.h"
+#include "QMCWaveFunctions/WaveFunctionComponent.h"
+#include "QMCWaveFunctions/Jastrow/OneBodyJastrow.h"
+#include "QMCWaveFunctions/Jastrow/TwoBodyJastrow.h"
+#include "QMCWaveFunctions/Jastrow/ThreeBodyJastrow.h"
+
+/*!
+ * @file FusedJastrow.h
+ */
+
+namespace qmcplusplus
+{
+/** @ingroup WaveFunctionComponent
+ *  @brief One-, two- and optional three-body Jastrow factors evaluated as one component
+ *
+ * The components are owned and keep their own state. During a move, the
+ * e-I neighbors of the moving electron are swept once, evaluating the
+ * one-body terms inline and collecting the ions within the three-body
+ * cutoffs. The e-e row is swept once, a group of electrons at a time, the
+ * two-body values of a group being summed while they are in cache. The
+ * three-body terms only read the e-e entries of the electrons inside the
+ * cutoffs of the collected ions. The ratio of the product needs a single
+ * exponential. The other functions delegate to the components, the crowd
+ * versions to the crowd versions of the components.
+ */
+template<class FT1, class FT3>
+struct FusedJastrow : public WaveFunctionComponent
+{
+  using J1Type = OneBodyJastrow<FT1>;
+  using J2Type = TwoBodyJastrow<FT1>;
+  using J3Type = ThreeBodyJastrow<FT3>;
+  /// type of each component U, dU, d2U;
+  using valT = typename FT1::real_type;
+  /// element position type
+  using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
+
+  J1Type* J1;
+  J2Type* J2;
+  /// three-body component, nullptr if disabled
+  J3Type* J3;
+
+  /**@{ crowd scratch: the list of a component and its ratios */
+  std::vector<WaveFunctionComponent*> mw_list;
+  std::vector<ValueType> mw_ratios;
+  /**@}*/
+
+  FusedJastrow(J1Type* j1, J2Type* j2, J3Type* j3 = nullptr) : J1(j1), J2(j2), J3(j3)
+  {
+    WaveFunctionComponentName = "FusedJastrow";
+  }
+
+  FusedJastrow(const FusedJastrow& rhs) = delete;
+
+  ~FusedJastrow()
+  {
+    delete J1;
+    delete J2;
+    if (J3 != nullptr)
+      delete J3;
+  }
+
+  /// sum of the log values of the components
+  inline RealType sumLogValue() const
+  {
+    return J1->LogValue + J2->LogValue + (J3 != nullptr ? J3->LogValue : RealType(0));
+  }
+
+  RealType evaluateLog(ParticleSet& P,
+                       ParticleSet::ParticleGradient_t& G,
+                       ParticleSet::ParticleLaplacian_t& L)
+  {
+    J1->evaluateLog(P, G, L);
+    J2->evaluateLog(P, G, L);
+    if (J3 != nullptr)
+      J3->evaluateLog(P, G, L);
+    LogValue = sumLogValue();
+    return LogValue;
+  }
+
+  GradType evalGrad(ParticleSet& P, int iat)
+  {
+    GradType grad = J1->evalGrad(P, iat) + J2->evalGrad(P, iat);
+    if (J3 != nullptr)
+      grad += J3->evalGrad(P, iat);
+    return grad;
+  }
+
+  ValueType ratio(ParticleSet& P, int iat)
+  {
+    UpdateMode      = ORB_PBYP_RATIO;
+    ValueType ratio = J1->ratio(P, iat) * J2->ratio(P, iat);
+    if (J3 != nullptr)
+      ratio *= J3->ratio(P, iat);
+    return ratio;
+  }
+
+  /** ratioGrad sweeping the e-I and e-e rows of the move once
+   *
+   * Leaves the current values of the components ready for acceptMove.
+   */
+  ValueType ratioGrad(ParticleSet& P, int iat, GradType& grad_iat)
+  {
+    UpdateMode = ORB_PBYP_PARTIAL;
+    constexpr valT czero(0);
+    constexpr valT lapfac = OHMMS_DIM - valT(1);
+
+    const DistanceTableData& eI_table = (*P.DistTables[J1->myTableID]);
+    const DistanceTableData& ee_table = (*P.DistTables[0]);
+
+    // e-I row: one-body terms and the ions within the three-body cutoffs
+    J1->UpdateMode           = ORB_PBYP_PARTIAL;
+    const int nn             = eI_table.Temp_nn_count;
+    const int* restrict ids  = eI_table.Temp_nn_ids.data();
+    const distT* restrict r  = eI_table.Temp_nn_r.data();
+    const distT* restrict dX = eI_table.Temp_nn_dr.data(0);
+    const distT* restrict dY = eI_table.Temp_nn_dr.data(1);
+    const distT* restrict dZ = eI_table.Temp_nn_dr.data(2);
+    valT cur1(czero), lap1(czero), gx(czero), gy(czero), gz(czero);
+    if (J3 != nullptr)
+      J3->Scratch.ions_nearby.clear();
+    for (int k = 0; k < nn; ++k)
+    {
+      FT1* f1 = J1->F[J1->Ions.GroupID[ids[k]]];
+      if (f1 != nullptr)
+      {
+        valT du, d2u;
+        cur1 += f1->evaluate(r[k], du, d2u);
+        du /= r[k];
+        lap1 += d2u + lapfac * du;
+        gx += du * dX[k];
+        gy += du * dY[k];
+        gz += du * dZ[k];
+      }
+      if (J3 != nullptr && r[k] < J3->Ion_cutoff[ids[k]])
+        J3->Scratch.ions_nearby.push_back(k);
+    }
+    J1->curAt   = cur1;
+    J1->curLap  = lap1;
+    J1->curGrad = posT(gx, gy, gz);
+    valT diff   = J1->Vat[iat] - cur1;
+
+    // e-e row: two-body values of a group, summed with the gradient while in cache
+    J2->UpdateMode           = ORB_PBYP_PARTIAL;
+    const distT* restrict rr = ee_table.Temp_r.data();
+    const distT* restrict eX = ee_table.Temp_dr.data(0);
+    const distT* restrict eY = ee_table.Temp_dr.data(1);
+    const distT* restrict eZ = ee_table.Temp_dr.data(2);
+    valT* restrict u2        = J2->cur_u.data();
+    valT* restrict du2       = J2->cur_du.data();
+    valT* restrict d2u2      = J2->cur_d2u.data();
+    valT cur2(czero), hx(czero), hy(czero), hz(czero);
+    const int igt = P.GroupID[iat] * J2->NumGroups;
+    for (int jg = 0; jg < J2->NumGroups; ++jg)
+    {
+      const int jfirst = P.first(jg);
+      const int jlast  = P.last(jg);
+      if (jfirst == jlast)
+        continue;
+      std::fill(u2 + jfirst, u2 + jlast, czero);
+      std::fill(du2 + jfirst, du2 + jlast, czero);
+      std::fill(d2u2 + jfirst, d2u2 + jlast, czero);
+      J2->F[igt + jg]->evaluateVGL(iat,
+                                   jfirst,
+                                   jlast,
+                                   rr,
+                                   u2,
+                                   du2,
+                                   d2u2,
+                                   J2->DistCompressed.data(),
+                                   J2->DistIndice.data());
+#pragma omp simd reduction(+ : cur2, hx, hy, hz)
+      for (int j = jfirst; j < jlast; ++j)
+      {
+        cur2 += u2[j];
+        hx += du2[j] * eX[j];
+        hy += du2[j] * eY[j];
+        hz += du2[j] * eZ[j];
+      }
+    }
+    J2->cur_Uat = cur2;
+    J2->DiffVal = J2->Uat[iat] - cur2;
+    diff += J2->DiffVal;
+    grad_iat += J1->curGrad + posT(hx, hy, hz);
+
+    // three-body terms over the collected ions and the e-e row
+    if (J3 != nullptr)
+    {
+      J3->UpdateMode = ORB_PBYP_PARTIAL;
+      J3->computeU3_nearby(P,
+                           J3->Scratch,
+                           iat,
+                           ids,
+                           r,
+                           eI_table.Temp_nn_dr,
+                           ee_table.Temp_r.data(),
+                           ee_table.Temp_dr,
+                           J3->cur_Uat,
+                           J3->cur_dUat,
+                           J3->cur_d2Uat,
+                           J3->newUk,
+                           J3->newdUk,
+                           J3->newd2Uk);
+      J3->DiffVal = J3->Uat[iat] - J3->cur_Uat;
+      diff += J3->DiffVal;
+      grad_iat += J3->cur_dUat;
+    }
+    return std::exp(diff);
+  }
+
+  void acceptMove(ParticleSet& P, int iat)
+  {
+    J1->acceptMove(P, iat);
+    J2->acceptMove(P, iat);
+    if (J3 != nullptr)
+      J3->acceptMove(P, iat);
+    LogValue = sumLogValue();
+  }
+
+  /// fill mw_list with the component jc of the fused components of WFC_list
+  inline void buildComponentList(const std::vector<WaveFunctionComponent*>& WFC_list, int jc)
+  {
+    mw_list.resize(WFC_list.size());
+    for (int iw = 0; iw < WFC_list.size(); iw++)
+    {
+      FusedJastrow& fj = *static_cast<FusedJastrow*>(WFC_list[iw]);
+      mw_list[iw] = (jc == 0) ? static_cast<WaveFunctionComponent*>(fj.J1)
+                  : (jc == 1) ? static_cast<WaveFunctionComponent*>(fj.J2)
+                              : static_cast<WaveFunctionComponent*>(fj.J3);
+    }
+  }
+
+  /** crowd ratioGrad by the crowd kernels of the components
+   *
+   * The component of this serves as the scratch of the crowd for its kind.
+   */
+  void multi_ratioGrad(const std::vector<WaveFunctionComponent*>& WFC_list,
+                       const std::vector<ParticleSet*>& P_list,
+                       int iat,
+                       std::vector<ValueType>& ratios,
+                       std::vector<PosType>& grad_new,
+                       bool serial = false)
+  {
+    const int nw = P_list.size();
+    mw_ratios.resize(nw);
+    buildComponentList(WFC_list, 0);
+    J1->multi_ratioGrad(mw_list, P_list, iat, ratios, grad_new, serial);
+    buildComponentList(WFC_list, 1);
+    J2->multi_ratioGrad(mw_list, P_list, iat, mw_ratios, grad_new, serial);
+    for (int iw = 0; iw < nw; iw++)
+      ratios[iw] *= mw_ratios[iw];
+    if (J3 != nullptr)
+    {
+      buildComponentList(WFC_list, 2);
+      J3->multi_ratioGrad(mw_list, P_list, iat, mw_ratios, grad_new, serial);
+      for (int iw = 0; iw < nw; iw++)
+        ratios[iw] *= mw_ratios[iw];
+    }
+  }
+
+  void multi_acceptrestoreMove(const std::vector<WaveFunctionComponent*>& WFC_list,
+                               const std::vector<ParticleSet*>& P_list,
+                               const std::vector<bool>& isAccepted,
+                               int iat,
+                               bool serial = false)
+  {
+    buildComponentList(WFC_list, 0);
+    J1->multi_acceptrestoreMove(mw_list, P_list, isAccepted, iat, serial);
+    buildComponentList(WFC_list, 1);
+    J2->multi_acceptrestoreMove(mw_list, P_list, isAccepted, iat, serial);
+    if (J3 != nullptr)
+    {
+      buildComponentList(WFC_list, 2);
+      J3->multi_acceptrestoreMove(mw_list, P_list, isAccepted, iat, serial);
+    }
+    for (int iw = 0; iw < WFC_list.size(); iw++)
+      if (isAccepted[iw])
+      {
+        FusedJastrow& fj = *static_cast<FusedJastrow*>(WFC_list[iw]);
+        fj.LogValue      = fj.sumLogValue();
+      }
+  }
+
+  void evaluateGL(ParticleSet& P,
+                  ParticleSet::ParticleGradient_t& G,
+                  ParticleSet::ParticleLaplacian_t& L,
+                  bool fromscratch = false)
+  {
+    J1->evaluateGL(P, G, L, fromscratch);
+    J2->evaluateGL(P, G, L, fromscratch);
+    if (J3 != nullptr)
+      J3->evaluateGL(P, G, L, fromscratch);
+    LogValue = sumLogValue();
+  }
+
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    J1->registerData(P, buf);
+    J2->registerData(P, buf);
+    if (J3 != nullptr)
+      J3->registerData(P, buf);
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    J1->copyToBuffer(P, buf);
+    J2->copyToBuffer(P, buf);
+    if (J3 != nullptr)
+      J3->copyToBuffer(P, buf);
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    J1->copyFromBuffer(P, buf);
+    J2->copyFromBuffer(P, buf);
+    if (J3 != nullptr)
+      J3->copyFromBuffer(P, buf);
+    LogValue = sumLogValue();
+  }
+};
+} // namespace qmcplusplus
+#endif
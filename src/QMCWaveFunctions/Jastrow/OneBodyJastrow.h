@@ -16,6 +16,7 @@
 #include <Utilities/SIMD/allocator.hpp>
 #include <Utilities/SIMD/algorithm.hpp>
 #include <numeric>
+#include <algorithm>
 
 /*!
  * @file OneBodyJastrow.h
@@ -35,6 +36,8 @@ struct OneBodyJastrow : public WaveFunctionComponent
   using valT = typename FT::real_type;
   /// element position type
   using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
   /// use the same container
   using RowContainer = DistanceTableData::RowContainer;
   /// table index
@@ -47,6 +50,8 @@ struct OneBodyJastrow : public WaveFunctionComponent
   int NumGroups;
   /// reference to the sources (ions)
   const ParticleSet& Ions;
+  /// the largest cutoff of the functors
+  valT Rcut;
 
   valT curAt;
   valT curLap;
@@ -62,6 +67,19 @@ struct OneBodyJastrow : public WaveFunctionComponent
   /// Container for \f$F[ig*NumGroups+jg]\f$
   std::vector<FT*> F;
 
+  /**@{ walker-major scratch of the leading walker for the crowd kernels */
+  aligned_vector<distT> mw_dist;
+  aligned_vector<valT> mw_U, mw_dU, mw_d2U;
+  /// compression scratch of each thread, with the stride mw_stride
+  aligned_vector<valT> mw_DistCompressed;
+  aligned_vector<int> mw_DistIndice;
+  size_t mw_stride;
+  /// mw_bounds[iw*(NumGroups+1)+jg] first neighbor of the group jg of the walker iw
+  std::vector<int> mw_bounds;
+  /// mw_offsets[jg*(nw+1)+iw] first entry of the group jg of the walker iw
+  std::vector<size_t> mw_offsets;
+  /**@}*/
+
   OneBodyJastrow(const ParticleSet& ions, ParticleSet& els) : Ions(ions)
   {
     initalize(els);
@@ -88,7 +106,9 @@ struct OneBodyJastrow : public WaveFunctionComponent
     {
       NumGroups = 0;
     }
-    Nelec = els.getTotalNum();
+    Nelec     = els.getTotalNum();
+    Rcut      = valT(0);
+    mw_stride = 0;
     Vat.resize(Nelec);
     Grad.resize(Nelec);
     Lap.resize(Nelec);
@@ -105,16 +125,24 @@ struct OneBodyJastrow : public WaveFunctionComponent
     if (F[source_type] != nullptr)
       delete F[source_type];
     F[source_type] = afunc;
+    Rcut           = std::max(Rcut, static_cast<valT>(afunc->cutoff_radius));
   }
 
+  /** recompute internal data using the neighbor lists within Rcut
+   *
+   * The neighbor lists of the e-I table are requested here and used by all
+   * the other functions.
+   */
   void recompute(ParticleSet& P)
   {
-    const DistanceTableData& d_ie(*(P.DistTables[myTableID]));
+    DistanceTableData& d_ie(*(P.DistTables[myTableID]));
+    d_ie.requestNeighborList(Rcut);
     for (int iat = 0; iat < Nelec; ++iat)
     {
-      computeU3(P, iat, d_ie.Distances[iat]);
-      Vat[iat] = simd::accumulate_n(U.data(), Nions, valT());
-      Lap[iat] = accumulateGL(dU.data(), d2U.data(), d_ie.Displacements[iat], Grad[iat]);
+      const int nn = d_ie.NeighborCounts[iat];
+      computeU3(P, iat, nn, d_ie.NeighborIDs[iat], d_ie.NeighborDistances[iat]);
+      Vat[iat] = simd::accumulate_n(U.data(), nn, valT());
+      Lap[iat] = accumulateGL(nn, dU.data(), d2U.data(), d_ie.NeighborDisplacements[iat], Grad[iat]);
     }
   }
 
@@ -129,28 +157,37 @@ struct OneBodyJastrow : public WaveFunctionComponent
   ValueType ratio(ParticleSet& P, int iat)
   {
     UpdateMode = ORB_PBYP_RATIO;
-    curAt      = computeU(P.DistTables[myTableID]->Temp_r.data());
+    const DistanceTableData& d_ie(*(P.DistTables[myTableID]));
+    curAt = computeU(d_ie.Temp_nn_count, d_ie.Temp_nn_ids.data(), d_ie.Temp_nn_r.data());
     return std::exp(Vat[iat] - curAt);
   }
 
-  inline valT computeU(const valT* dist)
+  /** compute U of the neighbors
+   * @param nn number of the neighbors
+   * @param ids ion indices of the neighbors, sorted
+   * @param dist distances of the neighbors
+   */
+  inline valT computeU(int nn, const int* ids, const distT* dist)
   {
     valT curVat(0);
     if (NumGroups > 0)
     {
+      int kfirst = 0;
       for (int jg = 0; jg < NumGroups; ++jg)
       {
+        const int klast = std::lower_bound(ids + kfirst, ids + nn, Ions.last(jg)) - ids;
         if (F[jg] != nullptr)
-          curVat += F[jg]->evaluateV(-1, Ions.first(jg), Ions.last(jg), dist, DistCompressed.data());
+          curVat += F[jg]->evaluateV(-1, kfirst, klast, dist, DistCompressed.data());
+        kfirst = klast;
       }
     }
     else
     {
-      for (int c = 0; c < Nions; ++c)
+      for (int k = 0; k < nn; ++k)
       {
-        int gid = Ions.GroupID[c];
+        int gid = Ions.GroupID[ids[k]];
         if (F[gid] != nullptr)
-          curVat += F[gid]->evaluate(dist[c]);
+          curVat += F[gid]->evaluate(dist[k]);
       }
     }
     return curVat;
@@ -171,68 +208,97 @@ struct OneBodyJastrow : public WaveFunctionComponent
     LogValue = -simd::accumulate_n(Vat.data(), Nelec, valT());
   }
 
+  /** the per-electron values, gradients and laplacians are kept */
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    buf.add(Vat.data(), Vat.data() + Nelec);
+    buf.add(&Grad[0][0], &Grad[0][0] + Nelec * OHMMS_DIM);
+    buf.add(Lap.data(), Lap.data() + Nelec);
+    buf.add(LogValue);
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.put(Vat.data(), Vat.data() + Nelec);
+    buf.put(&Grad[0][0], &Grad[0][0] + Nelec * OHMMS_DIM);
+    buf.put(Lap.data(), Lap.data() + Nelec);
+    buf.put(LogValue);
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.get(Vat.data(), Vat.data() + Nelec);
+    buf.get(&Grad[0][0], &Grad[0][0] + Nelec * OHMMS_DIM);
+    buf.get(Lap.data(), Lap.data() + Nelec);
+    buf.get(LogValue);
+  }
+
   /** compute gradient and lap
    * @return lap
    */
-  inline valT accumulateGL(const valT* restrict du,
+  inline valT accumulateGL(int nn,
+                           const valT* restrict du,
                            const valT* restrict d2u,
                            const RowContainer& displ,
                            posT& grad) const
   {
     valT lap(0);
     constexpr valT lapfac = OHMMS_DIM - RealType(1);
-    for (int jat = 0; jat < Nions; ++jat)
+    for (int jat = 0; jat < nn; ++jat)
       lap += d2u[jat] + lapfac * du[jat];
     for (int idim = 0; idim < OHMMS_DIM; ++idim)
     {
-      const valT* restrict dX = displ.data(idim);
-      valT s                  = valT();
-      for (int jat = 0; jat < Nions; ++jat)
+      const distT* restrict dX = displ.data(idim);
+      valT s                   = valT();
+      for (int jat = 0; jat < nn; ++jat)
         s += du[jat] * dX[jat];
       grad[idim] = s;
     }
     return lap;
   }
 
-  /** compute U, dU and d2U
+  /** compute U, dU and d2U of the neighbors
    * @param P quantum particleset
    * @param iat the moving particle
-   * @param dist starting address of the distances of the ions wrt the iat-th
-   * particle
+   * @param nn number of the neighbors
+   * @param ids ion indices of the neighbors, sorted
+   * @param dist distances of the neighbors
    */
-  inline void computeU3(ParticleSet& P, int iat, const valT* dist)
+  inline void computeU3(ParticleSet& P, int iat, int nn, const int* ids, const distT* dist)
   {
+    constexpr valT czero(0);
+    std::fill_n(U.data(), nn, czero);
+    std::fill_n(dU.data(), nn, czero);
+    std::fill_n(d2U.data(), nn, czero);
+
     if (NumGroups > 0)
     { // ions are grouped
-      constexpr valT czero(0);
-      std::fill_n(U.data(), Nions, czero);
-      std::fill_n(dU.data(), Nions, czero);
-      std::fill_n(d2U.data(), Nions, czero);
-
+      int kfirst = 0;
       for (int jg = 0; jg < NumGroups; ++jg)
       {
-        if (F[jg] == nullptr)
-          continue;
-        F[jg]->evaluateVGL(-1,
-                           Ions.first(jg),
-                           Ions.last(jg),
-                           dist,
-                           U.data(),
-                           dU.data(),
-                           d2U.data(),
-                           DistCompressed.data(),
-                           DistIndice.data());
+        const int klast = std::lower_bound(ids + kfirst, ids + nn, Ions.last(jg)) - ids;
+        if (F[jg] != nullptr)
+          F[jg]->evaluateVGL(-1,
+                             kfirst,
+                             klast,
+                             dist,
+                             U.data(),
+                             dU.data(),
+                             d2U.data(),
+                             DistCompressed.data(),
+                             DistIndice.data());
+        kfirst = klast;
       }
     }
     else
     {
-      for (int c = 0; c < Nions; ++c)
+      for (int k = 0; k < nn; ++k)
       {
-        int gid = Ions.GroupID[c];
+        int gid = Ions.GroupID[ids[k]];
         if (F[gid] != nullptr)
         {
-          U[c] = F[gid]->evaluate(dist[c], dU[c], d2U[c]);
-          dU[c] /= dist[c];
+          U[k] = F[gid]->evaluate(dist[k], dU[k], d2U[k]);
+          dU[k] /= dist[k];
         }
       }
     }
@@ -248,15 +314,17 @@ struct OneBodyJastrow : public WaveFunctionComponent
    * @param P quantum particleset
    * @param iat particle index
    *
-   * Using Temp_r. curAt, curGrad and curLap are computed.
+   * Using the neighbor list of the move. curAt, curGrad and curLap are computed.
    */
   ValueType ratioGrad(ParticleSet& P, int iat, GradType& grad_iat)
   {
     UpdateMode = ORB_PBYP_PARTIAL;
 
-    computeU3(P, iat, P.DistTables[myTableID]->Temp_r.data());
-    curLap = accumulateGL(dU.data(), d2U.data(), P.DistTables[myTableID]->Temp_dr, curGrad);
-    curAt  = simd::accumulate_n(U.data(), Nions, valT());
+    const DistanceTableData& d_ie(*(P.DistTables[myTableID]));
+    const int nn = d_ie.Temp_nn_count;
+    computeU3(P, iat, nn, d_ie.Temp_nn_ids.data(), d_ie.Temp_nn_r.data());
+    curLap = accumulateGL(nn, dU.data(), d2U.data(), d_ie.Temp_nn_dr, curGrad);
+    curAt  = simd::accumulate_n(U.data(), nn, valT());
     grad_iat += curGrad;
     return std::exp(Vat[iat] - curAt);
   }
@@ -266,8 +334,10 @@ struct OneBodyJastrow : public WaveFunctionComponent
   {
     if (UpdateMode == ORB_PBYP_RATIO)
     {
-      computeU3(P, iat, P.DistTables[myTableID]->Temp_r.data());
-      curLap = accumulateGL(dU.data(), d2U.data(), P.DistTables[myTableID]->Temp_dr, curGrad);
+      const DistanceTableData& d_ie(*(P.DistTables[myTableID]));
+      const int nn = d_ie.Temp_nn_count;
+      computeU3(P, iat, nn, d_ie.Temp_nn_ids.data(), d_ie.Temp_nn_r.data());
+      curLap = accumulateGL(nn, dU.data(), d2U.data(), d_ie.Temp_nn_dr, curGrad);
     }
 
     LogValue += Vat[iat] - curAt;
@@ -275,6 +345,142 @@ struct OneBodyJastrow : public WaveFunctionComponent
     Grad[iat] = curGrad;
     Lap[iat]  = curLap;
   }
+
+  /** crowd version of ratioGrad
+   *
+   * The neighbors of each ion group are gathered over all the walkers and
+   * evaluated in one pass. The functors of this are used for the whole crowd,
+   * which must share them.
+   */
+  void multi_ratioGrad(const std::vector<WaveFunctionComponent*>& WFC_list,
+                       const std::vector<ParticleSet*>& P_list,
+                       int iat,
+                       std::vector<ValueType>& ratios,
+                       std::vector<PosType>& grad_new,
+                       bool serial = false)
+  {
+    if (NumGroups == 0)
+    { // ions are not grouped
+      WaveFunctionComponent::multi_ratioGrad(WFC_list, P_list, iat, ratios, grad_new, serial);
+      return;
+    }
+
+    const int nw = WFC_list.size();
+    const int ng = NumGroups;
+    mw_bounds.resize(nw * (ng + 1));
+    mw_offsets.resize(ng * (nw + 1));
+    for (int iw = 0; iw < nw; iw++)
+    {
+      const DistanceTableData& d_ie(*(P_list[iw]->DistTables[myTableID]));
+      const int* ids = d_ie.Temp_nn_ids.data();
+      int* bounds    = mw_bounds.data() + iw * (ng + 1);
+      bounds[0]      = 0;
+      for (int jg = 0; jg < ng; ++jg)
+        bounds[jg + 1] =
+            std::lower_bound(ids + bounds[jg], ids + d_ie.Temp_nn_count, Ions.last(jg)) - ids;
+    }
+    size_t mw_size = 0;
+    for (int jg = 0; jg < ng; ++jg)
+    {
+      for (int iw = 0; iw < nw; iw++)
+      {
+        mw_offsets[jg * (nw + 1) + iw] = mw_size;
+        mw_size += mw_bounds[iw * (ng + 1) + jg + 1] - mw_bounds[iw * (ng + 1) + jg];
+      }
+      mw_offsets[jg * (nw + 1) + nw] = mw_size;
+    }
+    mw_stride = getAlignedSize<valT>(mw_size);
+    mw_dist.resize(mw_size);
+    mw_U.resize(mw_size);
+    mw_dU.resize(mw_size);
+    mw_d2U.resize(mw_size);
+    mw_DistCompressed.resize(getCrowdThreads(serial) * mw_stride);
+    mw_DistIndice.resize(getCrowdThreads(serial) * mw_stride);
+
+    crowd_parallel(serial, [&](int np, int ip) {
+      const int iw_first = nw * ip / np;
+      const int iw_last  = nw * (ip + 1) / np;
+
+      constexpr valT czero(0);
+      for (int jg = 0; jg < ng; ++jg)
+      {
+        for (int iw = iw_first; iw < iw_last; iw++)
+        {
+          const DistanceTableData& d_ie(*(P_list[iw]->DistTables[myTableID]));
+          const int kfirst = mw_bounds[iw * (ng + 1) + jg];
+          const int klast  = mw_bounds[iw * (ng + 1) + jg + 1];
+          std::copy_n(d_ie.Temp_nn_r.data() + kfirst,
+                      klast - kfirst,
+                      mw_dist.data() + mw_offsets[jg * (nw + 1) + iw]);
+        }
+        const size_t first = mw_offsets[jg * (nw + 1) + iw_first];
+        const size_t last  = mw_offsets[jg * (nw + 1) + iw_last];
+        std::fill(mw_U.begin() + first, mw_U.begin() + last, czero);
+        std::fill(mw_dU.begin() + first, mw_dU.begin() + last, czero);
+        std::fill(mw_d2U.begin() + first, mw_d2U.begin() + last, czero);
+        if (F[jg] != nullptr)
+          F[jg]->evaluateVGL(-1,
+                             first,
+                             last,
+                             mw_dist.data(),
+                             mw_U.data(),
+                             mw_dU.data(),
+                             mw_d2U.data(),
+                             mw_DistCompressed.data() + ip * mw_stride,
+                             mw_DistIndice.data() + ip * mw_stride);
+      }
+
+      constexpr valT lapfac = OHMMS_DIM - RealType(1);
+      for (int iw = iw_first; iw < iw_last; iw++)
+      {
+        OneBodyJastrow& J1(static_cast<OneBodyJastrow&>(*WFC_list[iw]));
+        const RowContainer& displ = P_list[iw]->DistTables[myTableID]->Temp_nn_dr;
+        valT u(0), lap(0);
+        posT grad;
+        for (int jg = 0; jg < ng; ++jg)
+        {
+          const int kfirst         = mw_bounds[iw * (ng + 1) + jg];
+          const int len            = mw_bounds[iw * (ng + 1) + jg + 1] - kfirst;
+          const size_t offset      = mw_offsets[jg * (nw + 1) + iw];
+          const valT* restrict du  = mw_dU.data() + offset;
+          const valT* restrict d2u = mw_d2U.data() + offset;
+          u += simd::accumulate_n(mw_U.data() + offset, len, valT());
+          for (int j = 0; j < len; ++j)
+            lap += d2u[j] + lapfac * du[j];
+          for (int idim = 0; idim < OHMMS_DIM; ++idim)
+          {
+            const distT* restrict dX = displ.data(idim) + kfirst;
+            valT s                   = valT();
+            for (int j = 0; j < len; ++j)
+              s += du[j] * dX[j];
+            grad[idim] += s;
+          }
+        }
+        J1.UpdateMode = ORB_PBYP_PARTIAL;
+        J1.curAt      = u;
+        J1.curLap     = lap;
+        J1.curGrad    = grad;
+        grad_new[iw] += grad;
+        ratios[iw] = std::exp(J1.Vat[iat] - u);
+      }
+    });
+  }
+
+  /** crowd version of acceptMove
+   *
+   * multi_ratioGrad left the new values in each walker, so the update is O(1)
+   * per walker and is not worth a parallel region.
+   */
+  void multi_acceptrestoreMove(const std::vector<WaveFunctionComponent*>& WFC_list,
+                               const std::vector<ParticleSet*>& P_list,
+                               const std::vector<bool>& isAccepted,
+                               int iat,
+                               bool serial = false)
+  {
+    for (int iw = 0; iw < WFC_list.size(); iw++)
+      if (isAccepted[iw])
+        WFC_list[iw]->acceptMove(*P_list[iw], iat);
+  }
 };
 
 } // namespace qmcplusplus
@@ -35,6 +35,8 @@ struct OneBodyJastrowRef : public WaveFunctionComponent
   using valT = typename FT::real_type;
   /// element position type
   using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
   /// use the same container
   using RowContainer = DistanceTableData::RowContainer;
   /// table index
@@ -133,7 +135,7 @@ struct OneBodyJastrowRef : public WaveFunctionComponent
     return std::exp(Vat[iat] - curAt);
   }
 
-  inline valT computeU(const valT* dist)
+  inline valT computeU(const distT* dist)
   {
     valT curVat(0);
     if (NumGroups > 0)
@@ -171,6 +173,31 @@ struct OneBodyJastrowRef : public WaveFunctionComponent
     LogValue = -std::accumulate(Vat.begin(), Vat.begin() + Nelec, valT());
   }
 
+  /** the per-electron values, gradients and laplacians are kept */
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    buf.add(Vat.data(), Vat.data() + Nelec);
+    buf.add(&Grad[0][0], &Grad[0][0] + Nelec * OHMMS_DIM);
+    buf.add(Lap.data(), Lap.data() + Nelec);
+    buf.add(LogValue);
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.put(Vat.data(), Vat.data() + Nelec);
+    buf.put(&Grad[0][0], &Grad[0][0] + Nelec * OHMMS_DIM);
+    buf.put(Lap.data(), Lap.data() + Nelec);
+    buf.put(LogValue);
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.get(Vat.data(), Vat.data() + Nelec);
+    buf.get(&Grad[0][0], &Grad[0][0] + Nelec * OHMMS_DIM);
+    buf.get(Lap.data(), Lap.data() + Nelec);
+    buf.get(LogValue);
+  }
+
   /** compute gradient and lap
    * @return lap
    */
@@ -185,8 +212,8 @@ struct OneBodyJastrowRef : public WaveFunctionComponent
       lap += d2u[jat] + lapfac * du[jat];
     for (int idim = 0; idim < OHMMS_DIM; ++idim)
     {
-      const valT* restrict dX = displ.data(idim);
-      valT s                  = valT();
+      const distT* restrict dX = displ.data(idim);
+      valT s                   = valT();
       for (int jat = 0; jat < Nions; ++jat)
         s += du[jat] * dX[jat];
       grad[idim] = s;
@@ -200,7 +227,7 @@ struct OneBodyJastrowRef : public WaveFunctionComponent
    * @param dist starting address of the distances of the ions wrt the iat-th
    * particle
    */
-  inline void computeU3(ParticleSet& P, int iat, const valT* dist)
+  inline void computeU3(ParticleSet& P, int iat, const distT* dist)
   {
     if (NumGroups > 0)
     { // ions are grouped
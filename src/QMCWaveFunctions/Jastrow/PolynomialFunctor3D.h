@@ -58,9 +58,39 @@ struct PolynomialFunctor3D : public OptimizableFunctorBase
   const int C;
   bool notOpt;
 
+  /// type of the evaluateV kernels
+  using VKernelType = real_type (PolynomialFunctor3D::*)(int,
+                                                         const real_type* restrict,
+                                                         const real_type* restrict,
+                                                         const real_type* restrict) const;
+  /// type of the evaluateVGL kernels
+  using VGLKernelType = void (PolynomialFunctor3D::*)(int,
+                                                      const real_type* restrict,
+                                                      const real_type* restrict,
+                                                      const real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict,
+                                                      real_type* restrict) const;
+  /// kernels for the current degrees, selected by resize
+  VKernelType VKernel;
+  VGLKernelType VGLKernel;
+
   /// constructor
   PolynomialFunctor3D(real_type ee_cusp = 0.0, real_type eI_cusp = 0.0)
-      : N_eI(0), N_ee(0), ResetCount(0), C(3), scale(1.0), notOpt(false)
+      : N_eI(0),
+        N_ee(0),
+        ResetCount(0),
+        C(3),
+        scale(1.0),
+        notOpt(false),
+        VKernel(&PolynomialFunctor3D::evaluateV_kernel<-1, -1>),
+        VGLKernel(&PolynomialFunctor3D::evaluateVGL_kernel<-1, -1>)
   {
     if (std::abs(ee_cusp) > 0.0 || std::abs(eI_cusp) > 0.0)
     {
@@ -196,6 +226,37 @@ struct PolynomialFunctor3D : public OptimizableFunctorBase
     }
     for (int c = col + 1; c < NumGamma; c++)
       IndepVar[c] = true;
+
+    selectKernels();
+  }
+
+  /** select the evaluateV and evaluateVGL kernels for the degrees in use
+   *
+   * The degrees used in production have kernels with the power series
+   * fully unrolled at compile time; others fall back to runtime loops.
+   */
+  void selectKernels()
+  {
+    if (N_eI == 3 && N_ee == 3)
+    {
+      VKernel   = &PolynomialFunctor3D::evaluateV_kernel<3, 3>;
+      VGLKernel = &PolynomialFunctor3D::evaluateVGL_kernel<3, 3>;
+    }
+    else if (N_eI == 2 && N_ee == 2)
+    {
+      VKernel   = &PolynomialFunctor3D::evaluateV_kernel<2, 2>;
+      VGLKernel = &PolynomialFunctor3D::evaluateVGL_kernel<2, 2>;
+    }
+    else if (N_eI == 4 && N_ee == 4)
+    {
+      VKernel   = &PolynomialFunctor3D::evaluateV_kernel<4, 4>;
+      VGLKernel = &PolynomialFunctor3D::evaluateVGL_kernel<4, 4>;
+    }
+    else
+    {
+      VKernel   = &PolynomialFunctor3D::evaluateV_kernel<-1, -1>;
+      VGLKernel = &PolynomialFunctor3D::evaluateVGL_kernel<-1, -1>;
+    }
   }
 
   void reset()
@@ -326,13 +387,27 @@ struct PolynomialFunctor3D : public OptimizableFunctorBase
                              const real_type* restrict r_12_array,
                              const real_type* restrict r_1I_array,
                              const real_type* restrict r_2I_array) const
+  {
+    return (this->*VKernel)(Nptcl, r_12_array, r_1I_array, r_2I_array);
+  }
+
+  /** evaluateV kernel for the degrees NEI and NEE, runtime degrees if negative
+   */
+  template<int NEI, int NEE>
+  real_type evaluateV_kernel(int Nptcl,
+                             const real_type* restrict r_12_array,
+                             const real_type* restrict r_1I_array,
+                             const real_type* restrict r_2I_array) const
   {
     constexpr real_type czero(0);
     constexpr real_type cone(1);
     constexpr real_type chalf(0.5);
 
-    const real_type L = chalf * cutoff_radius;
-    real_type val_tot = czero;
+    const int neI               = NEI < 0 ? N_eI : NEI;
+    const int nee               = NEE < 0 ? N_ee : NEE;
+    const real_type* restrict g = gamma.data();
+    const real_type L           = chalf * cutoff_radius;
+    real_type val_tot           = czero;
 
 #pragma omp simd aligned(r_12_array, r_1I_array, r_2I_array) reduction(+ : val_tot)
     for (int ptcl = 0; ptcl < Nptcl; ptcl++)
@@ -342,15 +417,15 @@ struct PolynomialFunctor3D : public OptimizableFunctorBase
       const real_type r_2I = r_2I_array[ptcl];
       real_type val        = czero;
       real_type r2l(cone);
-      for (int l = 0; l <= N_eI; l++)
+      for (int l = 0; l <= neI; l++)
       {
         real_type r2m(r2l);
-        for (int m = 0; m <= N_eI; m++)
+        for (int m = 0; m <= neI; m++)
         {
           real_type r2n(r2m);
-          for (int n = 0; n <= N_ee; n++)
+          for (int n = 0; n <= nee; n++)
           {
-            val += gamma(l, m, n) * r2n;
+            val += g[(l * (neI + 1) + m) * (nee + 1) + n] * r2n;
             r2n *= r_12;
           }
           r2m *= r_2I;
@@ -464,13 +539,48 @@ struct PolynomialFunctor3D : public OptimizableFunctorBase
                           real_type* restrict hess22_array,
                           real_type* restrict hess01_array,
                           real_type* restrict hess02_array) const
+  {
+    (this->*VGLKernel)(Nptcl,
+                       r_12_array,
+                       r_1I_array,
+                       r_2I_array,
+                       val_array,
+                       grad0_array,
+                       grad1_array,
+                       grad2_array,
+                       hess00_array,
+                       hess11_array,
+                       hess22_array,
+                       hess01_array,
+                       hess02_array);
+  }
+
+  /** evaluateVGL kernel for the degrees NEI and NEE, runtime degrees if negative
+   */
+  template<int NEI, int NEE>
+  void evaluateVGL_kernel(int Nptcl,
+                          const real_type* restrict r_12_array,
+                          const real_type* restrict r_1I_array,
+                          const real_type* restrict r_2I_array,
+                          real_type* restrict val_array,
+                          real_type* restrict grad0_array,
+                          real_type* restrict grad1_array,
+                          real_type* restrict grad2_array,
+                          real_type* restrict hess00_array,
+                          real_type* restrict hess11_array,
+                          real_type* restrict hess22_array,
+                          real_type* restrict hess01_array,
+                          real_type* restrict hess02_array) const
   {
     constexpr real_type czero(0);
     constexpr real_type cone(1);
     constexpr real_type chalf(0.5);
     constexpr real_type ctwo(2);
 
-    const real_type L = chalf * cutoff_radius;
+    const int neI               = NEI < 0 ? N_eI : NEI;
+    const int nee               = NEE < 0 ? N_ee : NEE;
+    const real_type* restrict g = gamma.data();
+    const real_type L           = chalf * cutoff_radius;
     #pragma omp simd aligned(r_12_array,   \
                              r_1I_array,   \
                              r_2I_array,   \
@@ -500,19 +610,19 @@ struct PolynomialFunctor3D : public OptimizableFunctorBase
       real_type hess02(czero);
 
       real_type r2l(cone), r2l_1(czero), r2l_2(czero), lf(czero);
-      for (int l = 0; l <= N_eI; l++)
+      for (int l = 0; l <= neI; l++)
       {
         real_type r2m(cone), r2m_1(czero), r2m_2(czero), mf(czero);
-        for (int m = 0; m <= N_eI; m++)
+        for (int m = 0; m <= neI; m++)
         {
           real_type r2n(cone), r2n_1(czero), r2n_2(czero), nf(czero);
-          for (int n = 0; n <= N_ee; n++)
+          for (int n = 0; n <= nee; n++)
           {
-            const real_type g    = gamma(l, m, n);
-            const real_type g00x = g * r2l * r2m;
-            const real_type g10x = g * r2l_1 * r2m;
-            const real_type g01x = g * r2l * r2m_1;
-            const real_type gxx0 = g * r2n;
+            const real_type glmn = g[(l * (neI + 1) + m) * (nee + 1) + n];
+            const real_type g00x = glmn * r2l * r2m;
+            const real_type g10x = glmn * r2l_1 * r2m;
+            const real_type g01x = glmn * r2l * r2m_1;
+            const real_type gxx0 = glmn * r2n;
 
             val += g00x * r2n;
             grad0 += g00x * r2n_1;
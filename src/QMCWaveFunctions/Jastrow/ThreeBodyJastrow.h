@@ -15,7 +15,9 @@
 #include "Particle/DistanceTableData.h"
 #include <Utilities/SIMD/allocator.hpp>
 #include <Utilities/SIMD/algorithm.hpp>
+#include "Utilities/WalkerTeam.h"
 #include <numeric>
+#include <algorithm>
 
 namespace qmcplusplus
 {
@@ -27,13 +29,22 @@ namespace qmcplusplus
  *For electrons, distinct pair correlation functions are used
  *for spins up-up/down-down and up-down/down-up.
  */
+template<class FT1, class FT3>
+struct FusedJastrow;
+
 template<class FT>
 class ThreeBodyJastrow : public WaveFunctionComponent
 {
+  /// the fused engine drives the compute kernels directly
+  template<class FT1, class FT3>
+  friend struct FusedJastrow;
+
   /// type of each component U, dU, d2U;
   using valT = typename FT::real_type;
   /// element position type
   using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
   /// use the same container
   using RowContainer = DistanceTableData::RowContainer;
   /// table index for i-el, el-el is always zero
@@ -64,22 +75,91 @@ class ThreeBodyJastrow : public WaveFunctionComponent
 
   /// the cutoff for e-I pairs
   std::vector<valT> Ion_cutoff;
-  /// the electrons around ions within the cutoff radius, grouped by species
-  Array<std::vector<int>, 2> elecs_inside;
-  Array<std::vector<valT>, 2> elecs_inside_dist;
-  Array<std::vector<posT>, 2> elecs_inside_displ;
-  /// the ions around
-  std::vector<int> ions_nearby;
+  /** the electrons around ions within the cutoff radius, grouped by species
+   *
+   * The list of the jg-th group around the iat-th ion occupies
+   * elecs_inside_num(jg, iat) slots from list_offset(jg, iat), with a
+   * capacity of group_capacity[jg]. The capacities are set from the density
+   * of the electrons within the cutoff by the first build_compact_list and
+   * grow when a list is full.
+   */
+  aligned_vector<int> elecs_inside;
+  aligned_vector<valT> elecs_inside_dist;
+  gContainer_type elecs_inside_displ;
+  /// number of the electrons in each list
+  Array<int, 2> elecs_inside_num;
+  /// elecs_inside_slot(iat, jel) slot of jel in its list around iat, -1 if outside
+  Array<int, 2> elecs_inside_slot;
+  /// offsets of the electron groups within the lists of an ion
+  std::vector<int> group_offset;
+  /// capacity of the list of each electron group around an ion
+  std::vector<int> group_capacity;
+  /// stride of the lists of an ion
+  int elecs_stride;
+  /// number of the list entries a walker buffer has room for
+  int elecs_inside_room;
 
   /// work buffer size
   size_t Nbuffer;
-  /// compressed distances
-  aligned_vector<valT> Distjk_Compressed, DistkI_Compressed, DistjI_Compressed;
-  std::vector<int> DistIndice_k;
-  /// compressed displacements
-  gContainer_type Disp_jk_Compressed, Disp_jI_Compressed, Disp_kI_Compressed;
-  /// work result buffer
-  VectorSoAContainer<valT, 9> mVGL;
+  /// scratch of the compute kernels for one electron
+  struct RowScratch
+  {
+    /// the ions around
+    std::vector<int> ions_nearby;
+    /// compressed distances
+    aligned_vector<valT> Distjk_Compressed, DistkI_Compressed, DistjI_Compressed;
+    std::vector<int> DistIndice_k;
+    /// compressed displacements
+    gContainer_type Disp_jk_Compressed, Disp_jI_Compressed, Disp_kI_Compressed;
+    /// work result buffer
+    VectorSoAContainer<valT, 9> mVGL;
+
+    void resize(int nion, size_t nbuffer)
+    {
+      ions_nearby.resize(nion);
+      mVGL.resize(nbuffer);
+      Distjk_Compressed.resize(nbuffer);
+      DistjI_Compressed.resize(nbuffer);
+      DistkI_Compressed.resize(nbuffer);
+      Disp_jk_Compressed.resize(nbuffer);
+      Disp_jI_Compressed.resize(nbuffer);
+      Disp_kI_Compressed.resize(nbuffer);
+      DistIndice_k.resize(nbuffer);
+    }
+  };
+  /// scratch of the single-walker kernels
+  RowScratch Scratch;
+  /// partial sums of U, laplacian and gradient of each member of the walker team in recompute
+  aligned_vector<valT> team_sums;
+
+  /**@{ packed triplets of the crowd kernels
+   *
+   * The triplets of a crowd are packed in segments of the same functor, by
+   * the ion group ig and the electron group kg. Each segment starts at an
+   * aligned offset and holds the triplets of each walker contiguously.
+   */
+  /// mw_count[iseg * nw + iw] number of the triplets of the iw-th walker in the iseg-th segment
+  std::vector<int> mw_count;
+  /// mw_begin[iseg * nw + iw] first triplet of the iw-th walker in the iseg-th segment
+  std::vector<int> mw_begin;
+  /// end of each segment
+  std::vector<int> mw_end;
+  /// mw_next[iw * nseg + iseg] next free triplet of the iw-th walker in the iseg-th segment
+  std::vector<int> mw_next;
+  /// segment and first triplet of each chunk
+  std::vector<int> mw_chunk_seg, mw_chunk_first;
+  /// accepted walkers and those of them moved by ratio only, in multi_acceptrestoreMove
+  std::vector<WaveFunctionComponent*> mw_acc_list, mw_ratio_list;
+  std::vector<ParticleSet*> mw_acc_P_list, mw_ratio_P_list;
+  /// capacity of the packed buffers
+  size_t mw_capacity;
+  aligned_vector<valT> mw_Distjk, mw_DistjI, mw_DistkI;
+  gContainer_type mw_Disp_jk, mw_Disp_jI, mw_Disp_kI;
+  /// index of the k-th electron of each triplet
+  aligned_vector<int> mw_kel;
+  /// results of evaluateVGL, turned in place into the terms of the j-th and k-th electrons
+  VectorSoAContainer<valT, 9> mw_VGL;
+  /**@}*/
 
 public:
   /// alias FuncType
@@ -116,22 +196,20 @@ public:
 
     F.resize(iGroups, eGroups, eGroups);
     F = nullptr;
-    elecs_inside.resize(eGroups, Nion);
-    elecs_inside_dist.resize(eGroups, Nion);
-    elecs_inside_displ.resize(eGroups, Nion);
-    ions_nearby.resize(Nion);
+    // the lists are laid out by the first build_compact_list, once the cutoffs are known
+    group_offset.resize(eGroups);
+    group_capacity.resize(eGroups, 0);
+    elecs_stride      = 0;
+    elecs_inside_room = 0;
+    elecs_inside_num.resize(eGroups, Nion);
+    elecs_inside_num = 0;
+    elecs_inside_slot.resize(Nion, Nelec);
     Ion_cutoff.resize(Nion, 0.0);
 
     // initialize buffers
     Nbuffer = Nelec;
-    mVGL.resize(Nbuffer);
-    Distjk_Compressed.resize(Nbuffer);
-    DistjI_Compressed.resize(Nbuffer);
-    DistkI_Compressed.resize(Nbuffer);
-    Disp_jk_Compressed.resize(Nbuffer);
-    Disp_jI_Compressed.resize(Nbuffer);
-    Disp_kI_Compressed.resize(Nbuffer);
-    DistIndice_k.resize(Nbuffer);
+    Scratch.resize(Nion, Nbuffer);
+    mw_capacity = 0;
   }
 
   void addFunc(int iSpecies, int eSpecies1, int eSpecies2, FT* j)
@@ -219,27 +297,132 @@ public:
     }
   }
 
+  /** build the compact lists of the electrons near each ion
+   *
+   * The neighbor lists of the e-I table within the largest Ion_cutoff are
+   * requested here and used by all the other functions.
+   */
   void build_compact_list(ParticleSet& P)
   {
-    const DistanceTableData& eI_table = (*P.DistTables[myTableID]);
+    DistanceTableData& eI_table = (*P.DistTables[myTableID]);
+    const valT rmax             = *std::max_element(Ion_cutoff.begin(), Ion_cutoff.end());
+    eI_table.requestNeighborList(rmax);
+    if (elecs_stride == 0)
+      init_lists(P, rmax);
 
-    for (int iat = 0; iat < Nion; ++iat)
-      for (int jg = 0; jg < eGroups; ++jg)
+    elecs_inside_num  = 0;
+    elecs_inside_slot = -1;
+
+    for (int jg = 0; jg < eGroups; ++jg)
+      for (int jel = P.first(jg); jel < P.last(jg); jel++)
       {
-        elecs_inside(jg, iat).clear();
-        elecs_inside_dist(jg, iat).clear();
-        elecs_inside_displ(jg, iat).clear();
+        const int* restrict ids = eI_table.NeighborIDs[jel];
+        for (int k = 0; k < eI_table.NeighborCounts[jel]; ++k)
+        {
+          const int iat = ids[k];
+          if (eI_table.NeighborDistances[jel][k] < Ion_cutoff[iat])
+            add_elec_inside(jg,
+                            iat,
+                            jel,
+                            eI_table.NeighborDistances[jel][k],
+                            posT(eI_table.NeighborDisplacements[jel][k]));
+        }
       }
+  }
 
+  /** set the capacities of the lists from the density of the electrons
+   * @param P quantum particleset
+   * @param rmax largest cutoff
+   *
+   * A list has room for twice the mean number of the electrons of its group
+   * within rmax. The walker buffers have room for twice the capacities of all
+   * the lists, as the electrons gather near the ions.
+   */
+  void init_lists(const ParticleSet& P, valT rmax)
+  {
+    const valT volume = P.Lattice.Volume;
+    const valT sphere = valT(4.0 * M_PI / 3.0) * rmax * rmax * rmax;
+    elecs_inside_room = 0;
     for (int jg = 0; jg < eGroups; ++jg)
-      for (int jel = P.first(jg); jel < P.last(jg); jel++)
-        for (int iat = 0; iat < Nion; ++iat)
-          if (eI_table.Distances[jel][iat] < Ion_cutoff[iat])
+    {
+      const int n = P.last(jg) - P.first(jg);
+      int nmax    = n;
+      if (volume > valT(0) && sphere < volume)
+        nmax = std::min(n, static_cast<int>(std::ceil(valT(2) * n * sphere / volume)) + 1);
+      group_capacity[jg] = nmax;
+      elecs_inside_room += 2 * Nion * nmax;
+    }
+    resize_lists();
+  }
+
+  /// lay out the lists with the capacities of group_capacity, keeping their entries
+  void resize_lists()
+  {
+    const std::vector<int> old_offset(group_offset);
+    const int old_stride = elecs_stride;
+    elecs_stride         = 0;
+    for (int jg = 0; jg < eGroups; ++jg)
+    {
+      group_offset[jg] = elecs_stride;
+      elecs_stride += getAlignedSize<valT>(group_capacity[jg]);
+    }
+
+    aligned_vector<int> new_elecs(Nion * elecs_stride);
+    aligned_vector<valT> new_dist(Nion * elecs_stride);
+    gContainer_type new_displ;
+    new_displ.resize(Nion * elecs_stride);
+    if (old_stride > 0)
+      for (int iat = 0; iat < Nion; ++iat)
+        for (int jg = 0; jg < eGroups; ++jg)
+        {
+          const int from = iat * old_stride + old_offset[jg];
+          const int to   = list_offset(jg, iat);
+          for (int s = 0; s < elecs_inside_num(jg, iat); ++s)
           {
-            elecs_inside(jg, iat).push_back(jel);
-            elecs_inside_dist(jg, iat).push_back(eI_table.Distances[jel][iat]);
-            elecs_inside_displ(jg, iat).push_back(eI_table.Displacements[jel][iat]);
+            new_elecs[to + s] = elecs_inside[from + s];
+            new_dist[to + s]  = elecs_inside_dist[from + s];
+            new_displ(to + s) = elecs_inside_displ[from + s];
           }
+        }
+    elecs_inside.swap(new_elecs);
+    elecs_inside_dist.swap(new_dist);
+    elecs_inside_displ = new_displ;
+  }
+
+  /// offset of the list of the jg-th electron group around the iat-th ion
+  inline int list_offset(int jg, int iat) const { return iat * elecs_stride + group_offset[jg]; }
+
+  /// append jel to the list of its group jg around iat, doubling the capacity of a full list
+  inline void add_elec_inside(int jg, int iat, int jel, valT r, const posT& dr)
+  {
+    if (elecs_inside_num(jg, iat) == group_capacity[jg])
+    {
+      group_capacity[jg] *= 2;
+      resize_lists();
+    }
+    const int slot              = elecs_inside_num(jg, iat)++;
+    const int i                 = list_offset(jg, iat) + slot;
+    elecs_inside[i]             = jel;
+    elecs_inside_dist[i]        = r;
+    elecs_inside_displ(i)       = dr;
+    elecs_inside_slot(iat, jel) = slot;
+  }
+
+  /// remove jel from the list of its group jg around iat, filling the hole with the last entry
+  inline void remove_elec_inside(int jg, int iat, int jel)
+  {
+    const int offset = list_offset(jg, iat);
+    const int slot   = elecs_inside_slot(iat, jel);
+    const int last   = --elecs_inside_num(jg, iat);
+    if (slot != last)
+    {
+      const int kel                     = elecs_inside[offset + last];
+      elecs_inside[offset + slot]       = kel;
+      elecs_inside_dist[offset + slot]  = elecs_inside_dist[offset + last];
+      elecs_inside_displ(offset + slot) = elecs_inside_displ[offset + last];
+      elecs_inside_slot(iat, kel)       = slot;
+    }
+    elecs_inside_slot(iat, jel) = -1;
   }
 
   RealType evaluateLog(ParticleSet& P,
@@ -256,7 +439,13 @@ public:
 
     const DistanceTableData& eI_table = (*P.DistTables[myTableID]);
     const DistanceTableData& ee_table = (*P.DistTables[0]);
-    cur_Uat = computeU(P, iat, P.GroupID[iat], eI_table.Temp_r.data(), ee_table.Temp_r.data());
+    cur_Uat = computeU(P,
+                       iat,
+                       P.GroupID[iat],
+                       eI_table.Temp_nn_count,
+                       eI_table.Temp_nn_ids.data(),
+                       eI_table.Temp_nn_r.data(),
+                       ee_table.Temp_r.data());
     DiffVal = Uat[iat] - cur_Uat;
     return std::exp(DiffVal);
   }
@@ -271,8 +460,10 @@ public:
     const DistanceTableData& ee_table = (*P.DistTables[0]);
     computeU3(P,
               iat,
-              eI_table.Temp_r.data(),
-              eI_table.Temp_dr,
+              eI_table.Temp_nn_count,
+              eI_table.Temp_nn_ids.data(),
+              eI_table.Temp_nn_r.data(),
+              eI_table.Temp_nn_dr,
               ee_table.Temp_r.data(),
               ee_table.Temp_dr,
               cur_Uat,
@@ -293,8 +484,10 @@ public:
     // get the old value, grad, lapl
     computeU3(P,
               iat,
-              eI_table.Distances[iat],
-              eI_table.Displacements[iat],
+              eI_table.NeighborCounts[iat],
+              eI_table.NeighborIDs[iat],
+              eI_table.NeighborDistances[iat],
+              eI_table.NeighborDisplacements[iat],
               ee_table.Distances[iat],
               ee_table.Displacements[iat],
               Uat[iat],
@@ -307,8 +500,10 @@ public:
     { // ratio-only during the move; need to compute derivatives
       computeU3(P,
                 iat,
-                eI_table.Temp_r.data(),
-                eI_table.Temp_dr,
+                eI_table.Temp_nn_count,
+                eI_table.Temp_nn_ids.data(),
+                eI_table.Temp_nn_r.data(),
+                eI_table.Temp_nn_dr,
                 ee_table.Temp_r.data(),
                 ee_table.Temp_dr,
                 cur_Uat,
@@ -318,6 +513,71 @@ public:
                 newdUk,
                 newd2Uk);
     }
+    updateAccepted(P, iat);
+  }
+
+  /** crowd version of ratioGrad
+   *
+   * The functors of this are used for the whole crowd, which must share them.
+   */
+  void multi_ratioGrad(const std::vector<WaveFunctionComponent*>& WFC_list,
+                       const std::vector<ParticleSet*>& P_list,
+                       int iat,
+                       std::vector<ValueType>& ratios,
+                       std::vector<PosType>& grad_new,
+                       bool serial = false)
+  {
+    mw_computeU3(WFC_list, P_list, iat, true, serial);
+    crowd_for(serial, WFC_list.size(), [&](int iw) {
+      ThreeBodyJastrow& J3(static_cast<ThreeBodyJastrow&>(*WFC_list[iw]));
+      J3.UpdateMode = ORB_PBYP_PARTIAL;
+      J3.DiffVal    = J3.Uat[iat] - J3.cur_Uat;
+      grad_new[iw] += J3.cur_dUat;
+      ratios[iw] = std::exp(J3.DiffVal);
+    });
+  }
+
+  /** crowd version of acceptMove
+   *
+   * The old rows of the accepted walkers are computed together, as well as
+   * the new ones of the walkers moved by ratio only.
+   */
+  void multi_acceptrestoreMove(const std::vector<WaveFunctionComponent*>& WFC_list,
+                               const std::vector<ParticleSet*>& P_list,
+                               const std::vector<bool>& isAccepted,
+                               int iat,
+                               bool serial = false)
+  {
+    mw_acc_list.clear();
+    mw_acc_P_list.clear();
+    mw_ratio_list.clear();
+    mw_ratio_P_list.clear();
+    for (int iw = 0; iw < WFC_list.size(); iw++)
+      if (isAccepted[iw])
+      {
+        mw_acc_list.push_back(WFC_list[iw]);
+        mw_acc_P_list.push_back(P_list[iw]);
+        if (WFC_list[iw]->UpdateMode == ORB_PBYP_RATIO)
+        {
+          mw_ratio_list.push_back(WFC_list[iw]);
+          mw_ratio_P_list.push_back(P_list[iw]);
+        }
+      }
+    mw_computeU3(mw_acc_list, mw_acc_P_list, iat, false, serial);
+    mw_computeU3(mw_ratio_list, mw_ratio_P_list, iat, true, serial);
+    crowd_for(serial, mw_acc_list.size(), [&](int ia) {
+      static_cast<ThreeBodyJastrow&>(*mw_acc_list[ia]).updateAccepted(*mw_acc_P_list[ia], iat);
+    });
+  }
+
+  /** update the sums and the compact lists for the accepted move of iat
+   *
+   * The old row of iat is in oldUk, olddUk and oldd2Uk, the new one in
+   * newUk, newdUk, newd2Uk and the cur_ values.
+   */
+  void updateAccepted(ParticleSet& P, int iat)
+  {
+    const DistanceTableData& eI_table = (*P.DistTables[myTableID]);
 
     for (int jel = 0; jel < Nelec; jel++)
     {
@@ -339,41 +599,35 @@ public:
     d2Uat[iat] = cur_d2Uat;
 
     const int ig = P.GroupID[iat];
-    // update compact list elecs_inside
-    for (int jat = 0; jat < Nion; jat++)
+    // update compact list elecs_inside, visiting the ions near the old or the new position
+    const int* restrict old_ids = eI_table.NeighborIDs[iat];
+    const int old_nn            = eI_table.NeighborCounts[iat];
+    const int new_nn            = eI_table.Temp_nn_count;
+    for (int kold = 0, knew = 0; kold < old_nn || knew < new_nn;)
     {
-      bool inside = eI_table.Temp_r[jat] < Ion_cutoff[jat];
-      auto iter   = find(elecs_inside(ig, jat).begin(), elecs_inside(ig, jat).end(), iat);
-      auto iter_dist =
-          elecs_inside_dist(ig, jat).begin() + std::distance(elecs_inside(ig, jat).begin(), iter);
-      auto iter_displ =
-          elecs_inside_displ(ig, jat).begin() + std::distance(elecs_inside(ig, jat).begin(), iter);
+      const int jold = kold < old_nn ? old_ids[kold] : Nion;
+      const int jnew = knew < new_nn ? eI_table.Temp_nn_ids[knew] : Nion;
+      const int jat  = std::min(jold, jnew);
+      if (jold == jat)
+        kold++;
+      const int k = knew;
+      if (jnew == jat)
+        knew++;
+      const bool inside = jnew == jat && eI_table.Temp_nn_r[k] < Ion_cutoff[jat];
+      const int slot    = elecs_inside_slot(jat, iat);
       if (inside)
       {
-        if (iter == elecs_inside(ig, jat).end())
-        {
-          elecs_inside(ig, jat).push_back(iat);
-          elecs_inside_dist(ig, jat).push_back(eI_table.Temp_r[jat]);
-          elecs_inside_displ(ig, jat).push_back(eI_table.Temp_dr[jat]);
-        }
+        if (slot < 0)
+          add_elec_inside(ig, jat, iat, eI_table.Temp_nn_r[k], posT(eI_table.Temp_nn_dr[k]));
         else
         {
-          *iter_dist  = eI_table.Temp_r[jat];
-          *iter_displ = eI_table.Temp_dr[jat];
-        }
-      }
-      else
-      {
-        if (iter != elecs_inside(ig, jat).end())
-        {
-          *iter = elecs_inside(ig, jat).back();
-          elecs_inside(ig, jat).pop_back();
-          *iter_dist = elecs_inside_dist(ig, jat).back();
-          elecs_inside_dist(ig, jat).pop_back();
-          *iter_displ = elecs_inside_displ(ig, jat).back();
-          elecs_inside_displ(ig, jat).pop_back();
+          const int i           = list_offset(ig, jat) + slot;
+          elecs_inside_dist[i]  = eI_table.Temp_nn_r[k];
+          elecs_inside_displ(i) = posT(eI_table.Temp_nn_dr[k]);
         }
       }
+      else if (slot >= 0)
+        remove_elec_inside(ig, jat, iat);
     }
   }
 
@@ -384,12 +638,21 @@ public:
 
     build_compact_list(P);
 
+    const int nt = getWalkerTeamSize(P.WalkerTeamSize, Nelec);
+    if (nt > 1)
+    {
+      recomputeTeam(P, nt);
+      return;
+    }
+
     for (int jel = 0; jel < Nelec; ++jel)
     {
       computeU3(P,
                 jel,
-                eI_table.Distances[jel],
-                eI_table.Displacements[jel],
+                eI_table.NeighborCounts[jel],
+                eI_table.NeighborIDs[jel],
+                eI_table.NeighborDistances[jel],
+                eI_table.NeighborDisplacements[jel],
                 ee_table.Distances[jel],
                 ee_table.Displacements[jel],
                 Uat[jel],
@@ -415,54 +678,159 @@ public:
       }
     }
   }
-
-  inline valT
-      computeU(const ParticleSet& P, int jel, int jg, const RealType* distjI, const RealType* distjk)
+  /** recompute by a walker team of nt members, after build_compact_list
+   *
+   * The rows are dealt round-robin in blocks of WalkerTeamGrain. Each member
+   * owns a scratch and accumulates the upper-triangle contributions of its
+   * rows in its slice of team_sums, which are reduced at the end.
+   */
+  inline void recomputeTeam(ParticleSet& P, int nt)
   {
     const DistanceTableData& eI_table = (*P.DistTables[myTableID]);
+    const DistanceTableData& ee_table = (*P.DistTables[0]);
+    constexpr valT czero(0);
+    const size_t nrows = OHMMS_DIM + 2;
+    team_sums.resize(nt * nrows * Nelec_padded);
+#pragma omp parallel num_threads(nt)
+    {
+      const int ip = omp_get_thread_num();
+      RowScratch ws;
+      ws.resize(Nion, Nbuffer);
+      Vector<valT> Uk(Nelec), d2Uk(Nelec);
+      gContainer_type dUk(Nelec);
+      valT* restrict sum_u = team_sums.data() + ip * nrows * Nelec_padded;
+      valT* restrict sum_l = sum_u + Nelec_padded;
+      std::fill_n(sum_u, nrows * Nelec_padded, czero);
 
-    ions_nearby.clear();
-    for (int iat = 0; iat < Nion; ++iat)
-      if (distjI[iat] < Ion_cutoff[iat])
-        ions_nearby.push_back(iat);
+#pragma omp for schedule(static, WalkerTeamGrain)
+      for (int jel = 0; jel < Nelec; ++jel)
+      {
+        posT dUj;
+        collect_ions_nearby(ws,
+                            eI_table.NeighborCounts[jel],
+                            eI_table.NeighborIDs[jel],
+                            eI_table.NeighborDistances[jel]);
+        computeU3_nearby(P,
+                         ws,
+                         jel,
+                         eI_table.NeighborIDs[jel],
+                         eI_table.NeighborDistances[jel],
+                         eI_table.NeighborDisplacements[jel],
+                         ee_table.Distances[jel],
+                         ee_table.Displacements[jel],
+                         Uat[jel],
+                         dUj,
+                         d2Uat[jel],
+                         Uk,
+                         dUk,
+                         d2Uk,
+                         true);
+        dUat(jel) = dUj;
+        for (int kel = 0; kel < jel; kel++)
+        {
+          sum_u[kel] += Uk[kel];
+          sum_l[kel] += d2Uk[kel];
+        }
+        for (int idim = 0; idim < OHMMS_DIM; ++idim)
+        {
+          valT* restrict sum_g       = sum_u + (idim + 2) * Nelec_padded;
+          const valT* restrict new_g = dUk.data(idim);
+          for (int kel = 0; kel < jel; kel++)
+            sum_g[kel] += new_g[kel];
+        }
+      }
+
+      // add the partial sums of all the members
+      int first, last;
+      getWalkerTeamRange(Nelec, ip, nt, first, last);
+      for (int jp = 0; jp < nt; ++jp)
+      {
+        const valT* restrict sums = team_sums.data() + jp * nrows * Nelec_padded;
+        for (int kel = first; kel < last; kel++)
+        {
+          Uat[kel] += sums[kel];
+          d2Uat[kel] += sums[Nelec_padded + kel];
+        }
+        for (int idim = 0; idim < OHMMS_DIM; ++idim)
+        {
+          const valT* restrict sum_g = sums + (idim + 2) * Nelec_padded;
+          valT* restrict save_g      = dUat.data(idim);
+          for (int kel = first; kel < last; kel++)
+            save_g[kel] += sum_g[kel];
+        }
+      }
+    }
+  }
+
+
+  /** collect the neighbors of the jel-th electron within Ion_cutoff
+   * @param nn number of the e-I neighbors
+   * @param idsjI ion indices of the e-I neighbors, sorted
+   * @param distjI distances of the e-I neighbors
+   *
+   * ions_nearby of the scratch holds the positions in the neighbor list.
+   */
+  inline void collect_ions_nearby(RowScratch& ws, int nn, const int* idsjI, const distT* distjI)
+  {
+    ws.ions_nearby.clear();
+    for (int k = 0; k < nn; ++k)
+      if (distjI[k] < Ion_cutoff[idsjI[k]])
+        ws.ions_nearby.push_back(k);
+  }
+
+  inline valT computeU(const ParticleSet& P,
+                       int jel,
+                       int jg,
+                       int nn,
+                       const int* idsjI,
+                       const distT* distjI,
+                       const distT* distjk)
+  {
+    RowScratch& ws = Scratch;
+    collect_ions_nearby(ws, nn, idsjI, distjI);
 
     valT Uj = valT(0);
     for (int kg = 0; kg < eGroups; ++kg)
     {
       int kel_counter = 0;
-      for (int iind = 0; iind < ions_nearby.size(); ++iind)
+      for (int iind = 0; iind < ws.ions_nearby.size(); ++iind)
       {
-        const int iat   = ions_nearby[iind];
-        const int ig    = Ions.GroupID[iat];
-        const valT r_jI = distjI[iat];
-        for (int kind = 0; kind < elecs_inside(kg, iat).size(); kind++)
+        const int k                 = ws.ions_nearby[iind];
+        const int iat               = idsjI[k];
+        const int ig                = Ions.GroupID[iat];
+        const valT r_jI             = distjI[k];
+        const int offset            = list_offset(kg, iat);
+        const int* restrict kels    = elecs_inside.data() + offset;
+        const valT* restrict distkI = elecs_inside_dist.data() + offset;
+        for (int kind = 0; kind < elecs_inside_num(kg, iat); kind++)
         {
-          const int kel = elecs_inside(kg, iat)[kind];
+          const int kel = kels[kind];
           if (kel != jel)
           {
-            DistkI_Compressed[kel_counter] = elecs_inside_dist(kg, iat)[kind];
-            Distjk_Compressed[kel_counter] = distjk[kel];
-            DistjI_Compressed[kel_counter] = r_jI;
+            ws.DistkI_Compressed[kel_counter] = distkI[kind];
+            ws.Distjk_Compressed[kel_counter] = distjk[kel];
+            ws.DistjI_Compressed[kel_counter] = r_jI;
             kel_counter++;
             if (kel_counter == Nbuffer)
             {
               const FT& feeI(*F(ig, jg, kg));
               Uj += feeI.evaluateV(kel_counter,
-                                   Distjk_Compressed.data(),
-                                   DistjI_Compressed.data(),
-                                   DistkI_Compressed.data());
+                                   ws.Distjk_Compressed.data(),
+                                   ws.DistjI_Compressed.data(),
+                                   ws.DistkI_Compressed.data());
               kel_counter = 0;
             }
           }
         }
-        if ((iind + 1 == ions_nearby.size() || ig != Ions.GroupID[ions_nearby[iind + 1]]) &&
+        if ((iind + 1 == ws.ions_nearby.size() ||
+             ig != Ions.GroupID[idsjI[ws.ions_nearby[iind + 1]]]) &&
             kel_counter > 0)
         {
           const FT& feeI(*F(ig, jg, kg));
           Uj += feeI.evaluateV(kel_counter,
-                               Distjk_Compressed.data(),
-                               DistjI_Compressed.data(),
-                               DistkI_Compressed.data());
+                               ws.Distjk_Compressed.data(),
+                               ws.DistjI_Compressed.data(),
+                               ws.DistkI_Compressed.data());
           kel_counter = 0;
         }
       }
@@ -471,6 +839,7 @@ public:
   }
 
   inline void computeU3_engine(const ParticleSet& P,
+                               RowScratch& ws,
                                const FT& feeI,
                                int kel_counter,
                                valT& Uj,
@@ -487,20 +856,20 @@ public:
     constexpr valT ctwo(2);
     constexpr valT lapfac = OHMMS_DIM - cone;
 
-    valT* restrict val     = mVGL.data(0);
-    valT* restrict gradF0  = mVGL.data(1);
-    valT* restrict gradF1  = mVGL.data(2);
-    valT* restrict gradF2  = mVGL.data(3);
-    valT* restrict hessF00 = mVGL.data(4);
-    valT* restrict hessF11 = mVGL.data(5);
-    valT* restrict hessF22 = mVGL.data(6);
-    valT* restrict hessF01 = mVGL.data(7);
-    valT* restrict hessF02 = mVGL.data(8);
+    valT* restrict val     = ws.mVGL.data(0);
+    valT* restrict gradF0  = ws.mVGL.data(1);
+    valT* restrict gradF1  = ws.mVGL.data(2);
+    valT* restrict gradF2  = ws.mVGL.data(3);
+    valT* restrict hessF00 = ws.mVGL.data(4);
+    valT* restrict hessF11 = ws.mVGL.data(5);
+    valT* restrict hessF22 = ws.mVGL.data(6);
+    valT* restrict hessF01 = ws.mVGL.data(7);
+    valT* restrict hessF02 = ws.mVGL.data(8);
 
     feeI.evaluateVGL(kel_counter,
-                     Distjk_Compressed.data(),
-                     DistjI_Compressed.data(),
-                     DistkI_Compressed.data(),
+                     ws.Distjk_Compressed.data(),
+                     ws.DistjI_Compressed.data(),
+                     ws.DistkI_Compressed.data(),
                      val,
                      gradF0,
                      gradF1,
@@ -521,9 +890,9 @@ public:
     std::fill_n(hessF11, kel_counter, czero);
     for (int idim = 0; idim < OHMMS_DIM; ++idim)
     {
-      valT* restrict jk = Disp_jk_Compressed.data(idim);
-      valT* restrict jI = Disp_jI_Compressed.data(idim);
-      valT* restrict kI = Disp_kI_Compressed.data(idim);
+      valT* restrict jk = ws.Disp_jk_Compressed.data(idim);
+      valT* restrict jI = ws.Disp_jI_Compressed.data(idim);
+      valT* restrict kI = ws.Disp_kI_Compressed.data(idim);
       valT dUj_x(0);
       for (int kel_index = 0; kel_index < kel_counter; kel_index++)
       {
@@ -538,7 +907,7 @@ public:
       }
       dUj[idim] += dUj_x;
 
-      valT* restrict jk0 = Disp_jk_Compressed.data(0);
+      valT* restrict jk0 = ws.Disp_jk_Compressed.data(0);
       if (idim > 0)
       {
         for (int kel_index = 0; kel_index < kel_counter; kel_index++)
@@ -547,10 +916,10 @@ public:
 
       valT* restrict dUk_x = dUk.data(idim);
       for (int kel_index = 0; kel_index < kel_counter; kel_index++)
-        dUk_x[DistIndice_k[kel_index]] += kI[kel_index];
+        dUk_x[ws.DistIndice_k[kel_index]] += kI[kel_index];
     }
     valT sum(0);
-    valT* restrict jk0 = Disp_jk_Compressed.data(0);
+    valT* restrict jk0 = ws.Disp_jk_Compressed.data(0);
     for (int kel_index = 0; kel_index < kel_counter; kel_index++)
       sum += hessF01[kel_index] * jk0[kel_index];
     d2Uj -= ctwo * sum;
@@ -562,7 +931,7 @@ public:
 
     for (int kel_index = 0; kel_index < kel_counter; kel_index++)
     {
-      const int kel = DistIndice_k[kel_index];
+      const int kel = ws.DistIndice_k[kel_index];
       Uk[kel] += val[kel_index];
       d2Uk[kel] -= hessF00[kel_index];
     }
@@ -570,9 +939,11 @@ public:
 
   inline void computeU3(const ParticleSet& P,
                         int jel,
-                        const RealType* distjI,
+                        int nn,
+                        const int* idsjI,
+                        const distT* distjI,
                         const RowContainer& displjI,
-                        const RealType* distjk,
+                        const distT* distjk,
                         const RowContainer& displjk,
                         valT& Uj,
                         posT& dUj,
@@ -581,6 +952,42 @@ public:
                         gContainer_type& dUk,
                         Vector<valT>& d2Uk,
                         bool triangle = false)
+  {
+    collect_ions_nearby(Scratch, nn, idsjI, distjI);
+    computeU3_nearby(P,
+                     Scratch,
+                     jel,
+                     idsjI,
+                     distjI,
+                     displjI,
+                     distjk,
+                     displjk,
+                     Uj,
+                     dUj,
+                     d2Uj,
+                     Uk,
+                     dUk,
+                     d2Uk,
+                     triangle);
+  }
+
+  /** computeU3 over the ions already collected in ions_nearby
+   */
+  inline void computeU3_nearby(const ParticleSet& P,
+                               RowScratch& ws,
+                               int jel,
+                               const int* idsjI,
+                               const distT* distjI,
+                               const RowContainer& displjI,
+                               const distT* distjk,
+                               const RowContainer& displjk,
+                               valT& Uj,
+                               posT& dUj,
+                               valT& d2Uj,
+                               Vector<valT>& Uk,
+                               gContainer_type& dUk,
+                               Vector<valT>& d2Uk,
+                               bool triangle = false)
   {
     constexpr valT czero(0);
 
@@ -596,52 +1003,315 @@ public:
     for (int idim = 0; idim < OHMMS_DIM; ++idim)
       std::fill_n(dUk.data(idim), kelmax, czero);
 
-    ions_nearby.clear();
-    for (int iat = 0; iat < Nion; ++iat)
-      if (distjI[iat] < Ion_cutoff[iat])
-        ions_nearby.push_back(iat);
-
     for (int kg = 0; kg < eGroups; ++kg)
     {
       int kel_counter = 0;
-      for (int iind = 0; iind < ions_nearby.size(); ++iind)
+      for (int iind = 0; iind < ws.ions_nearby.size(); ++iind)
       {
-        const int iat      = ions_nearby[iind];
-        const int ig       = Ions.GroupID[iat];
-        const valT r_jI    = distjI[iat];
-        const posT disp_Ij = displjI[iat];
-        for (int kind = 0; kind < elecs_inside(kg, iat).size(); kind++)
+        const int k                 = ws.ions_nearby[iind];
+        const int iat               = idsjI[k];
+        const int ig                = Ions.GroupID[iat];
+        const valT r_jI             = distjI[k];
+        const posT disp_Ij          = displjI[k];
+        const int offset            = list_offset(kg, iat);
+        const int* restrict kels    = elecs_inside.data() + offset;
+        const valT* restrict distkI = elecs_inside_dist.data() + offset;
+        for (int kind = 0; kind < elecs_inside_num(kg, iat); kind++)
         {
-          const int kel = elecs_inside(kg, iat)[kind];
+          const int kel = kels[kind];
           if (kel < kelmax && kel != jel)
           {
-            DistkI_Compressed[kel_counter]  = elecs_inside_dist(kg, iat)[kind];
-            DistjI_Compressed[kel_counter]  = r_jI;
-            Distjk_Compressed[kel_counter]  = distjk[kel];
-            Disp_kI_Compressed(kel_counter) = elecs_inside_displ(kg, iat)[kind];
-            Disp_jI_Compressed(kel_counter) = disp_Ij;
-            Disp_jk_Compressed(kel_counter) = displjk[kel];
-            DistIndice_k[kel_counter]       = kel;
+            ws.DistkI_Compressed[kel_counter]  = distkI[kind];
+            ws.DistjI_Compressed[kel_counter]  = r_jI;
+            ws.Distjk_Compressed[kel_counter]  = distjk[kel];
+            ws.Disp_kI_Compressed(kel_counter) = elecs_inside_displ[offset + kind];
+            ws.Disp_jI_Compressed(kel_counter) = disp_Ij;
+            ws.Disp_jk_Compressed(kel_counter) = displjk[kel];
+            ws.DistIndice_k[kel_counter]       = kel;
             kel_counter++;
             if (kel_counter == Nbuffer)
             {
               const FT& feeI(*F(ig, jg, kg));
-              computeU3_engine(P, feeI, kel_counter, Uj, dUj, d2Uj, Uk, dUk, d2Uk);
+              computeU3_engine(P, ws, feeI, kel_counter, Uj, dUj, d2Uj, Uk, dUk, d2Uk);
               kel_counter = 0;
             }
           }
         }
-        if ((iind + 1 == ions_nearby.size() || ig != Ions.GroupID[ions_nearby[iind + 1]]) &&
+        if ((iind + 1 == ws.ions_nearby.size() ||
+             ig != Ions.GroupID[idsjI[ws.ions_nearby[iind + 1]]]) &&
             kel_counter > 0)
         {
           const FT& feeI(*F(ig, jg, kg));
-          computeU3_engine(P, feeI, kel_counter, Uj, dUj, d2Uj, Uk, dUk, d2Uk);
+          computeU3_engine(P, ws, feeI, kel_counter, Uj, dUj, d2Uj, Uk, dUk, d2Uk);
           kel_counter = 0;
         }
       }
     }
   }
 
+  /** compute the rows of jel of a crowd of walkers over the packed triplets
+   * @param WFC_list ThreeBodyJastrow of the walkers
+   * @param P_list electrons of the walkers
+   * @param jel index of the electron
+   * @param proposed true for the proposed position of jel, false for the current one
+   * @param serial if true, the calling thread evaluates the whole crowd
+   *
+   * The proposed rows go to cur_Uat, cur_dUat, cur_d2Uat and newUk, newdUk,
+   * newd2Uk, the current ones to Uat, dUat_temp, d2Uat and oldUk, olddUk,
+   * oldd2Uk of each walker. The triplets are gathered by walker, evaluated in
+   * chunks of equal size over the segments, so the threads get the same
+   * number of triplets whatever their walkers, and added up by walker.
+   * The functors of this are used for the whole crowd.
+   */
+  void mw_computeU3(const std::vector<WaveFunctionComponent*>& WFC_list,
+                    const std::vector<ParticleSet*>& P_list,
+                    int jel,
+                    bool proposed,
+                    bool serial)
+  {
+    const int nw = WFC_list.size();
+    if (nw == 0)
+      return;
+
+    constexpr valT czero(0);
+    constexpr valT ctwo(2);
+    constexpr valT lapfac = OHMMS_DIM - valT(1);
+
+    const int nseg = iGroups * eGroups;
+    const int jg   = P_list[0]->GroupID[jel];
+
+    // count the triplets of each walker in each segment
+    mw_count.assign(nseg * nw, 0);
+    crowd_for(serial, nw, [&](int iw) {
+      const ThreeBodyJastrow& J3(static_cast<const ThreeBodyJastrow&>(*WFC_list[iw]));
+      const DistanceTableData& eI_table = (*P_list[iw]->DistTables[myTableID]);
+      const int nn            = proposed ? eI_table.Temp_nn_count : eI_table.NeighborCounts[jel];
+      const int* restrict ids = proposed ? eI_table.Temp_nn_ids.data() : eI_table.NeighborIDs[jel];
+      const distT* restrict r =
+          proposed ? eI_table.Temp_nn_r.data() : eI_table.NeighborDistances[jel];
+      for (int k = 0; k < nn; ++k)
+      {
+        const int iat = ids[k];
+        if (r[k] < J3.Ion_cutoff[iat])
+          for (int kg = 0; kg < eGroups; ++kg)
+          {
+            // jel itself is not a partner
+            const int self = kg == jg && J3.elecs_inside_slot(iat, jel) >= 0;
+            mw_count[(Ions.GroupID[iat] * eGroups + kg) * nw + iw] +=
+                J3.elecs_inside_num(kg, iat) - self;
+          }
+      }
+    });
+
+    // place the segments
+    mw_begin.resize(nseg * nw);
+    mw_end.resize(nseg);
+    mw_next.resize(nseg * nw);
+    size_t ntot = 0;
+    for (int iseg = 0; iseg < nseg; ++iseg)
+    {
+      ntot = getAlignedSize<valT>(ntot);
+      for (int iw = 0; iw < nw; iw++)
+      {
+        mw_begin[iseg * nw + iw] = ntot;
+        ntot += mw_count[iseg * nw + iw];
+      }
+      mw_end[iseg] = ntot;
+    }
+    if (ntot > mw_capacity)
+    {
+      mw_capacity = getAlignedSize<valT>(ntot);
+      mw_Distjk.resize(mw_capacity);
+      mw_DistjI.resize(mw_capacity);
+      mw_DistkI.resize(mw_capacity);
+      mw_Disp_jk.resize(mw_capacity);
+      mw_Disp_jI.resize(mw_capacity);
+      mw_Disp_kI.resize(mw_capacity);
+      mw_kel.resize(mw_capacity);
+      mw_VGL.resize(mw_capacity);
+    }
+
+    // gather the triplets of each walker
+    crowd_for(serial, nw, [&](int iw) {
+      const ThreeBodyJastrow& J3(static_cast<const ThreeBodyJastrow&>(*WFC_list[iw]));
+      const DistanceTableData& eI_table = (*P_list[iw]->DistTables[myTableID]);
+      const DistanceTableData& ee_table = (*P_list[iw]->DistTables[0]);
+      const int nn            = proposed ? eI_table.Temp_nn_count : eI_table.NeighborCounts[jel];
+      const int* restrict ids = proposed ? eI_table.Temp_nn_ids.data() : eI_table.NeighborIDs[jel];
+      const distT* restrict r =
+          proposed ? eI_table.Temp_nn_r.data() : eI_table.NeighborDistances[jel];
+      const RowContainer& displjI =
+          proposed ? eI_table.Temp_nn_dr : eI_table.NeighborDisplacements[jel];
+      const distT* restrict distjk = proposed ? ee_table.Temp_r.data() : ee_table.Distances[jel];
+      const RowContainer& displjk  = proposed ? ee_table.Temp_dr : ee_table.Displacements[jel];
+
+      int* restrict next = mw_next.data() + iw * nseg;
+      for (int iseg = 0; iseg < nseg; ++iseg)
+        next[iseg] = mw_begin[iseg * nw + iw];
+      for (int k = 0; k < nn; ++k)
+      {
+        const int iat = ids[k];
+        if (r[k] >= J3.Ion_cutoff[iat])
+          continue;
+        for (int kg = 0; kg < eGroups; ++kg)
+        {
+          const int iseg              = Ions.GroupID[iat] * eGroups + kg;
+          const int offset            = J3.list_offset(kg, iat);
+          const int* restrict kels    = J3.elecs_inside.data() + offset;
+          const valT* restrict distkI = J3.elecs_inside_dist.data() + offset;
+          for (int kind = 0; kind < J3.elecs_inside_num(kg, iat); kind++)
+          {
+            const int kel = kels[kind];
+            if (kel == jel)
+              continue;
+            const int i  = next[iseg]++;
+            mw_DistkI[i] = distkI[kind];
+            mw_DistjI[i] = r[k];
+            mw_Distjk[i] = distjk[kel];
+            for (int idim = 0; idim < OHMMS_DIM; ++idim)
+            {
+              mw_Disp_kI.data(idim)[i] = J3.elecs_inside_displ.data(idim)[offset + kind];
+              mw_Disp_jI.data(idim)[i] = displjI.data(idim)[k];
+              mw_Disp_jk.data(idim)[i] = displjk.data(idim)[kel];
+            }
+            mw_kel[i] = kel;
+          }
+        }
+      }
+    });
+
+    // chunks of the segments, aligned and of the same size except for the last of a segment
+    const int chunk = 32 * getAlignment<valT>();
+    std::vector<int>& chunk_seg   = mw_chunk_seg;
+    std::vector<int>& chunk_first = mw_chunk_first;
+    chunk_seg.clear();
+    chunk_first.clear();
+    for (int iseg = 0; iseg < nseg; ++iseg)
+      for (int first = mw_begin[iseg * nw]; first < mw_end[iseg]; first += chunk)
+      {
+        chunk_seg.push_back(iseg);
+        chunk_first.push_back(first);
+      }
+
+    crowd_for(serial, chunk_seg.size(), [&](int ic) {
+      const int iseg  = chunk_seg[ic];
+      const int first = chunk_first[ic];
+      const int n     = std::min(chunk, mw_end[iseg] - first);
+      const FT& feeI(*F(iseg / eGroups, jg, iseg % eGroups));
+
+      valT* restrict val     = mw_VGL.data(0) + first;
+      valT* restrict gradF0  = mw_VGL.data(1) + first;
+      valT* restrict gradF1  = mw_VGL.data(2) + first;
+      valT* restrict gradF2  = mw_VGL.data(3) + first;
+      valT* restrict hessF00 = mw_VGL.data(4) + first;
+      valT* restrict hessF11 = mw_VGL.data(5) + first;
+      valT* restrict hessF22 = mw_VGL.data(6) + first;
+      valT* restrict hessF01 = mw_VGL.data(7) + first;
+      valT* restrict hessF02 = mw_VGL.data(8) + first;
+
+      feeI.evaluateVGL(n,
+                       mw_Distjk.data() + first,
+                       mw_DistjI.data() + first,
+                       mw_DistkI.data() + first,
+                       val,
+                       gradF0,
+                       gradF1,
+                       gradF2,
+                       hessF00,
+                       hessF11,
+                       hessF22,
+                       hessF01,
+                       hessF02);
+
+      // the terms of each triplet, as the single-walker engine
+      // 1-3: dUj, 4: d2Uj, 5-7: dUk, 8: d2Uk
+      for (int i = 0; i < n; i++)
+      {
+        const valT g0  = gradF0[i];
+        const valT g1  = gradF1[i];
+        const valT g2  = gradF2[i];
+        const valT h00 = hessF00[i];
+        const valT h11 = hessF11[i];
+        const valT h22 = hessF22[i];
+        const valT h01 = hessF01[i];
+        const valT h02 = hessF02[i];
+        valT jk[OHMMS_DIM], jI[OHMMS_DIM], kI[OHMMS_DIM];
+        valT jk_jI(czero), kI_jk(czero);
+        for (int idim = 0; idim < OHMMS_DIM; ++idim)
+        {
+          jk[idim] = mw_Disp_jk.data(idim)[first + i];
+          jI[idim] = mw_Disp_jI.data(idim)[first + i];
+          kI[idim] = mw_Disp_kI.data(idim)[first + i];
+          jk_jI += jk[idim] * jI[idim];
+          kI_jk += kI[idim] * jk[idim];
+        }
+        gradF0[i]  = g1 * jI[0] + g0 * jk[0];
+        gradF1[i]  = g1 * jI[1] + g0 * jk[1];
+        gradF2[i]  = g1 * jI[2] + g0 * jk[2];
+        hessF00[i] = -(h00 + h11 + lapfac * (g0 + g1)) - ctwo * h01 * jk_jI;
+        hessF11[i] = kI[0] * g2 - jk[0] * g0;
+        hessF22[i] = kI[1] * g2 - jk[1] * g0;
+        hessF01[i] = kI[2] * g2 - jk[2] * g0;
+        hessF02[i] = -(h00 + h22 + lapfac * (g0 + g2) - ctwo * h02 * kI_jk);
+      }
+    });
+
+    // add up the terms of each walker
+    crowd_for(serial, nw, [&](int iw) {
+      ThreeBodyJastrow& J3(static_cast<ThreeBodyJastrow&>(*WFC_list[iw]));
+      Vector<valT>& Uk     = proposed ? J3.newUk : J3.oldUk;
+      gContainer_type& dUk = proposed ? J3.newdUk : J3.olddUk;
+      Vector<valT>& d2Uk   = proposed ? J3.newd2Uk : J3.oldd2Uk;
+      std::fill_n(Uk.data(), Nelec, czero);
+      std::fill_n(d2Uk.data(), Nelec, czero);
+      for (int idim = 0; idim < OHMMS_DIM; ++idim)
+        std::fill_n(dUk.data(idim), Nelec, czero);
+
+      valT Uj(czero), d2Uj(czero);
+      posT dUj;
+      const valT* restrict val    = mw_VGL.data(0);
+      const valT* restrict d2j    = mw_VGL.data(4);
+      const valT* restrict d2k    = mw_VGL.data(8);
+      const int* restrict kel_ids = mw_kel.data();
+      for (int iseg = 0; iseg < nseg; ++iseg)
+      {
+        const int first = mw_begin[iseg * nw + iw];
+        const int last  = first + mw_count[iseg * nw + iw];
+        for (int i = first; i < last; i++)
+        {
+          Uj += val[i];
+          d2Uj += d2j[i];
+          Uk[kel_ids[i]] += val[i];
+          d2Uk[kel_ids[i]] += d2k[i];
+        }
+        for (int idim = 0; idim < OHMMS_DIM; ++idim)
+        {
+          const valT* restrict dj = mw_VGL.data(1 + idim);
+          const valT* restrict dk = mw_VGL.data(5 + idim);
+          valT* restrict dUk_x    = dUk.data(idim);
+          for (int i = first; i < last; i++)
+          {
+            dUj[idim] += dj[i];
+            dUk_x[kel_ids[i]] += dk[i];
+          }
+        }
+      }
+
+      if (proposed)
+      {
+        J3.cur_Uat   = Uj;
+        J3.cur_dUat  = dUj;
+        J3.cur_d2Uat = d2Uj;
+      }
+      else
+      {
+        J3.Uat[jel]   = Uj;
+        J3.dUat_temp  = dUj;
+        J3.d2Uat[jel] = d2Uj;
+      }
+    });
+  }
+
   void evaluateGL(ParticleSet& P,
                   ParticleSet::ParticleGradient_t& G,
                   ParticleSet::ParticleLaplacian_t& L,
@@ -660,6 +1330,119 @@ public:
     constexpr valT mhalf(-0.5);
     LogValue = mhalf * LogValue;
   }
+
+  /** the per-electron values, gradients and laplacians are kept with the
+   * compact lists, whose order follows the history of the moves
+   *
+   * Only the occupied entries of the lists are kept, packed in the order of
+   * the lists, in a room of elecs_inside_room entries set from the density
+   * so that the layout of the buffer stays fixed. An entry is stored as
+   * OHMMS_DIM + 2 values of the buffer. The slots are rebuilt from the lists.
+   */
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    buf.add(Uat.data(), Uat.data() + Nelec);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      buf.add(dUat.data(idim), dUat.data(idim) + Nelec);
+    buf.add(d2Uat.data(), d2Uat.data() + Nelec);
+    buf.add(LogValue);
+    buf.add(elecs_inside_num.first_address(), elecs_inside_num.last_address());
+    const int nused = putLists(buf, true);
+    for (int i = nused; i < elecs_inside_room * (OHMMS_DIM + 2); ++i)
+      buf.add(RealType(0));
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.put(Uat.data(), Uat.data() + Nelec);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      buf.put(dUat.data(idim), dUat.data(idim) + Nelec);
+    buf.put(d2Uat.data(), d2Uat.data() + Nelec);
+    buf.put(LogValue);
+    buf.put(elecs_inside_num.first_address(), elecs_inside_num.last_address());
+    const int nused = putLists(buf, false);
+    buf.rewind(buf.current() + elecs_inside_room * (OHMMS_DIM + 2) - nused, buf.current_DP());
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.get(Uat.data(), Uat.data() + Nelec);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      buf.get(dUat.data(idim), dUat.data(idim) + Nelec);
+    buf.get(d2Uat.data(), d2Uat.data() + Nelec);
+    buf.get(LogValue);
+    buf.get(elecs_inside_num.first_address(), elecs_inside_num.last_address());
+
+    // the lists of another walker may need more capacity
+    bool full = false;
+    for (int jg = 0; jg < eGroups; ++jg)
+      for (int iat = 0; iat < Nion; ++iat)
+        if (elecs_inside_num(jg, iat) > group_capacity[jg])
+        {
+          group_capacity[jg] = std::max(2 * group_capacity[jg], elecs_inside_num(jg, iat));
+          full               = true;
+        }
+    if (full)
+      resize_lists();
+
+    int nused         = 0;
+    elecs_inside_slot = -1;
+    for (int iat = 0; iat < Nion; ++iat)
+      for (int jg = 0; jg < eGroups; ++jg)
+      {
+        const int offset = list_offset(jg, iat);
+        const int num    = elecs_inside_num(jg, iat);
+        for (int slot = 0; slot < num; ++slot)
+        {
+          const int i = offset + slot;
+          RealType x;
+          buf.get(x);
+          elecs_inside[i] = static_cast<int>(x);
+          buf.get(x);
+          elecs_inside_dist[i] = x;
+          for (int idim = 0; idim < OHMMS_DIM; ++idim)
+          {
+            buf.get(x);
+            elecs_inside_displ.data(idim)[i] = x;
+          }
+          elecs_inside_slot(iat, elecs_inside[i]) = slot;
+        }
+        nused += num * (OHMMS_DIM + 2);
+      }
+    buf.rewind(buf.current() + elecs_inside_room * (OHMMS_DIM + 2) - nused, buf.current_DP());
+  }
+
+private:
+  /** add or put the occupied entries of the lists to buf
+   * @return the number of the values written
+   */
+  int putLists(BufferType& buf, bool add)
+  {
+    auto write = [&](RealType x) {
+      if (add)
+        buf.add(x);
+      else
+        buf.put(x);
+    };
+    int nused = 0;
+    for (int iat = 0; iat < Nion; ++iat)
+      for (int jg = 0; jg < eGroups; ++jg)
+      {
+        const int offset = list_offset(jg, iat);
+        const int num    = elecs_inside_num(jg, iat);
+        nused += num * (OHMMS_DIM + 2);
+        if (nused > elecs_inside_room * (OHMMS_DIM + 2))
+          APP_ABORT("ThreeBodyJastrow::putLists the lists exceed the room of the walker buffer");
+        for (int i = offset; i < offset + num; ++i)
+        {
+          write(static_cast<RealType>(elecs_inside[i]));
+          write(elecs_inside_dist[i]);
+          for (int idim = 0; idim < OHMMS_DIM; ++idim)
+            write(elecs_inside_displ.data(idim)[i]);
+        }
+      }
+    return nused;
+  }
 };
 
 } // namespace qmcplusplus
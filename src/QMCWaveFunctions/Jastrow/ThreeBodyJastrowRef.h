@@ -34,6 +34,8 @@ class ThreeBodyJastrowRef : public WaveFunctionComponent
   using valT = typename FT::real_type;
   /// element position type
   using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
   /// use the same container
   using RowContainer = DistanceTableData::RowContainer;
   /// table index for i-el, el-el is always zero
@@ -418,7 +420,7 @@ public:
   }
 
   inline valT
-      computeU(const ParticleSet& P, int jel, int jg, const RealType* distjI, const RealType* distjk)
+      computeU(const ParticleSet& P, int jel, int jg, const distT* distjI, const distT* distjk)
   {
     const DistanceTableData& eI_table = (*P.DistTables[myTableID]);
 
@@ -571,9 +573,9 @@ public:
 
   inline void computeU3(const ParticleSet& P,
                         int jel,
-                        const RealType* distjI,
+                        const distT* distjI,
                         const RowContainer& displjI,
-                        const RealType* distjk,
+                        const distT* distjk,
                         const RowContainer& displjk,
                         valT& Uj,
                         posT& dUj,
@@ -661,6 +663,37 @@ public:
     constexpr valT mhalf(-0.5);
     LogValue = mhalf * LogValue;
   }
+
+  /** the per-electron values, gradients and laplacians are kept, the
+   * compact lists are rebuilt from the restored e-I table
+   */
+  void registerData(ParticleSet& P, BufferType& buf)
+  {
+    buf.add(Uat.data(), Uat.data() + Nelec);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      buf.add(dUat.data(idim), dUat.data(idim) + Nelec);
+    buf.add(d2Uat.data(), d2Uat.data() + Nelec);
+    buf.add(LogValue);
+  }
+
+  void copyToBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.put(Uat.data(), Uat.data() + Nelec);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      buf.put(dUat.data(idim), dUat.data(idim) + Nelec);
+    buf.put(d2Uat.data(), d2Uat.data() + Nelec);
+    buf.put(LogValue);
+  }
+
+  void copyFromBuffer(ParticleSet& P, BufferType& buf)
+  {
+    buf.get(Uat.data(), Uat.data() + Nelec);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      buf.get(dUat.data(idim), dUat.data(idim) + Nelec);
+    buf.get(d2Uat.data(), d2Uat.data() + Nelec);
+    buf.get(LogValue);
+    build_compact_list(P);
+  }
 };
 
 } // namespace miniqmcreference
@@ -18,6 +18,7 @@
 #include "Particle/DistanceTableData.h"
 #include <Utilities/SIMD/allocator.hpp>
 #include <Utilities/SIMD/algorithm.hpp>
+#include "Utilities/WalkerTeam.h"
 #include <numeric>
 
 /*!
@@ -50,6 +51,8 @@ struct TwoBodyJastrow : public WaveFunctionComponent
   using valT = typename FT::real_type;
   /// element position type
   using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
   /// use the same container
   using RowContainer = DistanceTableData::RowContainer;
 
@@ -82,6 +85,29 @@ struct TwoBodyJastrow : public WaveFunctionComponent
   /// Uniquue J2 set for cleanup
   std::map<std::string, FT*> J2Unique;
 
+  /**@{ walker-major scratch of the leading walker for the crowd kernels
+   *
+   * The entries of the walker iw of a crowd of nw walkers in the group jg
+   * start at nw * P.first(jg) + iw * (P.last(jg) - P.first(jg)).
+   */
+  aligned_vector<distT> mw_dist;
+  aligned_vector<valT> mw_cur_u, mw_cur_du, mw_cur_d2u;
+  aligned_vector<valT> mw_old_u, mw_old_du, mw_old_d2u;
+  /// compression scratch of each thread, with the stride mw_stride
+  aligned_vector<valT> mw_DistCompressed;
+  aligned_vector<int> mw_DistIndice;
+  size_t mw_stride;
+  /// crowd and particle of the values in mw_cur_*
+  std::vector<WaveFunctionComponent*> mw_crowd;
+  int mw_cur_iat;
+  /// accepted walkers and the old and new distance rows of the walkers
+  std::vector<int> mw_acc_list;
+  std::vector<const distT*> mw_old_dist_list, mw_new_dist_list;
+  /**@}*/
+
+  /// row sums of u, laplacian and gradient of each member of the walker team in recompute
+  aligned_vector<valT> team_rows;
+
   TwoBodyJastrow(ParticleSet& p);
   TwoBodyJastrow(const TwoBodyJastrow& rhs) = delete;
   ~TwoBodyJastrow();
@@ -99,11 +125,41 @@ struct TwoBodyJastrow : public WaveFunctionComponent
   /** recompute internal data assuming distance table is fully ready */
   void recompute(ParticleSet& P);
 
+  /** recompute by a walker team of nt members
+   *
+   * Each member owns a block of the columns of the lower triangle, balanced
+   * by the number of pairs. The upper-triangle contributions go directly to
+   * the entries of the block, and the row sums are accumulated in the slice
+   * of the member in team_rows and reduced at the end.
+   */
+  void recomputeTeam(ParticleSet& P, int nt);
+
   ValueType ratio(ParticleSet& P, int iat);
   GradType evalGrad(ParticleSet& P, int iat);
   ValueType ratioGrad(ParticleSet& P, int iat, GradType& grad_iat);
   void acceptMove(ParticleSet& P, int iat);
 
+  /** crowd version of ratioGrad
+   *
+   * The functors of this are used for the whole crowd, which must share them.
+   */
+  void multi_ratioGrad(const std::vector<WaveFunctionComponent*>& WFC_list,
+                       const std::vector<ParticleSet*>& P_list,
+                       int iat,
+                       std::vector<ValueType>& ratios,
+                       std::vector<PosType>& grad_new,
+                       bool serial = false);
+
+  /** crowd version of acceptMove
+   *
+   * Reuses the new values of the preceding multi_ratioGrad of the same crowd.
+   */
+  void multi_acceptrestoreMove(const std::vector<WaveFunctionComponent*>& WFC_list,
+                               const std::vector<ParticleSet*>& P_list,
+                               const std::vector<bool>& isAccepted,
+                               int iat,
+                               bool serial = false);
+
   /** compute G and L after the sweep
    */
   void evaluateGL(ParticleSet& P,
@@ -111,8 +167,13 @@ struct TwoBodyJastrow : public WaveFunctionComponent
                   ParticleSet::ParticleLaplacian_t& L,
                   bool fromscratch = false);
 
+  /** the per-electron values, gradients and laplacians are kept */
+  void registerData(ParticleSet& P, BufferType& buf);
+  void copyToBuffer(ParticleSet& P, BufferType& buf);
+  void copyFromBuffer(ParticleSet& P, BufferType& buf);
+
   /*@{ internal compute engines*/
-  inline valT computeU(const ParticleSet& P, int iat, const RealType* restrict dist)
+  inline valT computeU(const ParticleSet& P, int iat, const distT* restrict dist)
   {
     valT curUat(0);
     const int igt = P.GroupID[iat] * NumGroups;
@@ -128,12 +189,74 @@ struct TwoBodyJastrow : public WaveFunctionComponent
 
   inline void computeU3(const ParticleSet& P,
                         int iat,
-                        const RealType* restrict dist,
+                        const distT* restrict dist,
                         RealType* restrict u,
                         RealType* restrict du,
                         RealType* restrict d2u,
                         bool triangle = false);
 
+  /** compute u, du and d2u of the pairs [first,last) of the iat-th particle
+   *
+   * The compression scratch starting from first is used, so that the members
+   * of a walker team can work on disjoint chunks.
+   */
+  inline void computeU3(const ParticleSet& P,
+                        int iat,
+                        const distT* restrict dist,
+                        RealType* restrict u,
+                        RealType* restrict du,
+                        RealType* restrict d2u,
+                        int first,
+                        int last);
+
+  /** compute u, du and d2u of the iat-th particle for the walkers [iw_first,iw_last) of a crowd
+   * @param P particleset of any walker of the crowd
+   * @param iat particle index
+   * @param nw number of walkers of the crowd
+   * @param iw_first first walker
+   * @param iw_last last walker
+   * @param dist_list distances of the iat-th particle of each walker
+   * @param u walker-major value
+   * @param du walker-major first deriv
+   * @param d2u walker-major second deriv
+   * @param ip scratch slot of the calling thread
+   *
+   * Evaluates each group over all the walkers in one pass.
+   */
+  inline void mw_computeU3(const ParticleSet& P,
+                           int iat,
+                           int nw,
+                           int iw_first,
+                           int iw_last,
+                           const std::vector<const distT*>& dist_list,
+                           valT* restrict u,
+                           valT* restrict du,
+                           valT* restrict d2u,
+                           int ip);
+
+  /** update Uat, dUat and d2Uat with the pairs [jfirst,jfirst+len) of an accepted move of iat
+   * @param P particleset
+   * @param iat particle index
+   * @param jfirst first particle of the pairs
+   * @param len number of the pairs
+   * @param cur_u new values of the pairs, starting from jfirst
+   * @param old_u old values of the pairs, starting from jfirst
+   * @param cur_d2Uat accumulated laplacian of iat
+   * @param cur_dUat accumulated gradient of iat
+   */
+  inline void accumulateMove(const ParticleSet& P,
+                             int iat,
+                             int jfirst,
+                             int len,
+                             const valT* restrict cur_u,
+                             const valT* restrict cur_du,
+                             const valT* restrict cur_d2u,
+                             const valT* restrict old_u,
+                             const valT* restrict old_du,
+                             const valT* restrict old_d2u,
+                             valT& cur_d2Uat,
+                             posT& cur_dUat);
+
   /** compute gradient
    */
   inline posT accumulateG(const valT* restrict du, const RowContainer& displ) const
@@ -141,8 +264,8 @@ struct TwoBodyJastrow : public WaveFunctionComponent
     posT grad;
     for (int idim = 0; idim < OHMMS_DIM; ++idim)
     {
-      const valT* restrict dX = displ.data(idim);
-      valT s                  = valT();
+      const distT* restrict dX = displ.data(idim);
+      valT s                   = valT();
 
       for (int jat = 0; jat < N; ++jat)
         s += du[jat] * dX[jat];
@@ -157,6 +280,8 @@ template<typename FT>
 TwoBodyJastrow<FT>::TwoBodyJastrow(ParticleSet& p)
 {
   init(p);
+  mw_stride                 = 0;
+  mw_cur_iat                = -1;
   FirstTime                 = true;
   KEcorr                    = 0.0;
   WaveFunctionComponentName = "TwoBodyJastrow";
@@ -244,25 +369,46 @@ void TwoBodyJastrow<FT>::addFunc(int ia, int ib, FT* j)
 template<typename FT>
 inline void TwoBodyJastrow<FT>::computeU3(const ParticleSet& P,
                                           int iat,
-                                          const RealType* restrict dist,
+                                          const distT* restrict dist,
                                           RealType* restrict u,
                                           RealType* restrict du,
                                           RealType* restrict d2u,
                                           bool triangle)
 {
-  const int jelmax = triangle ? iat : N;
+  computeU3(P, iat, dist, u, du, d2u, 0, triangle ? iat : N);
+}
+
+template<typename FT>
+inline void TwoBodyJastrow<FT>::computeU3(const ParticleSet& P,
+                                          int iat,
+                                          const distT* restrict dist,
+                                          RealType* restrict u,
+                                          RealType* restrict du,
+                                          RealType* restrict d2u,
+                                          int first,
+                                          int last)
+{
   constexpr valT czero(0);
-  std::fill_n(u, jelmax, czero);
-  std::fill_n(du, jelmax, czero);
-  std::fill_n(d2u, jelmax, czero);
+  std::fill(u + first, u + last, czero);
+  std::fill(du + first, du + last, czero);
+  std::fill(d2u + first, d2u + last, czero);
 
   const int igt = P.GroupID[iat] * NumGroups;
   for (int jg = 0; jg < NumGroups; ++jg)
   {
     const FuncType& f2(*F[igt + jg]);
-    int iStart = P.first(jg);
-    int iEnd   = std::min(jelmax, P.last(jg));
-    f2.evaluateVGL(iat, iStart, iEnd, dist, u, du, d2u, DistCompressed.data(), DistIndice.data());
+    int iStart = std::max(first, P.first(jg));
+    int iEnd   = std::min(last, P.last(jg));
+    if (iStart < iEnd)
+      f2.evaluateVGL(iat,
+                     iStart,
+                     iEnd,
+                     dist,
+                     u,
+                     du,
+                     d2u,
+                     DistCompressed.data() + first,
+                     DistIndice.data() + first);
   }
   // u[iat]=czero;
   // du[iat]=czero;
@@ -290,10 +436,45 @@ typename TwoBodyJastrow<FT>::ValueType
 {
   UpdateMode = ORB_PBYP_PARTIAL;
 
-  computeU3(P, iat, P.DistTables[0]->Temp_r.data(), cur_u.data(), cur_du.data(), cur_d2u.data());
-  cur_Uat = simd::accumulate_n(cur_u.data(), N, valT());
+  const DistanceTableData* d_table = P.DistTables[0];
+  const int nt                     = getWalkerTeamSize(P.WalkerTeamSize, N);
+  if (nt == 1)
+  {
+    computeU3(P, iat, d_table->Temp_r.data(), cur_u.data(), cur_du.data(), cur_d2u.data());
+    cur_Uat = simd::accumulate_n(cur_u.data(), N, valT());
+    grad_iat += accumulateG(cur_du.data(), d_table->Temp_dr);
+  }
+  else
+  {
+    const distT* restrict dX = d_table->Temp_dr.data(0);
+    const distT* restrict dY = d_table->Temp_dr.data(1);
+    const distT* restrict dZ = d_table->Temp_dr.data(2);
+    valT sum_u(0), gx(0), gy(0), gz(0);
+#pragma omp parallel num_threads(nt) reduction(+ : sum_u, gx, gy, gz)
+    {
+      int first, last;
+      getWalkerTeamRange(N, omp_get_thread_num(), nt, first, last);
+      computeU3(P,
+                iat,
+                d_table->Temp_r.data(),
+                cur_u.data(),
+                cur_du.data(),
+                cur_d2u.data(),
+                first,
+                last);
+      const valT* restrict du = cur_du.data();
+      sum_u += simd::accumulate_n(cur_u.data() + first, last - first, valT());
+      for (int j = first; j < last; ++j)
+      {
+        gx += du[j] * dX[j];
+        gy += du[j] * dY[j];
+        gz += du[j] * dZ[j];
+      }
+    }
+    cur_Uat = sum_u;
+    grad_iat += posT(gx, gy, gz);
+  }
   DiffVal = Uat[iat] - cur_Uat;
-  grad_iat += accumulateG(cur_du.data(), P.DistTables[0]->Temp_dr);
   return std::exp(DiffVal);
 }
 
@@ -302,53 +483,345 @@ void TwoBodyJastrow<FT>::acceptMove(ParticleSet& P, int iat)
 {
   // get the old u, du, d2u
   const DistanceTableData* d_table = P.DistTables[0];
-  computeU3(P, iat, d_table->Distances[iat], old_u.data(), old_du.data(), old_d2u.data());
-  if (UpdateMode == ORB_PBYP_RATIO)
-  { // ratio-only during the move; need to compute derivatives
-    const auto dist = d_table->Temp_r.data();
-    computeU3(P, iat, dist, cur_u.data(), cur_du.data(), cur_d2u.data());
+  valT cur_d2Uat(0);
+  posT cur_dUat;
+  const int nt = getWalkerTeamSize(P.WalkerTeamSize, N);
+  if (nt == 1)
+  {
+    computeU3(P, iat, d_table->Distances[iat], old_u.data(), old_du.data(), old_d2u.data());
+    if (UpdateMode == ORB_PBYP_RATIO)
+    { // ratio-only during the move; need to compute derivatives
+      const auto dist = d_table->Temp_r.data();
+      computeU3(P, iat, dist, cur_u.data(), cur_du.data(), cur_d2u.data());
+    }
+
+    accumulateMove(P,
+                   iat,
+                   0,
+                   N,
+                   cur_u.data(),
+                   cur_du.data(),
+                   cur_d2u.data(),
+                   old_u.data(),
+                   old_du.data(),
+                   old_d2u.data(),
+                   cur_d2Uat,
+                   cur_dUat);
   }
+  else
+  {
+    // each member updates the columns of its chunk and accumulates its part of the row
+    valT sum_l(0), gx(0), gy(0), gz(0);
+#pragma omp parallel num_threads(nt) reduction(+ : sum_l, gx, gy, gz)
+    {
+      int first, last;
+      getWalkerTeamRange(N, omp_get_thread_num(), nt, first, last);
+      const distT* dist = d_table->Distances[iat];
+      computeU3(P, iat, dist, old_u.data(), old_du.data(), old_d2u.data(), first, last);
+      if (UpdateMode == ORB_PBYP_RATIO)
+      {
+        dist = d_table->Temp_r.data();
+        computeU3(P, iat, dist, cur_u.data(), cur_du.data(), cur_d2u.data(), first, last);
+      }
 
-  valT cur_d2Uat(0);
-  const auto& new_dr    = d_table->Temp_dr;
-  const auto& old_dr    = d_table->Displacements[iat];
-  constexpr valT lapfac = OHMMS_DIM - RealType(1);
-  for (int jat = 0; jat < N; jat++)
+      valT my_d2Uat(0);
+      posT my_dUat;
+      accumulateMove(P,
+                     iat,
+                     first,
+                     last - first,
+                     cur_u.data() + first,
+                     cur_du.data() + first,
+                     cur_d2u.data() + first,
+                     old_u.data() + first,
+                     old_du.data() + first,
+                     old_d2u.data() + first,
+                     my_d2Uat,
+                     my_dUat);
+      sum_l += my_d2Uat;
+      gx += my_dUat[0];
+      gy += my_dUat[1];
+      gz += my_dUat[2];
+    }
+    cur_d2Uat = sum_l;
+    cur_dUat  = posT(gx, gy, gz);
+  }
+  LogValue += Uat[iat] - cur_Uat;
+  Uat[iat]   = cur_Uat;
+  dUat(iat)  = cur_dUat;
+  d2Uat[iat] = cur_d2Uat;
+}
+
+template<typename FT>
+inline void TwoBodyJastrow<FT>::accumulateMove(const ParticleSet& P,
+                                               int iat,
+                                               int jfirst,
+                                               int len,
+                                               const valT* restrict cur_u,
+                                               const valT* restrict cur_du,
+                                               const valT* restrict cur_d2u,
+                                               const valT* restrict old_u,
+                                               const valT* restrict old_du,
+                                               const valT* restrict old_d2u,
+                                               valT& cur_d2Uat,
+                                               posT& cur_dUat)
+{
+  const DistanceTableData* d_table = P.DistTables[0];
+  const auto& new_dr               = d_table->Temp_dr;
+  const auto& old_dr               = d_table->Displacements[iat];
+  constexpr valT lapfac            = OHMMS_DIM - RealType(1);
+  valT* restrict save_u            = Uat.data() + jfirst;
+  valT* restrict save_l            = d2Uat.data() + jfirst;
+  for (int j = 0; j < len; j++)
   {
-    const valT du   = cur_u[jat] - old_u[jat];
-    const valT newl = cur_d2u[jat] + lapfac * cur_du[jat];
-    const valT dl   = old_d2u[jat] + lapfac * old_du[jat] - newl;
-    Uat[jat] += du;
-    d2Uat[jat] += dl;
+    const valT du   = cur_u[j] - old_u[j];
+    const valT newl = cur_d2u[j] + lapfac * cur_du[j];
+    const valT dl   = old_d2u[j] + lapfac * old_du[j] - newl;
+    save_u[j] += du;
+    save_l[j] += dl;
     cur_d2Uat -= newl;
   }
-  posT cur_dUat;
   for (int idim = 0; idim < OHMMS_DIM; ++idim)
   {
-    const valT* restrict new_dX    = new_dr.data(idim);
-    const valT* restrict old_dX    = old_dr.data(idim);
-    const valT* restrict cur_du_pt = cur_du.data();
-    const valT* restrict old_du_pt = old_du.data();
-    valT* restrict save_g          = dUat.data(idim);
-    valT cur_g                     = cur_dUat[idim];
-    for (int jat = 0; jat < N; jat++)
+    const distT* restrict new_dX = new_dr.data(idim) + jfirst;
+    const distT* restrict old_dX = old_dr.data(idim) + jfirst;
+    valT* restrict save_g        = dUat.data(idim) + jfirst;
+    valT cur_g                   = cur_dUat[idim];
+    for (int j = 0; j < len; j++)
     {
-      const valT newg = cur_du_pt[jat] * new_dX[jat];
-      const valT dg   = newg - old_du_pt[jat] * old_dX[jat];
-      save_g[jat] -= dg;
+      const valT newg = cur_du[j] * new_dX[j];
+      const valT dg   = newg - old_du[j] * old_dX[j];
+      save_g[j] -= dg;
       cur_g += newg;
     }
     cur_dUat[idim] = cur_g;
   }
-  LogValue += Uat[iat] - cur_Uat;
-  Uat[iat]   = cur_Uat;
-  dUat(iat)  = cur_dUat;
-  d2Uat[iat] = cur_d2Uat;
+}
+
+template<typename FT>
+inline void TwoBodyJastrow<FT>::mw_computeU3(const ParticleSet& P,
+                                             int iat,
+                                             int nw,
+                                             int iw_first,
+                                             int iw_last,
+                                             const std::vector<const distT*>& dist_list,
+                                             valT* restrict u,
+                                             valT* restrict du,
+                                             valT* restrict d2u,
+                                             int ip)
+{
+  constexpr valT czero(0);
+  const int igt = P.GroupID[iat] * NumGroups;
+  for (int jg = 0; jg < NumGroups; ++jg)
+  {
+    const FuncType& f2(*F[igt + jg]);
+    const int jfirst   = P.first(jg);
+    const int len      = P.last(jg) - jfirst;
+    const size_t first = nw * jfirst + iw_first * len;
+    const size_t last  = nw * jfirst + iw_last * len;
+    for (int iw = iw_first; iw < iw_last; ++iw)
+    {
+      distT* restrict dist = mw_dist.data() + nw * jfirst + iw * len;
+      std::copy_n(dist_list[iw] + jfirst, len, dist);
+      // exclude the pair with itself
+      if (iat >= jfirst && iat < jfirst + len)
+        dist[iat - jfirst] = f2.cutoff_radius;
+    }
+    std::fill(u + first, u + last, czero);
+    std::fill(du + first, du + last, czero);
+    std::fill(d2u + first, d2u + last, czero);
+    f2.evaluateVGL(-1,
+                   first,
+                   last,
+                   mw_dist.data(),
+                   u,
+                   du,
+                   d2u,
+                   mw_DistCompressed.data() + ip * mw_stride,
+                   mw_DistIndice.data() + ip * mw_stride);
+  }
+}
+
+template<typename FT>
+void TwoBodyJastrow<FT>::multi_ratioGrad(const std::vector<WaveFunctionComponent*>& WFC_list,
+                                         const std::vector<ParticleSet*>& P_list,
+                                         int iat,
+                                         std::vector<ValueType>& ratios,
+                                         std::vector<PosType>& grad_new,
+                                         bool serial)
+{
+  const int nw        = WFC_list.size();
+  const size_t mw_size = nw * N;
+  mw_stride            = getAlignedSize<valT>(mw_size);
+  mw_dist.resize(mw_size);
+  mw_cur_u.resize(mw_size);
+  mw_cur_du.resize(mw_size);
+  mw_cur_d2u.resize(mw_size);
+  mw_DistCompressed.resize(getCrowdThreads(serial) * mw_stride);
+  mw_DistIndice.resize(getCrowdThreads(serial) * mw_stride);
+
+  mw_new_dist_list.resize(nw);
+  for (int iw = 0; iw < nw; iw++)
+    mw_new_dist_list[iw] = P_list[iw]->DistTables[0]->Temp_r.data();
+
+  const ParticleSet& P(*P_list[0]);
+  crowd_parallel(serial, [&](int np, int ip) {
+    const int iw_first = nw * ip / np;
+    const int iw_last  = nw * (ip + 1) / np;
+
+    mw_computeU3(P,
+                 iat,
+                 nw,
+                 iw_first,
+                 iw_last,
+                 mw_new_dist_list,
+                 mw_cur_u.data(),
+                 mw_cur_du.data(),
+                 mw_cur_d2u.data(),
+                 ip);
+
+    for (int iw = iw_first; iw < iw_last; iw++)
+    {
+      TwoBodyJastrow& J2(static_cast<TwoBodyJastrow&>(*WFC_list[iw]));
+      const RowContainer& new_dr = P_list[iw]->DistTables[0]->Temp_dr;
+      valT cur_Uat(0);
+      posT grad;
+      for (int jg = 0; jg < NumGroups; ++jg)
+      {
+        const int jfirst            = P.first(jg);
+        const int len               = P.last(jg) - jfirst;
+        const valT* restrict cur_du = mw_cur_du.data() + nw * jfirst + iw * len;
+        cur_Uat += simd::accumulate_n(mw_cur_u.data() + nw * jfirst + iw * len, len, valT());
+        for (int idim = 0; idim < OHMMS_DIM; ++idim)
+        {
+          const distT* restrict dX = new_dr.data(idim) + jfirst;
+          valT s                   = valT();
+          for (int j = 0; j < len; ++j)
+            s += cur_du[j] * dX[j];
+          grad[idim] += s;
+        }
+      }
+      J2.UpdateMode = ORB_PBYP_PARTIAL;
+      J2.cur_Uat    = cur_Uat;
+      J2.DiffVal    = J2.Uat[iat] - cur_Uat;
+      grad_new[iw] += grad;
+      ratios[iw] = std::exp(J2.DiffVal);
+    }
+  });
+  mw_crowd   = WFC_list;
+  mw_cur_iat = iat;
+}
+
+template<typename FT>
+void TwoBodyJastrow<FT>::multi_acceptrestoreMove(const std::vector<WaveFunctionComponent*>& WFC_list,
+                                                 const std::vector<ParticleSet*>& P_list,
+                                                 const std::vector<bool>& isAccepted,
+                                                 int iat,
+                                                 bool serial)
+{
+  // only the accepted walkers are evaluated
+  mw_acc_list.clear();
+  for (int iw = 0; iw < WFC_list.size(); iw++)
+    if (isAccepted[iw])
+      mw_acc_list.push_back(iw);
+  const int nw   = WFC_list.size();
+  const int nacc = mw_acc_list.size();
+
+  mw_old_dist_list.resize(nacc);
+  mw_new_dist_list.resize(nacc);
+  for (int ia = 0; ia < nacc; ia++)
+  {
+    mw_old_dist_list[ia] = P_list[mw_acc_list[ia]]->DistTables[0]->Distances[iat];
+    mw_new_dist_list[ia] = P_list[mw_acc_list[ia]]->DistTables[0]->Temp_r.data();
+  }
+
+  // the new values are kept from multi_ratioGrad for the crowd, otherwise computed for the accepted walkers
+  const bool cur_ready = mw_cur_iat == iat && mw_crowd == WFC_list;
+  const int cur_nw     = cur_ready ? nw : nacc;
+  const size_t mw_size = std::max(nw, nacc) * N;
+  mw_stride            = getAlignedSize<valT>(mw_size);
+  mw_dist.resize(mw_size);
+  mw_cur_u.resize(mw_size);
+  mw_cur_du.resize(mw_size);
+  mw_cur_d2u.resize(mw_size);
+  mw_old_u.resize(mw_size);
+  mw_old_du.resize(mw_size);
+  mw_old_d2u.resize(mw_size);
+  mw_DistCompressed.resize(getCrowdThreads(serial) * mw_stride);
+  mw_DistIndice.resize(getCrowdThreads(serial) * mw_stride);
+
+  const ParticleSet& P(*P_list[0]);
+  crowd_parallel(serial, [&](int np, int ip) {
+    const int ia_first = nacc * ip / np;
+    const int ia_last  = nacc * (ip + 1) / np;
+
+    if (!cur_ready)
+      mw_computeU3(P,
+                   iat,
+                   nacc,
+                   ia_first,
+                   ia_last,
+                   mw_new_dist_list,
+                   mw_cur_u.data(),
+                   mw_cur_du.data(),
+                   mw_cur_d2u.data(),
+                   ip);
+    mw_computeU3(P,
+                 iat,
+                 nacc,
+                 ia_first,
+                 ia_last,
+                 mw_old_dist_list,
+                 mw_old_u.data(),
+                 mw_old_du.data(),
+                 mw_old_d2u.data(),
+                 ip);
+
+    for (int ia = ia_first; ia < ia_last; ia++)
+    {
+      const int iw = mw_acc_list[ia];
+      const int ic = cur_ready ? iw : ia;
+      TwoBodyJastrow& J2(static_cast<TwoBodyJastrow&>(*WFC_list[iw]));
+      valT cur_d2Uat(0);
+      posT cur_dUat;
+      for (int jg = 0; jg < NumGroups; ++jg)
+      {
+        const int jfirst        = P.first(jg);
+        const int len           = P.last(jg) - jfirst;
+        const size_t cur_offset = cur_nw * jfirst + ic * len;
+        const size_t old_offset = nacc * jfirst + ia * len;
+        J2.accumulateMove(*P_list[iw],
+                          iat,
+                          jfirst,
+                          len,
+                          mw_cur_u.data() + cur_offset,
+                          mw_cur_du.data() + cur_offset,
+                          mw_cur_d2u.data() + cur_offset,
+                          mw_old_u.data() + old_offset,
+                          mw_old_du.data() + old_offset,
+                          mw_old_d2u.data() + old_offset,
+                          cur_d2Uat,
+                          cur_dUat);
+      }
+      J2.LogValue += J2.Uat[iat] - J2.cur_Uat;
+      J2.Uat[iat]   = J2.cur_Uat;
+      J2.dUat(iat)  = cur_dUat;
+      J2.d2Uat[iat] = cur_d2Uat;
+    }
+  });
+  mw_cur_iat = -1;
 }
 
 template<typename FT>
 void TwoBodyJastrow<FT>::recompute(ParticleSet& P)
 {
+  const int nt = getWalkerTeamSize(P.WalkerTeamSize, N);
+  if (nt > 1)
+  {
+    recomputeTeam(P, nt);
+    return;
+  }
+
   const DistanceTableData* d_table = P.DistTables[0];
   for (int ig = 0; ig < NumGroups; ++ig)
   {
@@ -368,8 +841,8 @@ void TwoBodyJastrow<FT>::recompute(ParticleSet& P)
         lap += d2u[jat] + lapfac * du[jat];
       for (int idim = 0; idim < OHMMS_DIM; ++idim)
       {
-        const valT* restrict dX = displ.data(idim);
-        valT s                  = valT();
+        const distT* restrict dX = displ.data(idim);
+        valT s                   = valT();
         for (int jat = 0; jat < iat; ++jat)
           s += du[jat] * dX[jat];
         grad[idim] = s;
@@ -384,8 +857,8 @@ void TwoBodyJastrow<FT>::recompute(ParticleSet& P)
       }
       for (int idim = 0; idim < OHMMS_DIM; ++idim)
       {
-        valT* restrict save_g   = dUat.data(idim);
-        const valT* restrict dX = displ.data(idim);
+        valT* restrict save_g    = dUat.data(idim);
+        const distT* restrict dX = displ.data(idim);
         for (int jat = 0; jat < iat; jat++)
           save_g[jat] -= du[jat] * dX[jat];
       }
@@ -393,6 +866,87 @@ void TwoBodyJastrow<FT>::recompute(ParticleSet& P)
   }
 }
 
+template<typename FT>
+void TwoBodyJastrow<FT>::recomputeTeam(ParticleSet& P, int nt)
+{
+  const DistanceTableData* d_table = P.DistTables[0];
+  constexpr valT czero(0);
+  constexpr valT lapfac = OHMMS_DIM - RealType(1);
+  const size_t nrows    = OHMMS_DIM + 2;
+  team_rows.resize(nt * nrows * N_padded);
+#pragma omp parallel num_threads(nt)
+  {
+    const int ip = omp_get_thread_num();
+    int first, last;
+    getWalkerTeamTriangleRange(N, ip, nt, first, last);
+    valT* restrict row_u = team_rows.data() + ip * nrows * N_padded;
+    valT* restrict row_l = row_u + N_padded;
+    std::fill_n(row_u, nrows * N_padded, czero);
+    std::fill(Uat.data() + first, Uat.data() + last, czero);
+    std::fill(d2Uat.data() + first, d2Uat.data() + last, czero);
+    for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      std::fill(dUat.data(idim) + first, dUat.data(idim) + last, czero);
+
+    valT* restrict save_u = Uat.data();
+    valT* restrict save_l = d2Uat.data();
+    for (int iat = first + 1; iat < N; ++iat)
+    {
+      const int jend = std::min(last, iat);
+      const distT* dist = d_table->Distances[iat];
+      computeU3(P, iat, dist, cur_u.data(), cur_du.data(), cur_d2u.data(), first, jend);
+      const valT* restrict u   = cur_u.data();
+      const valT* restrict du  = cur_du.data();
+      const valT* restrict d2u = cur_d2u.data();
+      valT sum_u(0), sum_l(0);
+      for (int jat = first; jat < jend; ++jat)
+      {
+        const valT lap = d2u[jat] + lapfac * du[jat];
+        sum_u += u[jat];
+        sum_l += lap;
+        save_u[jat] += u[jat];
+        save_l[jat] -= lap;
+      }
+      row_u[iat] = sum_u;
+      row_l[iat] = -sum_l;
+      const RowContainer& displ = d_table->Displacements[iat];
+      for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      {
+        const distT* restrict dX = displ.data(idim);
+        valT* restrict save_g    = dUat.data(idim);
+        valT s                   = valT();
+        for (int jat = first; jat < jend; ++jat)
+        {
+          const valT g = du[jat] * dX[jat];
+          s += g;
+          save_g[jat] -= g;
+        }
+        row_l[(idim + 1) * N_padded + iat] = s;
+      }
+    }
+
+#pragma omp barrier
+    // add the row sums of all the members
+    int rfirst, rlast;
+    getWalkerTeamRange(N, ip, nt, rfirst, rlast);
+    for (int jp = 0; jp < nt; ++jp)
+    {
+      const valT* restrict rows = team_rows.data() + jp * nrows * N_padded;
+      for (int iat = rfirst; iat < rlast; ++iat)
+      {
+        save_u[iat] += rows[iat];
+        save_l[iat] += rows[N_padded + iat];
+      }
+      for (int idim = 0; idim < OHMMS_DIM; ++idim)
+      {
+        const valT* restrict row_g = rows + (idim + 2) * N_padded;
+        valT* restrict save_g      = dUat.data(idim);
+        for (int iat = rfirst; iat < rlast; ++iat)
+          save_g[iat] += row_g[iat];
+      }
+    }
+  }
+}
+
 template<typename FT>
 typename TwoBodyJastrow<FT>::RealType
     TwoBodyJastrow<FT>::evaluateLog(ParticleSet& P,
@@ -423,5 +977,35 @@ void TwoBodyJastrow<FT>::evaluateGL(ParticleSet& P,
   LogValue = mhalf * LogValue;
 }
 
+template<typename FT>
+void TwoBodyJastrow<FT>::registerData(ParticleSet& P, BufferType& buf)
+{
+  buf.add(Uat.data(), Uat.data() + N);
+  for (int idim = 0; idim < OHMMS_DIM; ++idim)
+    buf.add(dUat.data(idim), dUat.data(idim) + N);
+  buf.add(d2Uat.data(), d2Uat.data() + N);
+  buf.add(LogValue);
+}
+
+template<typename FT>
+void TwoBodyJastrow<FT>::copyToBuffer(ParticleSet& P, BufferType& buf)
+{
+  buf.put(Uat.data(), Uat.data() + N);
+  for (int idim = 0; idim < OHMMS_DIM; ++idim)
+    buf.put(dUat.data(idim), dUat.data(idim) + N);
+  buf.put(d2Uat.data(), d2Uat.data() + N);
+  buf.put(LogValue);
+}
+
+template<typename FT>
+void TwoBodyJastrow<FT>::copyFromBuffer(ParticleSet& P, BufferType& buf)
+{
+  buf.get(Uat.data(), Uat.data() + N);
+  for (int idim = 0; idim < OHMMS_DIM; ++idim)
+    buf.get(dUat.data(idim), dUat.data(idim) + N);
+  buf.get(d2Uat.data(), d2Uat.data() + N);
+  buf.get(LogValue);
+}
+
 } // namespace qmcplusplus
 #endif
@@ -50,6 +50,8 @@ struct TwoBodyJastrowRef : public WaveFunctionComponent
   using valT = typename FT::real_type;
   /// element position type
   using posT = TinyVector<valT, OHMMS_DIM>;
+  /// type of the distance table entries
+  using distT = DistanceTableData::DistRealType;
   /// use the same container
   using RowContainer = DistanceTableData::RowContainer;
 
@@ -111,8 +113,13 @@ struct TwoBodyJastrowRef : public WaveFunctionComponent
                   ParticleSet::ParticleLaplacian_t& L,
                   bool fromscratch = false);
 
+  /** the per-electron values, gradients and laplacians are kept */
+  void registerData(ParticleSet& P, BufferType& buf);
+  void copyToBuffer(ParticleSet& P, BufferType& buf);
+  void copyFromBuffer(ParticleSet& P, BufferType& buf);
+
   /*@{ internal compute engines*/
-  inline valT computeU(const ParticleSet& P, int iat, const RealType* restrict dist)
+  inline valT computeU(const ParticleSet& P, int iat, const distT* restrict dist)
   {
     valT curUat(0);
     const int igt = P.GroupID[iat] * NumGroups;
@@ -128,7 +135,7 @@ struct TwoBodyJastrowRef : public WaveFunctionComponent
 
   inline void computeU3(const ParticleSet& P,
                         int iat,
-                        const RealType* restrict dist,
+                        const distT* restrict dist,
                         RealType* restrict u,
                         RealType* restrict du,
                         RealType* restrict d2u,
@@ -141,8 +148,8 @@ struct TwoBodyJastrowRef : public WaveFunctionComponent
     posT grad;
     for (int idim = 0; idim < OHMMS_DIM; ++idim)
     {
-      const valT* restrict dX = displ.data(idim);
-      valT s                  = valT();
+      const distT* restrict dX = displ.data(idim);
+      valT s                   = valT();
 
       for (int jat = 0; jat < N; ++jat)
         s += du[jat] * dX[jat];
@@ -244,7 +251,7 @@ void TwoBodyJastrowRef<FT>::addFunc(int ia, int ib, FT* j)
 template<typename FT>
 inline void TwoBodyJastrowRef<FT>::computeU3(const ParticleSet& P,
                                              int iat,
-                                             const RealType* restrict dist,
+                                             const distT* restrict dist,
                                              RealType* restrict u,
                                              RealType* restrict du,
                                              RealType* restrict d2u,
@@ -325,8 +332,8 @@ void TwoBodyJastrowRef<FT>::acceptMove(ParticleSet& P, int iat)
   posT cur_dUat;
   for (int idim = 0; idim < OHMMS_DIM; ++idim)
   {
-    const valT* restrict new_dX    = new_dr.data(idim);
-    const valT* restrict old_dX    = old_dr.data(idim);
+    const distT* restrict new_dX   = new_dr.data(idim);
+    const distT* restrict old_dX   = old_dr.data(idim);
     const valT* restrict cur_du_pt = cur_du.data();
     const valT* restrict old_du_pt = old_du.data();
     valT* restrict save_g          = dUat.data(idim);
@@ -368,8 +375,8 @@ void TwoBodyJastrowRef<FT>::recompute(ParticleSet& P)
         lap += d2u[jat] + lapfac * du[jat];
       for (int idim = 0; idim < OHMMS_DIM; ++idim)
       {
-        const valT* restrict dX = displ.data(idim);
-        valT s                  = valT();
+        const distT* restrict dX = displ.data(idim);
+        valT s                   = valT();
         for (int jat = 0; jat < iat; ++jat)
           s += du[jat] * dX[jat];
         grad[idim] = s;
@@ -384,8 +391,8 @@ void TwoBodyJastrowRef<FT>::recompute(ParticleSet& P)
       }
       for (int idim = 0; idim < OHMMS_DIM; ++idim)
       {
-        valT* restrict save_g   = dUat.data(idim);
-        const valT* restrict dX = displ.data(idim);
+        valT* restrict save_g    = dUat.data(idim);
+        const distT* restrict dX = displ.data(idim);
         for (int jat = 0; jat < iat; jat++)
           save_g[jat] -= du[jat] * dX[jat];
       }
@@ -423,5 +430,35 @@ void TwoBodyJastrowRef<FT>::evaluateGL(ParticleSet& P,
   LogValue = mhalf * LogValue;
 }
 
+template<typename FT>
+void TwoBodyJastrowRef<FT>::registerData(ParticleSet& P, BufferType& buf)
+{
+  buf.add(Uat.data(), Uat.data() + N);
+  for (int idim = 0; idim < OHMMS_DIM; ++idim)
+    buf.add(dUat.data(idim), dUat.data(idim) + N);
+  buf.add(d2Uat.data(), d2Uat.data() + N);
+  buf.add(LogValue);
+}
+
+template<typename FT>
+void TwoBodyJastrowRef<FT>::copyToBuffer(ParticleSet& P, BufferType& buf)
+{
+  buf.put(Uat.data(), Uat.data() + N);
+  for (int idim = 0; idim < OHMMS_DIM; ++idim)
+    buf.put(dUat.data(idim), dUat.data(idim) + N);
+  buf.put(d2Uat.data(), d2Uat.data() + N);
+  buf.put(LogValue);
+}
+
+template<typename FT>
+void TwoBodyJastrowRef<FT>::copyFromBuffer(ParticleSet& P, BufferType& buf)
+{
+  buf.get(Uat.data(), Uat.data() + N);
+  for (int idim = 0; idim < OHMMS_DIM; ++idim)
+    buf.get(dUat.data(idim), dUat.data(idim) + N);
+  buf.get(d2Uat.data(), d2Uat.data() + N);
+  buf.get(LogValue);
+}
+
 } // namespace miniqmcreference
 #endif
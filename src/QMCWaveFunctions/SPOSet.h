@@ -13,6 +13,7 @@
 #define QMCPLUSPLUS_SINGLEPARTICLEORBITALSET_H
 
 #include <Utilities/Configuration.h>
+#include <Utilities/CrowdThreads.h>
 #include <string>
 
 namespace qmcplusplus
@@ -31,9 +32,15 @@ private:
   std::string className;
 
 public:
+  /// default constructor
+  SPOSet() : OrbitalSetSize(0) {}
+
   /// return the size of the orbital set
   inline int size() const { return OrbitalSetSize; }
 
+  /// set the size of the orbital set
+  inline void setOrbitalSetSize(int norbs) { OrbitalSetSize = norbs; }
+
   /// destructor
   virtual ~SPOSet() {}
 
@@ -43,29 +50,42 @@ public:
   virtual void evaluate_vgl(const PosType& p) = 0;
   virtual void evaluate_vgh(const PosType& p) = 0;
 
-  /// operates on multiple walkers
-  virtual void
-      multi_evaluate_v(const std::vector<SPOSet*>& spo_list, const std::vector<PosType>& pos_list)
+  /** evaluate the values at a batch of positions, leaving this unchanged
+   * @param pos positions of the batch
+   * @param n number of the positions
+   * @param values values at pos[i] are stored from values + i * size()
+   *
+   * The batch may be evaluated by several threads on the same object.
+   */
+  virtual void evaluate_v_batch(const PosType* pos, int n, ValueType* values) const = 0;
+
+  /** return a key of the data used to evaluate the orbitals at a position
+   *
+   * Sorting a batch by the keys puts together the positions which share
+   * their data, e.g. the grid cell of a spline.
+   */
+  virtual int cellIndex(const PosType& p) const = 0;
+
+  /// operates on multiple walkers, by the calling thread alone if serial
+  virtual void multi_evaluate_v(const std::vector<SPOSet*>& spo_list,
+                                 const std::vector<PosType>& pos_list,
+                                 bool serial = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < spo_list.size(); iw++)
-      spo_list[iw]->evaluate_v(pos_list[iw]);
+    crowd_for(serial, spo_list.size(), [&](int iw) { spo_list[iw]->evaluate_v(pos_list[iw]); });
   }
 
-  virtual void
-      multi_evaluate_vgl(const std::vector<SPOSet*>& spo_list, const std::vector<PosType>& pos_list)
+  virtual void multi_evaluate_vgl(const std::vector<SPOSet*>& spo_list,
+                                 const std::vector<PosType>& pos_list,
+                                 bool serial = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < spo_list.size(); iw++)
-      spo_list[iw]->evaluate_vgl(pos_list[iw]);
+    crowd_for(serial, spo_list.size(), [&](int iw) { spo_list[iw]->evaluate_vgl(pos_list[iw]); });
   }
 
-  virtual void
-      multi_evaluate_vgh(const std::vector<SPOSet*>& spo_list, const std::vector<PosType>& pos_list)
+  virtual void multi_evaluate_vgh(const std::vector<SPOSet*>& spo_list,
+                                 const std::vector<PosType>& pos_list,
+                                 bool serial = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < spo_list.size(); iw++)
-      spo_list[iw]->evaluate_vgh(pos_list[iw]);
+    crowd_for(serial, spo_list.size(), [&](int iw) { spo_list[iw]->evaluate_vgh(pos_list[iw]); });
   }
 };
 
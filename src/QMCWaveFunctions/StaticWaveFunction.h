@@ -0,0 +1,384 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+// -*- C++ -*-
+
+/**
+ * @file StaticWaveFunction.h
+ * @brief Wavefunction container over a compile-time list of components
+ *
+ * Same single-walker interface as WaveFunction, with the component types
+ * known at compile time. The components are called by their qualified
+ * names, which bypasses the virtual dispatch and lets the compiler inline
+ * them into the driver loops.
+ */
+
+#ifndef QMCPLUSPLUS_STATIC_WAVEFUNCTION_H
+#define QMCPLUSPLUS_STATIC_WAVEFUNCTION_H
+#include <Utilities/Configuration.h>
+#include <Utilities/RandomGenerator.h>
+#include <Particle/ParticleSet.h>
+#include <QMCWaveFunctions/Determinant.h>
+#include <QMCWaveFunctions/Jastrow/BsplineFunctor.h>
+#include <QMCWaveFunctions/Jastrow/PolynomialFunctor3D.h>
+#include <QMCWaveFunctions/Jastrow/OneBodyJastrow.h>
+#include <QMCWaveFunctions/Jastrow/TwoBodyJastrow.h>
+#include <QMCWaveFunctions/Jastrow/ThreeBodyJastrow.h>
+#include <tuple>
+#include <type_traits>
+
+namespace qmcplusplus
+{
+/** A TrialWavefunction of a determinant pair and a fixed list of Jastrow factors
+ * @tparam DetType type of the up and down determinants
+ * @tparam JastrowTypes types of the Jastrow factors, in the order of evaluation
+ *
+ * A Jastrow factor of the list can be left out at run time by a nullptr.
+ */
+template<class DetType, class... JastrowTypes>
+class StaticWaveFunction
+{
+  using RealType = OHMMS_PRECISION;
+  using valT     = OHMMS_PRECISION;
+  using posT     = TinyVector<valT, OHMMS_DIM>;
+
+private:
+  std::tuple<JastrowTypes*...> Jastrows;
+  DetType* Det_up;
+  DetType* Det_dn;
+  valT LogValue;
+
+  bool FirstTime, Is_built;
+  int nelup, ei_TableID;
+
+  /**@{ operations on a component, calling it by the qualified name */
+  struct EvaluateLogOp
+  {
+    ParticleSet& P;
+    valT LogValue;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      LogValue += c.C::evaluateLog(P, P.G, P.L);
+    }
+  };
+
+  struct EvalGradOp
+  {
+    ParticleSet& P;
+    int iat;
+    posT grad;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      grad += c.C::evalGrad(P, iat);
+    }
+  };
+
+  struct RatioGradOp
+  {
+    ParticleSet& P;
+    int iat;
+    posT& grad;
+    valT ratio;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      ratio *= c.C::ratioGrad(P, iat, grad);
+    }
+  };
+
+  struct RatioOp
+  {
+    ParticleSet& P;
+    int iat;
+    valT ratio;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      ratio *= c.C::ratio(P, iat);
+    }
+  };
+
+  struct AcceptMoveOp
+  {
+    ParticleSet& P;
+    int iat;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      c.C::acceptMove(P, iat);
+    }
+  };
+
+  struct EvaluateGLOp
+  {
+    ParticleSet& P;
+    valT LogValue;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      c.C::evaluateGL(P, P.G, P.L);
+      LogValue += c.WaveFunctionComponent::LogValue;
+    }
+  };
+
+  struct ReorderOp
+  {
+    const std::vector<int>& new2old;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      c.C::reorderParticles(new2old);
+    }
+  };
+
+  struct RegisterDataOp
+  {
+    ParticleSet& P;
+    WaveFunctionComponent::BufferType& buf;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      c.C::registerData(P, buf);
+    }
+  };
+
+  struct CopyToBufferOp
+  {
+    ParticleSet& P;
+    WaveFunctionComponent::BufferType& buf;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      c.C::copyToBuffer(P, buf);
+    }
+  };
+
+  struct CopyFromBufferOp
+  {
+    ParticleSet& P;
+    WaveFunctionComponent::BufferType& buf;
+    template<class C>
+    inline void operator()(C& c)
+    {
+      c.C::copyFromBuffer(P, buf);
+    }
+  };
+
+  struct DeleteOp
+  {
+    template<class C>
+    inline void operator()(C& c)
+    {
+      delete &c;
+    }
+  };
+  /**@}*/
+
+  /// apply op to the enabled Jastrow factors, starting from the I-th
+  template<size_t I = 0, class Op>
+  inline typename std::enable_if<I == sizeof...(JastrowTypes)>::type forEachJastrow(Op& op)
+  {}
+
+  template<size_t I = 0, class Op>
+  inline typename std::enable_if<(I < sizeof...(JastrowTypes))>::type forEachJastrow(Op& op)
+  {
+    if (std::get<I>(Jastrows) != nullptr)
+      op(*std::get<I>(Jastrows));
+    forEachJastrow<I + 1>(op);
+  }
+
+public:
+  StaticWaveFunction()
+      : Det_up(nullptr),
+        Det_dn(nullptr),
+        LogValue(0.0),
+        FirstTime(true),
+        Is_built(false),
+        nelup(0),
+        ei_TableID(1)
+  {}
+
+  StaticWaveFunction(const StaticWaveFunction&) = delete;
+
+  ~StaticWaveFunction()
+  {
+    if (Is_built)
+    {
+      delete Det_up;
+      delete Det_dn;
+      DeleteOp op;
+      forEachJastrow(op);
+    }
+  }
+
+  /** take the ownership of the components
+   * @param nelup_in number of the up electrons
+   * @param ei_TableID_in index of the e-I distance table
+   * @param up determinant of the up electrons
+   * @param dn determinant of the down electrons
+   * @param jastrows Jastrow factors, nullptr for the disabled ones
+   */
+  void setComponents(int nelup_in,
+                     int ei_TableID_in,
+                     DetType* up,
+                     DetType* dn,
+                     JastrowTypes*... jastrows)
+  {
+    nelup      = nelup_in;
+    ei_TableID = ei_TableID_in;
+    Det_up     = up;
+    Det_dn     = dn;
+    Jastrows   = std::make_tuple(jastrows...);
+    Is_built   = true;
+  }
+
+  bool isBuilt() const { return Is_built; }
+
+  /// operates on a single walker
+  void evaluateLog(ParticleSet& P)
+  {
+    constexpr valT czero(0);
+    if (FirstTime)
+    {
+      P.G = czero;
+      P.L = czero;
+      EvaluateLogOp op{P, czero};
+      op.LogValue = Det_up->DetType::evaluateLog(P, P.G, P.L);
+      op.LogValue += Det_dn->DetType::evaluateLog(P, P.G, P.L);
+      forEachJastrow(op);
+      LogValue  = op.LogValue;
+      FirstTime = false;
+    }
+  }
+
+  inline posT evalGrad(ParticleSet& P, int iat)
+  {
+    DetType* det = iat < nelup ? Det_up : Det_dn;
+    EvalGradOp op{P, iat, det->DetType::evalGrad(P, iat)};
+    forEachJastrow(op);
+    return op.grad;
+  }
+
+  inline valT ratioGrad(ParticleSet& P, int iat, posT& grad)
+  {
+    DetType* det = iat < nelup ? Det_up : Det_dn;
+    grad         = valT(0);
+    RatioGradOp op{P, iat, grad, valT(1)};
+    op.ratio = det->DetType::ratioGrad(P, iat, grad);
+    forEachJastrow(op);
+    return op.ratio;
+  }
+
+  inline valT ratio(ParticleSet& P, int iat)
+  {
+    DetType* det = iat < nelup ? Det_up : Det_dn;
+    RatioOp op{P, iat, det->DetType::ratio(P, iat)};
+    forEachJastrow(op);
+    return op.ratio;
+  }
+
+  inline void acceptMove(ParticleSet& P, int iat)
+  {
+    DetType* det = iat < nelup ? Det_up : Det_dn;
+    det->DetType::acceptMove(P, iat);
+    AcceptMoveOp op{P, iat};
+    forEachJastrow(op);
+  }
+
+  inline void restore(int iat) {}
+
+  void evaluateGL(ParticleSet& P)
+  {
+    constexpr valT czero(0);
+    P.G = czero;
+    P.L = czero;
+    Det_up->DetType::evaluateGL(P, P.G, P.L);
+    Det_dn->DetType::evaluateGL(P, P.G, P.L);
+    EvaluateGLOp op{P,
+                    Det_up->WaveFunctionComponent::LogValue +
+                        Det_dn->WaveFunctionComponent::LogValue};
+    forEachJastrow(op);
+    LogValue = op.LogValue;
+  }
+
+  /** follow the reordered particles of P and recompute from scratch
+   * @param P target ParticleSet, already reordered and updated
+   * @param new2old new2old[i] is the old index of the particle at the new index i
+   */
+  void reorderParticles(ParticleSet& P, const std::vector<int>& new2old)
+  {
+    Det_up->DetType::reorderParticles(new2old);
+    Det_dn->DetType::reorderParticles(new2old);
+    ReorderOp op{new2old};
+    forEachJastrow(op);
+    FirstTime = true;
+    evaluateLog(P);
+  }
+
+  /// add the state of the components to the buffer of a walker, at its cursor
+  void registerData(ParticleSet& P, WaveFunctionComponent::BufferType& buf)
+  {
+    Det_up->DetType::registerData(P, buf);
+    Det_dn->DetType::registerData(P, buf);
+    RegisterDataOp op{P, buf};
+    forEachJastrow(op);
+    buf.add(LogValue);
+  }
+
+  /// copy the state of the components to buf at its cursor, laid out by registerData
+  void copyToBuffer(ParticleSet& P, WaveFunctionComponent::BufferType& buf)
+  {
+    Det_up->DetType::copyToBuffer(P, buf);
+    Det_dn->DetType::copyToBuffer(P, buf);
+    CopyToBufferOp op{P, buf};
+    forEachJastrow(op);
+    buf.put(LogValue);
+  }
+
+  /// restore the state of the components from buf at its cursor, without recomputation
+  void copyFromBuffer(ParticleSet& P, WaveFunctionComponent::BufferType& buf)
+  {
+    Det_up->DetType::copyFromBuffer(P, buf);
+    Det_dn->DetType::copyFromBuffer(P, buf);
+    CopyFromBufferOp op{P, buf};
+    forEachJastrow(op);
+    buf.get(LogValue);
+    FirstTime = false;
+  }
+
+  // others
+  int get_ei_TableID() const { return ei_TableID; }
+  valT getLogValue() const { return LogValue; }
+};
+
+/// determinants with the one-, two- and optional three-body Jastrow factors of miniqmc
+using StaticSlaterJastrow = StaticWaveFunction<DiracDeterminant,
+                                               OneBodyJastrow<BsplineFunctor<OHMMS_PRECISION>>,
+                                               TwoBodyJastrow<BsplineFunctor<OHMMS_PRECISION>>,
+                                               ThreeBodyJastrow<PolynomialFunctor3D>>;
+
+/** build the standard layout in a StaticSlaterJastrow
+ *
+ * Same arguments as the build_WaveFunction of WaveFunction. There are no
+ * reference or fused variants, so useRef and fuseJastrows must be off.
+ */
+void build_WaveFunction(bool useRef,
+                        StaticSlaterJastrow& WF,
+                        ParticleSet& ions,
+                        ParticleSet& els,
+                        const RandomGenerator<QMCTraits::RealType>& RNG,
+                        bool enableJ3,
+                        bool fuseJastrows = false);
+
+} // namespace qmcplusplus
+
+#endif
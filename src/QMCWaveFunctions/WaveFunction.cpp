@@ -16,6 +16,7 @@
  */
 
 #include <QMCWaveFunctions/WaveFunction.h>
+#include <QMCWaveFunctions/StaticWaveFunction.h>
 #include <QMCWaveFunctions/Determinant.h>
 #include <QMCWaveFunctions/DeterminantRef.h>
 #include <QMCWaveFunctions/Jastrow/BsplineFunctor.h>
@@ -26,6 +27,7 @@
 #include <QMCWaveFunctions/Jastrow/TwoBodyJastrow.h>
 #include <QMCWaveFunctions/Jastrow/ThreeBodyJastrowRef.h>
 #include <QMCWaveFunctions/Jastrow/ThreeBodyJastrow.h>
+#include <QMCWaveFunctions/Jastrow/FusedJastrow.h>
 #include <Input/Input.hpp>
 
 namespace qmcplusplus
@@ -45,7 +47,8 @@ void build_WaveFunction(bool useRef,
                         ParticleSet& ions,
                         ParticleSet& els,
                         const RandomGenerator<QMCTraits::RealType>& RNG,
-                        bool enableJ3)
+                        bool enableJ3,
+                        bool fuseJastrows)
 {
   using valT = WaveFunction::valT;
   using posT = WaveFunction::posT;
@@ -117,19 +120,27 @@ void build_WaveFunction(bool useRef,
     // J1 component
     J1OrbType* J1 = new J1OrbType(ions, els);
     buildJ1(*J1, els.Lattice.WignerSeitzRadius);
-    WF.Jastrows.push_back(J1);
 
     // J2 component
     J2OrbType* J2 = new J2OrbType(els);
     buildJ2(*J2, els.Lattice.WignerSeitzRadius);
-    WF.Jastrows.push_back(J2);
 
     // J3 component
+    J3OrbType* J3 = nullptr;
     if (enableJ3)
     {
-      J3OrbType* J3 = new J3OrbType(ions, els);
+      J3 = new J3OrbType(ions, els);
       buildJeeI(*J3, els.Lattice.WignerSeitzRadius);
-      WF.Jastrows.push_back(J3);
+    }
+
+    if (fuseJastrows)
+      WF.Jastrows.push_back(new FusedJastrow<BsplineFunctor<valT>, PolynomialFunctor3D>(J1, J2, J3));
+    else
+    {
+      WF.Jastrows.push_back(J1);
+      WF.Jastrows.push_back(J2);
+      if (J3 != nullptr)
+        WF.Jastrows.push_back(J3);
     }
   }
 
@@ -138,6 +149,62 @@ void build_WaveFunction(bool useRef,
   WF.Is_built = true;
 }
 
+void build_WaveFunction(bool useRef,
+                        StaticSlaterJastrow& WF,
+                        ParticleSet& ions,
+                        ParticleSet& els,
+                        const RandomGenerator<QMCTraits::RealType>& RNG,
+                        bool enableJ3,
+                        bool fuseJastrows)
+{
+  using valT      = QMCTraits::RealType;
+  using J1OrbType = OneBodyJastrow<BsplineFunctor<valT>>;
+  using J2OrbType = TwoBodyJastrow<BsplineFunctor<valT>>;
+  using J3OrbType = ThreeBodyJastrow<PolynomialFunctor3D>;
+  using DetType   = DiracDeterminant;
+
+  if (WF.isBuilt())
+  {
+    app_log() << "The wavefunction was built before!" << std::endl;
+    return;
+  }
+
+  if (useRef || fuseJastrows)
+    APP_ABORT("build_WaveFunction: the static-dispatch wavefunction has no reference or fused "
+              "Jastrow variants.\n");
+
+  const int nelup = els.getTotalNum() / 2;
+
+  ions.RSoA = ions.R;
+  els.RSoA  = els.R;
+
+  // distance tables
+  els.addTable(els, DT_SOA);
+  const int ei_TableID = els.addTable(ions, DT_SOA);
+
+  // determinant component
+  DetType* Det_up = new DetType(nelup, RNG, 0);
+  DetType* Det_dn = new DetType(els.getTotalNum() - nelup, RNG, nelup);
+
+  // J1 component
+  J1OrbType* J1 = new J1OrbType(ions, els);
+  buildJ1(*J1, els.Lattice.WignerSeitzRadius);
+
+  // J2 component
+  J2OrbType* J2 = new J2OrbType(els);
+  buildJ2(*J2, els.Lattice.WignerSeitzRadius);
+
+  // J3 component
+  J3OrbType* J3 = nullptr;
+  if (enableJ3)
+  {
+    J3 = new J3OrbType(ions, els);
+    buildJeeI(*J3, els.Lattice.WignerSeitzRadius);
+  }
+
+  WF.setComponents(nelup, ei_TableID, Det_up, Det_dn, J1, J2, J3);
+}
+
 WaveFunction::~WaveFunction()
 {
   if (Is_built)
@@ -174,6 +241,44 @@ void WaveFunction::evaluateLog(ParticleSet& P)
   }
 }
 
+void WaveFunction::reorderParticles(ParticleSet& P, const std::vector<int>& new2old)
+{
+  Det_up->reorderParticles(new2old);
+  Det_dn->reorderParticles(new2old);
+  for (size_t i = 0; i < Jastrows.size(); i++)
+    Jastrows[i]->reorderParticles(new2old);
+  FirstTime = true;
+  evaluateLog(P);
+}
+
+void WaveFunction::registerData(ParticleSet& P, WaveFunctionComponent::BufferType& buf)
+{
+  Det_up->registerData(P, buf);
+  Det_dn->registerData(P, buf);
+  for (size_t i = 0; i < Jastrows.size(); i++)
+    Jastrows[i]->registerData(P, buf);
+  buf.add(LogValue);
+}
+
+void WaveFunction::copyToBuffer(ParticleSet& P, WaveFunctionComponent::BufferType& buf)
+{
+  Det_up->copyToBuffer(P, buf);
+  Det_dn->copyToBuffer(P, buf);
+  for (size_t i = 0; i < Jastrows.size(); i++)
+    Jastrows[i]->copyToBuffer(P, buf);
+  buf.put(LogValue);
+}
+
+void WaveFunction::copyFromBuffer(ParticleSet& P, WaveFunctionComponent::BufferType& buf)
+{
+  Det_up->copyFromBuffer(P, buf);
+  Det_dn->copyFromBuffer(P, buf);
+  for (size_t i = 0; i < Jastrows.size(); i++)
+    Jastrows[i]->copyFromBuffer(P, buf);
+  buf.get(LogValue);
+  FirstTime = false;
+}
+
 WaveFunction::posT WaveFunction::evalGrad(ParticleSet& P, int iat)
 {
   timers[Timer_Det]->start();
@@ -220,6 +325,23 @@ WaveFunction::valT WaveFunction::ratio(ParticleSet& P, int iat)
   return ratio;
 }
 
+WaveFunction::valT WaveFunction::ratioFromOrbitals(int iat, const valT* psi) const
+{
+  return (iat < nelup ? Det_up->ratioFromOrbitals(iat, psi) : Det_dn->ratioFromOrbitals(iat, psi));
+}
+
+WaveFunction::valT WaveFunction::ratioJastrow(ParticleSet& P, int iat)
+{
+  valT ratio(1);
+  for (size_t i = 0; i < Jastrows.size(); i++)
+  {
+    jastrow_timers[i]->start();
+    ratio *= Jastrows[i]->ratio(P, iat);
+    jastrow_timers[i]->stop();
+  }
+  return ratio;
+}
+
 void WaveFunction::acceptMove(ParticleSet& P, int iat)
 {
   timers[Timer_Det]->start();
@@ -262,38 +384,45 @@ void WaveFunction::evaluateGL(ParticleSet& P)
 }
 
 void WaveFunction::multi_evaluateLog(const std::vector<WaveFunction*>& WF_list,
-                                     const std::vector<ParticleSet*>& P_list) const
+                                     const std::vector<ParticleSet*>& P_list,
+                                     MultiWaveFunctionScratch& scratch,
+                                     bool serial) const
 {
   if (WF_list[0]->FirstTime)
   {
     constexpr valT czero(0);
-    const std::vector<ParticleSet::ParticleGradient_t*> G_list(extract_G_list(P_list));
-    const std::vector<ParticleSet::ParticleLaplacian_t*> L_list(extract_L_list(P_list));
-    ParticleSet::ParticleValue_t LogValues(P_list.size());
-
-    for (int iw = 0; iw < P_list.size(); iw++)
+    const int nw = P_list.size();
+    scratch.G_list.resize(nw);
+    scratch.L_list.resize(nw);
+    scratch.values.resize(nw);
+    for (int iw = 0; iw < nw; iw++)
     {
-      *G_list[iw] = czero;
-      *L_list[iw] = czero;
+      scratch.G_list[iw]  = &P_list[iw]->G;
+      scratch.L_list[iw]  = &P_list[iw]->L;
+      *scratch.G_list[iw] = czero;
+      *scratch.L_list[iw] = czero;
     }
     // det up/dn
-    std::vector<WaveFunctionComponent*> up_list(extract_up_list(WF_list));
-    Det_up->multi_evaluateLog(up_list, P_list, G_list, L_list, LogValues);
-    for (int iw = 0; iw < P_list.size(); iw++)
-      WF_list[iw]->LogValue = LogValues[iw];
-    std::vector<WaveFunctionComponent*> dn_list(extract_dn_list(WF_list));
-    Det_dn->multi_evaluateLog(dn_list, P_list, G_list, L_list, LogValues);
-    for (int iw = 0; iw < P_list.size(); iw++)
-      WF_list[iw]->LogValue += LogValues[iw];
+    fill_up_list(WF_list, scratch.WFC_list);
+    Det_up->multi_evaluateLog(scratch.WFC_list, P_list, scratch.G_list, scratch.L_list,
+                              scratch.values, serial);
+    for (int iw = 0; iw < nw; iw++)
+      WF_list[iw]->LogValue = scratch.values[iw];
+    fill_dn_list(WF_list, scratch.WFC_list);
+    Det_dn->multi_evaluateLog(scratch.WFC_list, P_list, scratch.G_list, scratch.L_list,
+                              scratch.values, serial);
+    for (int iw = 0; iw < nw; iw++)
+      WF_list[iw]->LogValue += scratch.values[iw];
     // Jastrow factors
     for (size_t i = 0; i < Jastrows.size(); i++)
     {
-      std::vector<WaveFunctionComponent*> jas_list(extract_jas_list(WF_list, i));
-      Jastrows[i]->multi_evaluateLog(jas_list, P_list, G_list, L_list, LogValues);
-      for (int iw = 0; iw < P_list.size(); iw++)
-        WF_list[iw]->LogValue += LogValues[iw];
+      fill_jas_list(WF_list, i, scratch.WFC_list);
+      Jastrows[i]->multi_evaluateLog(scratch.WFC_list, P_list, scratch.G_list, scratch.L_list,
+                                     scratch.values, serial);
+      for (int iw = 0; iw < nw; iw++)
+        WF_list[iw]->LogValue += scratch.values[iw];
     }
-    for (int iw = 0; iw < P_list.size(); iw++)
+    for (int iw = 0; iw < nw; iw++)
       WF_list[iw]->FirstTime = false;
   }
 }
@@ -301,32 +430,35 @@ void WaveFunction::multi_evaluateLog(const std::vector<WaveFunction*>& WF_list,
 void WaveFunction::multi_evalGrad(const std::vector<WaveFunction*>& WF_list,
                                   const std::vector<ParticleSet*>& P_list,
                                   int iat,
-                                  std::vector<posT>& grad_now) const
+                                  std::vector<posT>& grad_now,
+                                  MultiWaveFunctionScratch& scratch,
+                                  bool serial) const
 {
+  const int nw = P_list.size();
+  scratch.grads.resize(nw);
+
   timers[Timer_Det]->start();
-  std::vector<posT> grad_now_det(P_list.size());
   if (iat < nelup)
   {
-    std::vector<WaveFunctionComponent*> up_list(extract_up_list(WF_list));
-    Det_up->multi_evalGrad(up_list, P_list, iat, grad_now_det);
+    fill_up_list(WF_list, scratch.WFC_list);
+    Det_up->multi_evalGrad(scratch.WFC_list, P_list, iat, scratch.grads, serial);
   }
   else
   {
-    std::vector<WaveFunctionComponent*> dn_list(extract_dn_list(WF_list));
-    Det_dn->multi_evalGrad(dn_list, P_list, iat, grad_now_det);
+    fill_dn_list(WF_list, scratch.WFC_list);
+    Det_dn->multi_evalGrad(scratch.WFC_list, P_list, iat, scratch.grads, serial);
   }
-  for (int iw = 0; iw < P_list.size(); iw++)
-    grad_now[iw] = grad_now_det[iw];
+  for (int iw = 0; iw < nw; iw++)
+    grad_now[iw] = scratch.grads[iw];
   timers[Timer_Det]->stop();
 
   for (size_t i = 0; i < Jastrows.size(); i++)
   {
     jastrow_timers[i]->start();
-    std::vector<posT> grad_now_jas(P_list.size());
-    std::vector<WaveFunctionComponent*> jas_list(extract_jas_list(WF_list, i));
-    Jastrows[i]->multi_evalGrad(jas_list, P_list, iat, grad_now_jas);
-    for (int iw = 0; iw < P_list.size(); iw++)
-      grad_now[iw] += grad_now_jas[iw];
+    fill_jas_list(WF_list, i, scratch.WFC_list);
+    Jastrows[i]->multi_evalGrad(scratch.WFC_list, P_list, iat, scratch.grads, serial);
+    for (int iw = 0; iw < nw; iw++)
+      grad_now[iw] += scratch.grads[iw];
     jastrow_timers[i]->stop();
   }
 }
@@ -335,34 +467,37 @@ void WaveFunction::multi_ratioGrad(const std::vector<WaveFunction*>& WF_list,
                                    const std::vector<ParticleSet*>& P_list,
                                    int iat,
                                    std::vector<valT>& ratios,
-                                   std::vector<posT>& grad_new) const
+                                   std::vector<posT>& grad_new,
+                                   MultiWaveFunctionScratch& scratch,
+                                   bool serial) const
 {
+  const int nw = P_list.size();
+  scratch.ratios.resize(nw);
+
   timers[Timer_Det]->start();
-  std::vector<valT> ratios_det(P_list.size());
-  for (int iw = 0; iw < P_list.size(); iw++)
+  for (int iw = 0; iw < nw; iw++)
     grad_new[iw] = valT(0);
   if (iat < nelup)
   {
-    std::vector<WaveFunctionComponent*> up_list(extract_up_list(WF_list));
-    Det_up->multi_ratioGrad(up_list, P_list, iat, ratios_det, grad_new);
+    fill_up_list(WF_list, scratch.WFC_list);
+    Det_up->multi_ratioGrad(scratch.WFC_list, P_list, iat, scratch.ratios, grad_new, serial);
   }
   else
   {
-    std::vector<WaveFunctionComponent*> dn_list(extract_dn_list(WF_list));
-    Det_dn->multi_ratioGrad(dn_list, P_list, iat, ratios_det, grad_new);
+    fill_dn_list(WF_list, scratch.WFC_list);
+    Det_dn->multi_ratioGrad(scratch.WFC_list, P_list, iat, scratch.ratios, grad_new, serial);
   }
-  for (int iw = 0; iw < P_list.size(); iw++)
-    ratios[iw] = ratios_det[iw];
+  for (int iw = 0; iw < nw; iw++)
+    ratios[iw] = scratch.ratios[iw];
   timers[Timer_Det]->stop();
 
   for (size_t i = 0; i < Jastrows.size(); i++)
   {
     jastrow_timers[i]->start();
-    std::vector<valT> ratios_jas(P_list.size());
-    std::vector<WaveFunctionComponent*> jas_list(extract_jas_list(WF_list, i));
-    Jastrows[i]->multi_ratioGrad(jas_list, P_list, iat, ratios_jas, grad_new);
-    for (int iw = 0; iw < P_list.size(); iw++)
-      ratios[iw] *= ratios_jas[iw];
+    fill_jas_list(WF_list, i, scratch.WFC_list);
+    Jastrows[i]->multi_ratioGrad(scratch.WFC_list, P_list, iat, scratch.ratios, grad_new, serial);
+    for (int iw = 0; iw < nw; iw++)
+      ratios[iw] *= scratch.ratios[iw];
     jastrow_timers[i]->stop();
   }
 }
@@ -370,61 +505,93 @@ void WaveFunction::multi_ratioGrad(const std::vector<WaveFunction*>& WF_list,
 void WaveFunction::multi_acceptrestoreMove(const std::vector<WaveFunction*>& WF_list,
                                            const std::vector<ParticleSet*>& P_list,
                                            const std::vector<bool>& isAccepted,
-                                           int iat) const
+                                           int iat,
+                                           MultiWaveFunctionScratch& scratch,
+                                           bool serial) const
 {
   timers[Timer_Det]->start();
   if (iat < nelup)
   {
-    std::vector<WaveFunctionComponent*> up_list(extract_up_list(WF_list));
-    Det_up->multi_acceptrestoreMove(up_list, P_list, isAccepted, iat);
+    fill_up_list(WF_list, scratch.WFC_list);
+    Det_up->multi_acceptrestoreMove(scratch.WFC_list, P_list, isAccepted, iat, serial);
   }
   else
   {
-    std::vector<WaveFunctionComponent*> dn_list(extract_dn_list(WF_list));
-    Det_dn->multi_acceptrestoreMove(dn_list, P_list, isAccepted, iat);
+    fill_dn_list(WF_list, scratch.WFC_list);
+    Det_dn->multi_acceptrestoreMove(scratch.WFC_list, P_list, isAccepted, iat, serial);
   }
   timers[Timer_Det]->stop();
 
   for (size_t i = 0; i < Jastrows.size(); i++)
   {
     jastrow_timers[i]->start();
-    std::vector<WaveFunctionComponent*> jas_list(extract_jas_list(WF_list, i));
-    Jastrows[i]->multi_acceptrestoreMove(jas_list, P_list, isAccepted, iat);
+    fill_jas_list(WF_list, i, scratch.WFC_list);
+    Jastrows[i]->multi_acceptrestoreMove(scratch.WFC_list, P_list, isAccepted, iat, serial);
     jastrow_timers[i]->stop();
   }
 }
 
 void WaveFunction::multi_evaluateGL(const std::vector<WaveFunction*>& WF_list,
-                                    const std::vector<ParticleSet*>& P_list) const
+                                    const std::vector<ParticleSet*>& P_list,
+                                    MultiWaveFunctionScratch& scratch,
+                                    bool serial) const
 {
   constexpr valT czero(0);
-  const std::vector<ParticleSet::ParticleGradient_t*> G_list(extract_G_list(P_list));
-  const std::vector<ParticleSet::ParticleLaplacian_t*> L_list(extract_L_list(P_list));
-
-  for (int iw = 0; iw < P_list.size(); iw++)
+  const int nw = P_list.size();
+  scratch.G_list.resize(nw);
+  scratch.L_list.resize(nw);
+  for (int iw = 0; iw < nw; iw++)
   {
-    *G_list[iw] = czero;
-    *L_list[iw] = czero;
+    scratch.G_list[iw]  = &P_list[iw]->G;
+    scratch.L_list[iw]  = &P_list[iw]->L;
+    *scratch.G_list[iw] = czero;
+    *scratch.L_list[iw] = czero;
   }
   // det up/dn
-  std::vector<WaveFunctionComponent*> up_list(extract_up_list(WF_list));
-  Det_up->multi_evaluateGL(up_list, P_list, G_list, L_list);
-  for (int iw = 0; iw < P_list.size(); iw++)
-    WF_list[iw]->LogValue = up_list[iw]->LogValue;
-  std::vector<WaveFunctionComponent*> dn_list(extract_dn_list(WF_list));
-  Det_dn->multi_evaluateGL(dn_list, P_list, G_list, L_list);
-  for (int iw = 0; iw < P_list.size(); iw++)
-    WF_list[iw]->LogValue += dn_list[iw]->LogValue;
+  fill_up_list(WF_list, scratch.WFC_list);
+  Det_up->multi_evaluateGL(scratch.WFC_list, P_list, scratch.G_list, scratch.L_list, false, serial);
+  for (int iw = 0; iw < nw; iw++)
+    WF_list[iw]->LogValue = scratch.WFC_list[iw]->LogValue;
+  fill_dn_list(WF_list, scratch.WFC_list);
+  Det_dn->multi_evaluateGL(scratch.WFC_list, P_list, scratch.G_list, scratch.L_list, false, serial);
+  for (int iw = 0; iw < nw; iw++)
+    WF_list[iw]->LogValue += scratch.WFC_list[iw]->LogValue;
   // Jastrow factors
   for (size_t i = 0; i < Jastrows.size(); i++)
   {
-    std::vector<WaveFunctionComponent*> jas_list(extract_jas_list(WF_list, i));
-    Jastrows[i]->multi_evaluateGL(jas_list, P_list, G_list, L_list);
-    for (int iw = 0; iw < P_list.size(); iw++)
-      WF_list[iw]->LogValue += jas_list[iw]->LogValue;
+    fill_jas_list(WF_list, i, scratch.WFC_list);
+    Jastrows[i]->multi_evaluateGL(scratch.WFC_list, P_list, scratch.G_list, scratch.L_list,
+                                  false, serial);
+    for (int iw = 0; iw < nw; iw++)
+      WF_list[iw]->LogValue += scratch.WFC_list[iw]->LogValue;
   }
 }
 
+void WaveFunction::fill_up_list(const std::vector<WaveFunction*>& WF_list,
+                                std::vector<WaveFunctionComponent*>& WFC_list)
+{
+  WFC_list.resize(WF_list.size());
+  for (int iw = 0; iw < WF_list.size(); iw++)
+    WFC_list[iw] = WF_list[iw]->Det_up;
+}
+
+void WaveFunction::fill_dn_list(const std::vector<WaveFunction*>& WF_list,
+                                std::vector<WaveFunctionComponent*>& WFC_list)
+{
+  WFC_list.resize(WF_list.size());
+  for (int iw = 0; iw < WF_list.size(); iw++)
+    WFC_list[iw] = WF_list[iw]->Det_dn;
+}
+
+void WaveFunction::fill_jas_list(const std::vector<WaveFunction*>& WF_list,
+                                 int jas_id,
+                                 std::vector<WaveFunctionComponent*>& WFC_list)
+{
+  WFC_list.resize(WF_list.size());
+  for (int iw = 0; iw < WF_list.size(); iw++)
+    WFC_list[iw] = WF_list[iw]->Jastrows[jas_id];
+}
+
 const std::vector<WaveFunctionComponent*> extract_up_list(const std::vector<WaveFunction*>& WF_list)
 {
   std::vector<WaveFunctionComponent*> up_list;
@@ -30,6 +30,26 @@
 
 namespace qmcplusplus
 {
+/** lists and temporaries of the multi_ functions of WaveFunction
+ *
+ * Owned by the caller and refilled by each call, so the calls do not
+ * allocate once the vectors have grown to the size of the crowd.
+ */
+struct MultiWaveFunctionScratch
+{
+  using valT = OHMMS_PRECISION;
+  using posT = TinyVector<valT, OHMMS_DIM>;
+
+  /// the component being evaluated, one per walker
+  std::vector<WaveFunctionComponent*> WFC_list;
+  std::vector<ParticleSet::ParticleGradient_t*> G_list;
+  std::vector<ParticleSet::ParticleLaplacian_t*> L_list;
+  /// values, gradients and ratios of the component being evaluated
+  ParticleSet::ParticleValue_t values;
+  std::vector<posT> grads;
+  std::vector<valT> ratios;
+};
+
 /** A minimal TrialWavefunction
  */
 
@@ -51,6 +71,16 @@ private:
   TimerList_t timers;
   TimerList_t jastrow_timers;
 
+  /**@{ fill WFC_list with a component of each walker of WF_list, reusing its storage */
+  static void fill_up_list(const std::vector<WaveFunction*>& WF_list,
+                           std::vector<WaveFunctionComponent*>& WFC_list);
+  static void fill_dn_list(const std::vector<WaveFunction*>& WF_list,
+                           std::vector<WaveFunctionComponent*>& WFC_list);
+  static void fill_jas_list(const std::vector<WaveFunction*>& WF_list,
+                            int jas_id,
+                            std::vector<WaveFunctionComponent*>& WFC_list);
+  /**@}*/
+
 public:
   WaveFunction()
       : FirstTime(true),
@@ -68,29 +98,70 @@ public:
   posT evalGrad(ParticleSet& P, int iat);
   valT ratioGrad(ParticleSet& P, int iat, posT& grad);
   valT ratio(ParticleSet& P, int iat);
+  /** ratio of the determinants of a move of iat from the orbitals psi at the new position
+   *
+   * The state is not changed and no timer is used, so that the ratios of the
+   * moves of a walker may be evaluated concurrently.
+   */
+  valT ratioFromOrbitals(int iat, const valT* psi) const;
+  /// ratio of the Jastrow factors of the proposed move of iat
+  valT ratioJastrow(ParticleSet& P, int iat);
   void acceptMove(ParticleSet& P, int iat);
   void restore(int iat);
   void evaluateGL(ParticleSet& P);
-
-  /// operates on multiple walkers
+  /** follow the reordered particles of P and recompute from scratch
+   * @param P target ParticleSet, already reordered and updated
+   * @param new2old new2old[i] is the old index of the particle at the new index i
+   */
+  void reorderParticles(ParticleSet& P, const std::vector<int>& new2old);
+
+  /** add the state of the components to the buffer of a walker
+   * @param P target ParticleSet, holding the walker
+   * @param buf buffer of the walker, at its cursor
+   */
+  void registerData(ParticleSet& P, WaveFunctionComponent::BufferType& buf);
+  /// copy the state of the components to buf at its cursor, laid out by registerData
+  void copyToBuffer(ParticleSet& P, WaveFunctionComponent::BufferType& buf);
+  /** restore the state of the components from buf, without recomputation
+   * @param P target ParticleSet, loaded with the walker and its distance tables
+   * @param buf buffer of the walker, at its cursor
+   */
+  void copyFromBuffer(ParticleSet& P, WaveFunctionComponent::BufferType& buf);
+
+  /** operates on multiple walkers
+   *
+   * The lists and temporaries of the components are kept in scratch. If
+   * serial, the calling thread evaluates all the walkers without a parallel
+   * region.
+   */
   void multi_evaluateLog(const std::vector<WaveFunction*>& WF_list,
-                         const std::vector<ParticleSet*>& P_list) const;
+                         const std::vector<ParticleSet*>& P_list,
+                         MultiWaveFunctionScratch& scratch,
+                         bool serial = false) const;
   void multi_evalGrad(const std::vector<WaveFunction*>& WF_list,
                       const std::vector<ParticleSet*>& P_list,
                       int iat,
-                      std::vector<posT>& grad_now) const;
+                      std::vector<posT>& grad_now,
+                      MultiWaveFunctionScratch& scratch,
+                      bool serial = false) const;
   void multi_ratioGrad(const std::vector<WaveFunction*>& WF_list,
                        const std::vector<ParticleSet*>& P_list,
                        int iat,
                        std::vector<valT>& ratio_list,
-                       std::vector<posT>& grad_new) const;
+                       std::vector<posT>& grad_new,
+                       MultiWaveFunctionScratch& scratch,
+                       bool serial = false) const;
   void multi_ratio(const std::vector<ParticleSet*>& P_list, int iat) const {};
   void multi_acceptrestoreMove(const std::vector<WaveFunction*>& WF_list,
                                const std::vector<ParticleSet*>& P_list,
                                const std::vector<bool>& isAccepted,
-                               int iat) const;
+                               int iat,
+                               MultiWaveFunctionScratch& scratch,
+                               bool serial = false) const;
   void multi_evaluateGL(const std::vector<WaveFunction*>& WF_list,
-                        const std::vector<ParticleSet*>& P_list) const;
+                        const std::vector<ParticleSet*>& P_list,
+                        MultiWaveFunctionScratch& scratch,
+                        bool serial = false) const;
 
   // others
   int get_ei_TableID() const { return ei_TableID; }
@@ -103,7 +174,8 @@ public:
                                  ParticleSet& ions,
                                  ParticleSet& els,
                                  const RandomGenerator<QMCTraits::RealType>& RNG,
-                                 bool enableJ3);
+                                 bool enableJ3,
+                                 bool fuseJastrows);
   friend const std::vector<WaveFunctionComponent*>
       extract_up_list(const std::vector<WaveFunction*>& WF_list);
   friend const std::vector<WaveFunctionComponent*>
@@ -117,7 +189,8 @@ void build_WaveFunction(bool useRef,
                         ParticleSet& ions,
                         ParticleSet& els,
                         const RandomGenerator<QMCTraits::RealType>& RNG,
-                        bool enableJ3);
+                        bool enableJ3,
+                        bool fuseJastrows = false);
 
 const std::vector<WaveFunctionComponent*> extract_up_list(const std::vector<WaveFunction*>& WF_list);
 const std::vector<WaveFunctionComponent*> extract_dn_list(const std::vector<WaveFunction*>& WF_list);
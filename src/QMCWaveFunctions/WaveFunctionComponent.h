@@ -28,6 +28,7 @@
 #include "Utilities/Configuration.h"
 #include "Particle/ParticleSet.h"
 #include "Particle/DistanceTableData.h"
+#include "Utilities/CrowdThreads.h"
 
 /**@file WaveFunctionComponent.h
  *@brief Declaration of WaveFunctionComponent
@@ -157,6 +158,19 @@ struct WaveFunctionComponent : public QMCTraits
    */
   virtual ValueType ratio(ParticleSet& P, int iat) = 0;
 
+  /** evaluate the ratio of a move from the orbitals at the new position
+   * @param iat the index of a particle
+   * @param psi the orbitals at the new position of iat
+   *
+   * Only the components built on orbitals implement it. The state is not
+   * changed, so that the ratios of several moves may be evaluated at once.
+   */
+  virtual ValueType ratioFromOrbitals(int iat, const ValueType* psi) const
+  {
+    APP_ABORT("WaveFunctionComponent::ratioFromOrbitals is not implemented");
+    return ValueType(1);
+  }
+
   /** compute G and L after the sweep
    * @param P active ParticleSet
    * @param G Gradients, \f$\nabla\ln\Psi\f$
@@ -169,22 +183,58 @@ struct WaveFunctionComponent : public QMCTraits
                           ParticleSet::ParticleLaplacian_t& L,
                           bool fromscratch = false) = 0;
 
-  /// operates on multiple walkers
+  /** the particles were reordered
+   * @param new2old new2old[i] is the old index of the particle at the new index i
+   *
+   * Only the components with a state not derived from the positions, which
+   * evaluateLog recomputes, need to follow the particles.
+   */
+  virtual void reorderParticles(const std::vector<int>& new2old) {}
+
+  /**@{ walker buffer
+   *
+   * The state of a component for a walker, in the layout set by registerData.
+   * The whole state used by the moves and evaluateGL must be kept, so that a
+   * walker is restored without any recomputation. Only registerData may grow
+   * the buffer.
+   */
+  /** add the current state to buf
+   * @param P target ParticleSet
+   * @param buf buffer of the walker
+   */
+  virtual void registerData(ParticleSet& P, BufferType& buf) {}
+
+  /// copy the current state to buf, at its cursor
+  virtual void copyToBuffer(ParticleSet& P, BufferType& buf) {}
+
+  /// restore the state from buf, at its cursor
+  virtual void copyFromBuffer(ParticleSet& P, BufferType& buf) {}
+  /**@}*/
+
+  /**@{ operates on multiple walkers
+   *
+   * The components of WFC_list are of the type of this, which keeps the
+   * scratch of the crowd. If serial, the calling thread evaluates all the
+   * walkers without a parallel region, otherwise the walkers are split over
+   * the threads.
+   */
   virtual void multi_evaluateLog(const std::vector<WaveFunctionComponent*>& WFC_list,
                                  const std::vector<ParticleSet*>& P_list,
                                  const std::vector<ParticleSet::ParticleGradient_t*>& G_list,
                                  const std::vector<ParticleSet::ParticleLaplacian_t*>& L_list,
-                                 ParticleSet::ParticleValue_t& values)
+                                 ParticleSet::ParticleValue_t& values,
+                                 bool serial = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < P_list.size(); iw++)
+    crowd_for(serial, P_list.size(), [&](int iw) {
       values[iw] = WFC_list[iw]->evaluateLog(*P_list[iw], *G_list[iw], *L_list[iw]);
+    });
   };
 
   virtual void multi_evalGrad(const std::vector<WaveFunctionComponent*>& WFC_list,
                               const std::vector<ParticleSet*>& P_list,
                               int iat,
-                              std::vector<PosType>& grad_now)
+                              std::vector<PosType>& grad_now,
+                              bool serial = false)
   {
     //#pragma omp parallel for
     for (int iw = 0; iw < P_list.size(); iw++)
@@ -195,30 +245,31 @@ struct WaveFunctionComponent : public QMCTraits
                                const std::vector<ParticleSet*>& P_list,
                                int iat,
                                std::vector<ValueType>& ratios,
-                               std::vector<PosType>& grad_new)
+                               std::vector<PosType>& grad_new,
+                               bool serial = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < P_list.size(); iw++)
+    crowd_for(serial, P_list.size(), [&](int iw) {
       ratios[iw] = WFC_list[iw]->ratioGrad(*P_list[iw], iat, grad_new[iw]);
+    });
   };
 
   virtual void multi_acceptrestoreMove(const std::vector<WaveFunctionComponent*>& WFC_list,
                                        const std::vector<ParticleSet*>& P_list,
                                        const std::vector<bool>& isAccepted,
-                                       int iat)
+                                       int iat,
+                                       bool serial = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < P_list.size(); iw++)
-    {
+    crowd_for(serial, P_list.size(), [&](int iw) {
       if (isAccepted[iw])
         WFC_list[iw]->acceptMove(*P_list[iw], iat);
-    }
+    });
   };
 
   virtual void multi_ratio(const std::vector<WaveFunctionComponent*>& WFC_list,
                            const std::vector<ParticleSet*>& P_list,
                            int iat,
-                           ParticleSet::ParticleValue_t& ratio_list){
+                           ParticleSet::ParticleValue_t& ratio_list,
+                           bool serial = false){
       // TODO
   };
 
@@ -226,12 +277,14 @@ struct WaveFunctionComponent : public QMCTraits
                                 const std::vector<ParticleSet*>& P_list,
                                 const std::vector<ParticleSet::ParticleGradient_t*>& G_list,
                                 const std::vector<ParticleSet::ParticleLaplacian_t*>& L_list,
-                                bool fromscratch = false)
+                                bool fromscratch = false,
+                                bool serial      = false)
   {
-    #pragma omp parallel for
-    for (int iw = 0; iw < P_list.size(); iw++)
+    crowd_for(serial, P_list.size(), [&](int iw) {
       WFC_list[iw]->evaluateGL(*P_list[iw], *G_list[iw], *L_list[iw], fromscratch);
+    });
   };
+  /**@}*/
 };
 } // namespace qmcplusplus
 #endif
@@ -27,6 +27,7 @@
 #include <Utilities/SIMD/allocator.hpp>
 #include "Numerics/OhmmsPETE/OhmmsArray.h"
 #include "QMCWaveFunctions/SPOSet.h"
+#include <algorithm>
 #include <iostream>
 
 namespace miniqmcreference
@@ -123,6 +124,7 @@ struct einspline_spo_ref : public SPOSet
       grad[i].resize(nSplinesPerBlock);
       hess[i].resize(nSplinesPerBlock);
     }
+    setOrbitalSetSize(nBlocks * nSplinesPerBlock);
   }
 
   // fix for general num_splines
@@ -170,6 +172,46 @@ struct einspline_spo_ref : public SPOSet
       compute_engine.evaluate_v(einsplines[i], u[0], u[1], u[2], psi[i].data(), nSplinesPerBlock);
   }
 
+  /** evaluate psi at a batch of positions
+   *
+   * The positions are evaluated block by block, so the coefficients of a
+   * block are reused by the whole batch.
+   */
+  inline void evaluate_v_batch(const PosType* pos, int n, ValueType* values) const
+  {
+    ScopedTimer local_timer(timer);
+
+    const int norb = size();
+    for (int i = 0; i < nBlocks; ++i)
+      for (int ip = 0; ip < n; ++ip)
+      {
+        auto u = Lattice.toUnit_floor(pos[ip]);
+        compute_engine.evaluate_v(einsplines[i],
+                                  u[0],
+                                  u[1],
+                                  u[2],
+                                  values + ip * norb + i * nSplinesPerBlock,
+                                  nSplinesPerBlock);
+      }
+  }
+
+  /** index of the grid cell of p, in the order of the spline coefficients
+   *
+   * The orbitals at the positions of a cell use the same coefficients.
+   */
+  inline int cellIndex(const PosType& p) const
+  {
+    const spline_type& s = *einsplines[0];
+    const auto u         = Lattice.toUnit_floor(p);
+    const int ix =
+        std::min(static_cast<int>((u[0] - s.x_grid.start) * s.x_grid.delta_inv), s.x_grid.num - 1);
+    const int iy =
+        std::min(static_cast<int>((u[1] - s.y_grid.start) * s.y_grid.delta_inv), s.y_grid.num - 1);
+    const int iz =
+        std::min(static_cast<int>((u[2] - s.z_grid.start) * s.z_grid.delta_inv), s.z_grid.num - 1);
+    return (ix * s.y_grid.num + iy) * s.z_grid.num + iz;
+  }
+
   /** evaluate psi */
   inline void evaluate_v_pfor(const PosType& p)
   {
@@ -44,6 +44,12 @@ typedef int omp_int_t;
 inline omp_int_t omp_get_thread_num() { return 0; }
 inline omp_int_t omp_get_max_threads() { return 1; }
 inline omp_int_t omp_get_num_threads() { return 1; }
+inline omp_int_t omp_get_active_level() { return 0; }
+inline omp_int_t omp_get_level() { return 0; }
+inline omp_int_t omp_get_ancestor_thread_num(omp_int_t) { return 0; }
+inline omp_int_t omp_get_max_active_levels() { return 1; }
+inline void omp_set_max_active_levels(omp_int_t) {}
+inline void omp_set_num_threads(omp_int_t) {}
 #endif
 
 // define empty DEBUG_MEMORY
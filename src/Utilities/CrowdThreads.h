@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file CrowdThreads.h
+ * @brief helpers to split the walkers of a crowd over the threads
+ *
+ * The multi_ functions serve a crowd either by all the threads, each taking
+ * a share of the walkers, or serially by the calling thread, when the driver
+ * gives each thread a crowd of its own. A serial crowd opens no parallel
+ * region.
+ */
+#ifndef QMCPLUSPLUS_CROWD_THREADS_H
+#define QMCPLUSPLUS_CROWD_THREADS_H
+#include "Utilities/Configuration.h"
+
+namespace qmcplusplus
+{
+/// number of the threads serving a crowd, sizing their scratch
+inline int getCrowdThreads(bool serial) { return serial ? 1 : omp_get_max_threads(); }
+
+/** call f(iw) for each of the nw walkers of a crowd
+ * @param serial if true, the calling thread takes all the walkers
+ */
+template<typename F>
+inline void crowd_for(bool serial, int nw, const F& f)
+{
+  if (serial)
+  {
+    for (int iw = 0; iw < nw; iw++)
+      f(iw);
+    return;
+  }
+#pragma omp parallel for
+  for (int iw = 0; iw < nw; iw++)
+    f(iw);
+}
+
+/** call f(np, ip) on each member ip of the np threads serving a crowd
+ * @param serial if true, the calling thread is the only member
+ */
+template<typename F>
+inline void crowd_parallel(bool serial, const F& f)
+{
+  if (serial)
+  {
+    f(1, 0);
+    return;
+  }
+#pragma omp parallel
+  f(omp_get_num_threads(), omp_get_thread_num());
+}
+} // namespace qmcplusplus
+#endif
@@ -133,6 +133,19 @@ class Communicate;
 
 namespace qmcplusplus
 {
+/** true on the thread timing under stack timers
+ *
+ * The master thread of the outermost team. Unlike the omp master construct,
+ * this excludes the master threads of the teams nested in the other threads.
+ */
+inline bool is_timing_thread()
+{
+  for (int level = omp_get_level(); level > 0; --level)
+    if (omp_get_ancestor_thread_num(level) != 0)
+      return false;
+  return true;
+}
+
 class NewTimer;
 
 enum timer_levels
@@ -360,7 +373,7 @@ public:
 #endif
 
 #ifdef USE_STACK_TIMERS
-      #pragma omp master
+      if (is_timing_thread())
       {
         if (manager)
         {
@@ -402,7 +415,7 @@ public:
 #endif
 
 #ifdef USE_STACK_TIMERS
-#pragma omp master
+      if (is_timing_thread())
 #endif
       {
         double elapsed = cpu_clock() - start_time;
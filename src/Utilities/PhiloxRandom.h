@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file PhiloxRandom.h
+ * @brief Counter-based random number generator Philox4x32-10
+ *
+ * Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11.
+ * A block of four 32-bit numbers is a pure function of a 64-bit key and a
+ * 128-bit counter, so a stream needs no state beyond the two and the blocks
+ * of a bulk request are computed independently.
+ */
+#ifndef QMCPLUSPLUS_PHILOX_RANDOM_H
+#define QMCPLUSPLUS_PHILOX_RANDOM_H
+
+#include <algorithm>
+#include "Utilities/Configuration.h"
+
+/// conversion of the 32-bit words of a Philox block to reals in [0,1)
+template<typename T>
+struct PhiloxUniform;
+
+template<>
+struct PhiloxUniform<float>
+{
+  /// one real per word, of 24 random bits
+  static const int perBlock = 4;
+  static inline void convert(const uint32_t* x, float* restrict d)
+  {
+    for (int q = 0; q < 4; ++q)
+      d[q] = (x[q] >> 8) * (1.0f / 16777216.0f);
+  }
+};
+
+template<>
+struct PhiloxUniform<double>
+{
+  /// one real per pair of words, of 53 random bits
+  static const int perBlock = 2;
+  static inline void convert(const uint32_t* x, double* restrict d)
+  {
+    for (int q = 0; q < 2; ++q)
+      d[q] = ((static_cast<uint64_t>(x[2 * q]) << 21) ^ (x[2 * q + 1] >> 11)) *
+          (1.0 / 9007199254740992.0);
+  }
+};
+
+/** Philox4x32-10 with the interface of StdRandom
+ * @tparam T real type of the results
+ *
+ * The key holds the seed and a stream, e.g. a walker ID. The counter holds
+ * a 64-bit block index and two user words, e.g. a step and a substep, set
+ * by setCounter. Draws after a setCounter depend only on (seed, stream,
+ * step, substep) and their position, not on the thread or the history.
+ */
+template<typename T>
+struct PhiloxRandom
+{
+  /// real result type
+  typedef T result_type;
+  /// unsigned integer type
+  typedef uint32_t uint_type;
+  /// conversion of the blocks to reals
+  typedef PhiloxUniform<T> uniform_type;
+
+  /// number of blocks computed together by the bulk generators
+  static const int blockChunk = 64;
+
+  /// number of contexts
+  int nContexts;
+  /// context number
+  int myContext;
+  /// offset of the random seed
+  int baseOffset;
+  /// seed and stream
+  uint32_t key[2];
+  /// user words of the counter
+  uint32_t userCounter[2];
+  /// index of the next block
+  uint64_t blockIndex;
+  /// reals of the last block not returned yet
+  T buffer[uniform_type::perBlock];
+  /// number of the buffered reals
+  int nBuffered;
+
+  PhiloxRandom() : nContexts(1), myContext(0), baseOffset(0)
+  {
+    setKey(MakeSeed(omp_get_thread_num(), omp_get_num_threads()), 0);
+  }
+
+  explicit PhiloxRandom(uint_type iseed, uint_type stream = 0)
+      : nContexts(1), myContext(0), baseOffset(0)
+  {
+    if (iseed == 0)
+      iseed = MakeSeed(0, 1);
+    setKey(iseed, stream);
+  }
+
+  /** initialize the stream i of nstr */
+  inline void init(int i, int nstr, int iseed_in, uint_type offset = 1)
+  {
+    uint_type baseSeed = iseed_in;
+    myContext          = i;
+    nContexts          = nstr;
+    if (iseed_in <= 0)
+      baseSeed = MakeSeed(i, nstr);
+    baseOffset = offset;
+    setKey(baseSeed, i);
+  }
+
+  /// copy the state
+  inline void reset(const PhiloxRandom& rng) { *this = rng; }
+
+  /// get baseOffset
+  inline int offset() const { return baseOffset; }
+  /// assign baseOffset
+  inline int& offset() { return baseOffset; }
+
+  /// assign seed, keeping the stream
+  inline void seed(uint_type aseed) { setKey(aseed, key[1]); }
+
+  /// select the stream, restarting it at the counter (0,0)
+  inline void setStream(uint_type stream) { setKey(key[0], stream); }
+
+  /** restart the stream at a counter
+   * @param step first user word, e.g. the index of the step
+   * @param sub second user word, e.g. the index of the substep
+   */
+  inline void setCounter(uint_type step, uint_type sub)
+  {
+    userCounter[0] = step;
+    userCounter[1] = sub;
+    blockIndex     = 0;
+    nBuffered      = 0;
+  }
+
+  /** return a random number [0,1)
+  */
+  inline result_type rand()
+  {
+    if (nBuffered == 0)
+      fillBuffer();
+    return buffer[uniform_type::perBlock - nBuffered--];
+  }
+  /** return a random number [0,1)
+  */
+  inline result_type operator()() { return rand(); }
+
+  /** generate a series of random numbers
+   *
+   * Same numbers as n calls of rand, with the whole blocks computed
+   * blockChunk at a time by a vectorizable loop.
+   */
+  inline void generate_uniform(T* restrict d, int n)
+  {
+    int i = 0;
+    for (; i < n && nBuffered > 0; ++i)
+      d[i] = buffer[uniform_type::perBlock - nBuffered--];
+
+    const int nblocks = (n - i) / uniform_type::perBlock;
+    generateBlocks(d + i, nblocks);
+    i += nblocks * uniform_type::perBlock;
+
+    for (; i < n; ++i)
+      d[i] = rand();
+  }
+
+  inline void generate_normal(T* restrict d, int n) { BoxMuller2::generate(*this, d, n); }
+
+  /** return a random integer
+  */
+  inline uint32_t irand()
+  {
+    uint32_t x[4];
+    philox(blockIndex++, x);
+    return x[0];
+  }
+
+  /** compute the block of the counter (b, userCounter)
+   * @param b block index, the low words of the counter
+   * @param x the four words of the block
+   */
+  inline void philox(uint64_t b, uint32_t* x) const
+  {
+    uint32_t c0 = static_cast<uint32_t>(b), c1 = static_cast<uint32_t>(b >> 32);
+    uint32_t c2 = userCounter[0], c3 = userCounter[1];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; ++r)
+    {
+      const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+      c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c1 = static_cast<uint32_t>(p1);
+      c3 = static_cast<uint32_t>(p0);
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    x[0] = c0;
+    x[1] = c1;
+    x[2] = c2;
+    x[3] = c3;
+  }
+
+private:
+  inline void setKey(uint_type aseed, uint_type stream)
+  {
+    key[0] = aseed;
+    key[1] = stream;
+    setCounter(0, 0);
+  }
+
+  inline void fillBuffer()
+  {
+    uint32_t x[4];
+    philox(blockIndex++, x);
+    uniform_type::convert(x, buffer);
+    nBuffered = uniform_type::perBlock;
+  }
+
+  /** store the reals of the next nblocks blocks in d
+   *
+   * The rounds of philox run over blockChunk counters at a time, so that
+   * each round is a vectorizable loop.
+   */
+  inline void generateBlocks(T* restrict d, int nblocks)
+  {
+    uint32_t c0[blockChunk], c1[blockChunk], c2[blockChunk], c3[blockChunk];
+    for (int b0 = 0; b0 < nblocks; b0 += blockChunk)
+    {
+      const int m       = std::min(static_cast<int>(blockChunk), nblocks - b0);
+      const uint64_t b  = blockIndex + b0;
+      const uint32_t u0 = userCounter[0], u1 = userCounter[1];
+      for (int j = 0; j < m; ++j)
+      {
+        c0[j] = static_cast<uint32_t>(b + j);
+        c1[j] = static_cast<uint32_t>((b + j) >> 32);
+        c2[j] = u0;
+        c3[j] = u1;
+      }
+      uint32_t k0 = key[0], k1 = key[1];
+      for (int r = 0; r < 10; ++r)
+      {
+#pragma omp simd
+        for (int j = 0; j < m; ++j)
+        {
+          const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0[j];
+          const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2[j];
+          c0[j]             = static_cast<uint32_t>(p1 >> 32) ^ c1[j] ^ k0;
+          c2[j]             = static_cast<uint32_t>(p0 >> 32) ^ c3[j] ^ k1;
+          c1[j]             = static_cast<uint32_t>(p1);
+          c3[j]             = static_cast<uint32_t>(p0);
+        }
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+      }
+      for (int j = 0; j < m; ++j)
+      {
+        const uint32_t x[4] = {c0[j], c1[j], c2[j], c3[j]};
+        uniform_type::convert(x, d + (b0 + j) * uniform_type::perBlock);
+      }
+    }
+    blockIndex += nblocks;
+  }
+};
+#endif
@@ -23,7 +23,8 @@
  * @brief Declare a global Random Number Generator
  *
  * Selected among
- * - C++11 std::random
+ * - Philox4x32-10, a counter-based generator (default)
+ * - C++11 std::random, with USE_STD_RANDOM
  * - (other choices are in the QMCPACK distribution)
  *
  * qmcplusplus::Random() returns a random number [0,1)
@@ -38,44 +39,95 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <algorithm>
 #include <cmath>
 #include <ctime>
+#ifdef HAVE_MKL_VML
+#include <mkl_vml_functions.h>
+#endif
 
 #include <stdint.h>
 
+/** Box-Muller transform of uniforms [0,1) into normals
+ *
+ * The bulk generator draws the uniforms of all the pairs with the
+ * generate_uniform of the engine and transforms them in place, pairChunk
+ * pairs at a time, with the vector math of MKL VML if available and
+ * otherwise with simd loops, mapped to the vector libm by the compiler.
+ */
 struct BoxMuller2
 {
-  template<typename RNG>
-  static inline void generate(RNG& rng, double* restrict a, int n)
+  /// number of pairs transformed together
+  static const int pairChunk = 64;
+
+  /** transform the n uniforms of a into normals, n even
+   *
+   * The pair (a[2i], a[2i+1]) is replaced by its two normals.
+   */
+  template<typename T>
+  static inline void transform(T* restrict a, int n)
   {
-    for (int i = 0; i + 1 < n; i += 2)
-    {
-      double temp1 = 1.0 - 0.9999999999 * rng(), temp2 = rng();
-      a[i]     = sqrt(-2.0 * log(temp1)) * cos(6.283185306 * temp2);
-      a[i + 1] = sqrt(-2.0 * log(temp1)) * sin(6.283185306 * temp2);
-    }
-    if (n % 2 == 1)
+    const int npairs = n / 2;
+    T logr[pairChunk], theta[pairChunk], c[pairChunk], s[pairChunk];
+    for (int p0 = 0; p0 < npairs; p0 += pairChunk)
     {
-      double temp1 = 1 - 0.9999999999 * rng(), temp2 = rng();
-      a[n - 1] = sqrt(-2.0 * log(temp1)) * cos(6.283185306 * temp2);
+      const int m      = std::min(static_cast<int>(pairChunk), npairs - p0);
+      T* restrict pair = a + 2 * p0;
+      for (int j = 0; j < m; ++j)
+      {
+        logr[j]  = T(1) - T(0.9999999999) * pair[2 * j];
+        theta[j] = T(6.283185306) * pair[2 * j + 1];
+      }
+#ifdef HAVE_MKL_VML
+      vmlLn(m, logr, logr);
+      vmlSinCos(m, theta, s, c);
+#else
+      // separate loops, a cos and a sin of the same loop become a sincos,
+      // which the vector libm does not provide
+#pragma omp simd
+      for (int j = 0; j < m; ++j)
+        logr[j] = std::log(logr[j]);
+#pragma omp simd
+      for (int j = 0; j < m; ++j)
+        c[j] = std::cos(theta[j]);
+#pragma omp simd
+      for (int j = 0; j < m; ++j)
+        s[j] = std::sin(theta[j]);
+#endif
+      for (int j = 0; j < m; ++j)
+      {
+        const T r       = std::sqrt(T(-2) * logr[j]);
+        pair[2 * j]     = r * c[j];
+        pair[2 * j + 1] = r * s[j];
+      }
     }
   }
 
-  template<typename RNG>
-  static inline void generate(RNG& rng, float* restrict a, int n)
+  /** generate n normals
+   *
+   * Same numbers as drawing the two uniforms of each pair with rng() and
+   * transforming them one pair at a time, up to the rounding of the math.
+   */
+  template<typename RNG, typename T>
+  static inline void generate(RNG& rng, T* restrict a, int n)
   {
-    for (int i = 0; i + 1 < n; i += 2)
-    {
-      float temp1 = 1.0f - 0.9999999999f * rng(), temp2 = rng();
-      a[i]     = sqrtf(-2.0f * logf(temp1)) * cosf(6.283185306f * temp2);
-      a[i + 1] = sqrtf(-2.0f * logf(temp1)) * sinf(6.283185306f * temp2);
-    }
+    const int neven = n - n % 2;
+    rng.generate_uniform(a, neven);
+    transform(a, neven);
     if (n % 2 == 1)
     {
-      float temp1 = 1.0f - 0.9999999999f * rng(), temp2 = rng();
-      a[n - 1] = sqrtf(-2.0f * logf(temp1)) * cosf(6.283185306f * temp2);
+      T temp1 = T(1) - T(0.9999999999) * rng(), temp2 = rng();
+      a[n - 1] = std::sqrt(T(-2) * std::log(temp1)) * std::cos(T(6.283185306) * temp2);
     }
   }
+
+private:
+#ifdef HAVE_MKL_VML
+  static inline void vmlLn(int n, const double* x, double* y) { vdLn(n, x, y); }
+  static inline void vmlLn(int n, const float* x, float* y) { vsLn(n, x, y); }
+  static inline void vmlSinCos(int n, const double* x, double* s, double* c) { vdSinCos(n, x, s, c); }
+  static inline void vmlSinCos(int n, const float* x, float* s, float* c) { vsSinCos(n, x, s, c); }
+#endif
 };
 
 inline uint32_t MakeSeed(int i, int n)
@@ -84,11 +136,44 @@ inline uint32_t MakeSeed(int i, int n)
   return static_cast<uint32_t>(std::time(nullptr)) % u + (i + 1) * n + i;
 }
 
+/** first word of the counters of the draws made before the first step
+ *
+ * The steps of a driver draw at setCounter(step, substep). The generators
+ * of a walker and their copies draw their initial numbers at
+ * setCounter(RandomInitStep, RandomInitCounter), past any step and apart
+ * from each other.
+ */
+const uint32_t RandomInitStep = 0xFFFFFFFFu;
+
+/// second words of the counters of the draws made before the first step
+enum RandomInitCounter : uint32_t
+{
+  RandomInitElectrons   = 0, ///< positions of the electrons
+  RandomInitNLPP        = 1, ///< rotations of the quadrature of the NLPP
+  RandomInitDeterminant = 2  ///< matrices of the determinants, plus their first index
+};
+
+/** second word of the counter of the NLPP rotations of a step
+ *
+ * The rotations of the step of a walker are drawn at
+ * setCounter(step, RandomStepNLPP), past any substep of the drift-and-diffusion.
+ */
+const uint32_t RandomStepNLPP = 0xFFFFFFFFu;
+
+#ifdef USE_STD_RANDOM
 #include "Utilities/StdRandom.h"
 namespace qmcplusplus
 {
 template<class T>
 using RandomGenerator = StdRandom<T>;
 }
+#else
+#include "Utilities/PhiloxRandom.h"
+namespace qmcplusplus
+{
+template<class T>
+using RandomGenerator = PhiloxRandom<T>;
+}
+#endif
 
 #endif
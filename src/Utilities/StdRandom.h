@@ -35,6 +35,8 @@ struct StdRandom
   int myContext;
   /// offset of the random seed
   int baseOffset;
+  /// seed and stream of setStream and setCounter
+  uint_type mySeed, myStream;
   /// random number generator
   RNG myRNG;
   /// uniform generator
@@ -42,19 +44,25 @@ struct StdRandom
   /// normal generator
   normal_distribution_type normal;
 
-  StdRandom() : nContexts(1), myContext(0), baseOffset(0), uniform(T(0), T(1)), normal(T(0), T(1))
+  StdRandom()
+      : nContexts(1), myContext(0), baseOffset(0), myStream(0), uniform(T(0), T(1)), normal(T(0), T(1))
   {
-    myRNG.seed(MakeSeed(omp_get_thread_num(), omp_get_num_threads()));
+    mySeed = MakeSeed(omp_get_thread_num(), omp_get_num_threads());
+    myRNG.seed(mySeed);
   }
 
-  explicit StdRandom(uint_type iseed) : nContexts(1), myContext(0), baseOffset(0)
+  explicit StdRandom(uint_type iseed) : nContexts(1), myContext(0), baseOffset(0), myStream(0)
   //, uniform(T(0),T(1)), normal(T(0),T(1))
   {
     if (iseed == 0)
       iseed = MakeSeed(0, 1);
+    mySeed = iseed;
     myRNG.seed(iseed);
   }
 
+  /// start the stream of a seed, as setStream
+  StdRandom(uint_type iseed, uint_type stream) : StdRandom(iseed) { setStream(stream); }
+
   /** copy constructor
    */
   template<typename T1>
@@ -62,6 +70,8 @@ struct StdRandom
       : nContexts(1),
         myContext(0),
         baseOffset(0),
+        mySeed(rng.mySeed),
+        myStream(rng.myStream),
         myRNG(rng.myRNG),
         uniform(T(0), T(1)),
         normal(T(0), T(1))
@@ -76,6 +86,8 @@ struct StdRandom
     if (iseed_in <= 0)
       baseSeed = MakeSeed(i, nstr);
     baseOffset = offset;
+    mySeed     = baseSeed;
+    myStream   = i;
     myRNG.seed(baseSeed);
   }
 
@@ -91,7 +103,30 @@ struct StdRandom
   inline int& offset() { return baseOffset; }
 
   /// assign seed
-  inline void seed(uint_type aseed) { myRNG.seed(aseed); }
+  inline void seed(uint_type aseed)
+  {
+    mySeed = aseed;
+    myRNG.seed(aseed);
+  }
+
+  /** select the stream of the seed
+   *
+   * The state is reseeded from (seed, stream), so unlike PhiloxRandom this
+   * costs a full initialization of the generator.
+   */
+  inline void setStream(uint_type stream)
+  {
+    myStream = stream;
+    std::seed_seq seq{mySeed, myStream};
+    myRNG.seed(seq);
+  }
+
+  /// restart the stream from (seed, stream, step, sub), reseeding the state
+  inline void setCounter(uint_type step, uint_type sub)
+  {
+    std::seed_seq seq{mySeed, myStream, step, sub};
+    myRNG.seed(seq);
+  }
 
   /** return a random number [0,1)
   */
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+// This file is distributed under the University of Illinois/NCSA Open Source
+// License.  See LICENSE file in top directory for details.
+//
+// Copyright (c) 2016 Jeongnim Kim and QMCPACK developers.
+//
+// File developed by:
+//
+// File created by:
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file WalkerTeam.h
+ * @brief helpers to split the particle loops of a walker over a thread team
+ *
+ * A walker is served by a team of the size set by the driver on its
+ * ParticleSet, when a nested parallel level is allowed. Otherwise the
+ * calling thread is the only member and the kernels run serially.
+ */
+#ifndef QMCPLUSPLUS_WALKER_TEAM_H
+#define QMCPLUSPLUS_WALKER_TEAM_H
+#include "Utilities/Configuration.h"
+#include <algorithm>
+#include <cmath>
+
+namespace qmcplusplus
+{
+/// smallest chunk of particles handed to a team member
+constexpr int WalkerTeamMinChunk = 256;
+
+/// chunk boundaries are multiples of this, keeping the float, double and int scratch aligned
+constexpr int WalkerTeamGrain = QMC_CLINE / sizeof(int);
+
+/** number of the team members to split n particles over
+ * @param team size of the team serving the walker
+ * @param n number of particles
+ *
+ * Returns 1 when a new parallel region would not be active or when the
+ * chunks would be smaller than WalkerTeamMinChunk.
+ */
+inline int getWalkerTeamSize(int team, int n)
+{
+  if (team <= 1 || omp_get_active_level() >= omp_get_max_active_levels())
+    return 1;
+  return std::max(1, std::min(team, n / WalkerTeamMinChunk));
+}
+
+/** [first,last) of the chunk of n particles owned by the member ip of np
+ *
+ * All but the last chunk end at a multiple of WalkerTeamGrain.
+ */
+inline void getWalkerTeamRange(int n, int ip, int np, int& first, int& last)
+{
+  const int nblocks = (n + WalkerTeamGrain - 1) / WalkerTeamGrain;
+  first             = std::min(n, nblocks * ip / np * WalkerTeamGrain);
+  last              = std::min(n, nblocks * (ip + 1) / np * WalkerTeamGrain);
+}
+
+/** [first,last) of the columns of the strict lower triangle of a n x n matrix
+ * owned by the member ip of np
+ *
+ * The chunks hold about the same number of entries. All but the last chunk
+ * end at a multiple of WalkerTeamGrain.
+ */
+inline void getWalkerTeamTriangleRange(int n, int ip, int np, int& first, int& last)
+{
+  // the columns [0,c) hold the fraction 1-(1-c/n)^2 of the entries
+  const double c0 = n * (1.0 - std::sqrt(1.0 - static_cast<double>(ip) / np));
+  const double c1 = n * (1.0 - std::sqrt(1.0 - static_cast<double>(ip + 1) / np));
+  first           = std::min(n, static_cast<int>(c0 / WalkerTeamGrain + 0.5) * WalkerTeamGrain);
+  last            = std::min(n, static_cast<int>(c1 / WalkerTeamGrain + 0.5) * WalkerTeamGrain);
+  if (ip + 1 == np)
+    last = n;
+}
+} // namespace qmcplusplus
+#endif